@@ -0,0 +1,115 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BeatTrackerBenchmark.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/tempo/BeatTracker.hh>
+#include <a3-motion-engine/util/Timing.hh>
+
+namespace
+{
+
+auto constexpr sampleRate = 48000.;
+auto constexpr tempoBPM = 124.f;
+auto constexpr lengthSeconds = 30.;
+
+// mono click track of decaying noise bursts, one per beat
+std::vector<float>
+createClickTrack ()
+{
+  auto const numSamples = std::size_t (sampleRate * lengthSeconds);
+  auto const samplesPerBeat = std::size_t (sampleRate * 60. / tempoBPM);
+  auto const samplesClick = std::size_t (sampleRate * 0.02);
+
+  std::mt19937 generator (1);
+  std::uniform_real_distribution<float> noise (-1.f, 1.f);
+
+  std::vector<float> signal (numSamples, 0.f);
+  for (auto sample = 0u; sample < numSamples; ++sample)
+    {
+      auto const offset = sample % samplesPerBeat;
+      if (offset < samplesClick)
+        signal[sample] = std::exp (-5.f * float (offset) / samplesClick)
+                         * noise (generator);
+    }
+  return signal;
+}
+
+}
+
+namespace a3
+{
+
+void
+reportBeatTrackerCPU ()
+{
+  auto const signal = createClickTrack ();
+  auto const numSamples = int (signal.size ());
+
+  std::cout << std::fixed << std::setprecision (2);
+  std::cout << std::endl
+            << "beat tracker on a " << tempoBPM << " BPM click track at "
+            << sampleRate << " Hz" << std::endl;
+  std::cout << std::setw (6) << "block" << std::setw (12) << "us/block"
+            << std::setw (12) << "% budget" << std::setw (10) << "tracking"
+            << std::endl;
+
+  for (auto blockSize : { 64, 128, 256, 512, 1024 })
+    {
+      BeatTracker beatTracker;
+      beatTracker.prepare (sampleRate);
+
+      Timings<> timings;
+      {
+        auto scopedTimer = ScopedTimer<> (timings);
+        for (auto start = 0; start < numSamples; start += blockSize)
+          {
+            float const *channels[] = { signal.data () + start };
+            beatTracker.process (channels, 1,
+                                 std::min (blockSize, numSamples - start));
+          }
+      }
+
+      auto const numBlocks = double (numSamples) / blockSize;
+      auto const microsPerBlock
+          = std::chrono::duration<double, std::micro> (
+                timings.get ().front ().duration)
+                .count ()
+            / numBlocks;
+      auto const microsBudget = 1e6 * blockSize / sampleRate;
+
+      std::cout << std::setw (6) << blockSize << std::setw (12)
+                << microsPerBlock << std::setw (12)
+                << 100. * microsPerBlock / microsBudget << std::setw (10)
+                << (beatTracker.isTracking () ? "yes" : "no") << std::endl;
+    }
+}
+
+}
@@ -0,0 +1,205 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Compares the batch coordinate conversions of Geometry.hh with the
+ * scalar Position accessors, in time per position and in the largest
+ * deviation from the scalar conversion in double precision.
+ *
+ * usage: a3-motion-geometry-benchmark [number of positions]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/util/Timing.hh>
+#include <a3-motion-engine/util/Types.hh>
+
+namespace
+{
+
+auto constexpr numPositionsDefault = 64;
+// repetitions are scaled so that each measurement converts about
+// this many positions.
+auto constexpr numConversionsTotal = 10 * 1000 * 1000;
+
+struct Coordinates
+{
+  std::vector<float> a, b, c;
+
+  explicit Coordinates (std::size_t numPositions)
+      : a (numPositions), b (numPositions), c (numPositions)
+  {
+  }
+};
+
+struct Error
+{
+  double angleDegrees = 0.;
+  double relative = 0.;
+};
+
+template <typename FunctionT>
+double
+measureNanosPerPosition (std::size_t numPositions, FunctionT &&convert)
+{
+  auto const numRepetitions
+      = std::max<std::size_t> (1, numConversionsTotal / numPositions);
+
+  a3::Timings<> timings;
+  {
+    auto scopedTimer = a3::ScopedTimer<> (timings);
+    for (auto repetition = 0u; repetition < numRepetitions; ++repetition)
+      convert ();
+  }
+
+  auto const duration = std::chrono::duration_cast<std::chrono::nanoseconds> (
+      timings.get ().front ().duration);
+  return double (duration.count ()) / double (numRepetitions * numPositions);
+}
+
+Error
+errorToSpherical (Coordinates const &cartesian, Coordinates const &spherical)
+{
+  Error error;
+  for (auto index = 0u; index < cartesian.a.size (); ++index)
+    {
+      auto const p = a3::Position<double>::fromCartesian (
+          cartesian.a[index], cartesian.b[index], cartesian.c[index]);
+      error.angleDegrees = std::max (
+          { error.angleDegrees,
+            std::abs (std::remainder (spherical.a[index] - p.azimuth (),
+                                      360.)),
+            std::abs (spherical.b[index] - p.elevation ()) });
+      error.relative
+          = std::max (error.relative,
+                      std::abs (spherical.c[index] - p.distance ())
+                          / p.distance ());
+    }
+  return error;
+}
+
+Error
+errorToCartesian (Coordinates const &spherical, Coordinates const &cartesian)
+{
+  Error error;
+  for (auto index = 0u; index < spherical.a.size (); ++index)
+    {
+      auto const p = a3::Position<double>::fromSpherical (
+          spherical.a[index], spherical.b[index], spherical.c[index]);
+      auto const distance = double (spherical.c[index]);
+      error.relative = std::max (
+          { error.relative, std::abs (cartesian.a[index] - p.x ()) / distance,
+            std::abs (cartesian.b[index] - p.y ()) / distance,
+            std::abs (cartesian.c[index] - p.z ()) / distance });
+    }
+  return error;
+}
+
+void
+report (char const *name, double nanosPerPosition, Error const &error)
+{
+  std::cout << std::setw (22) << name << std::setw (10) << nanosPerPosition
+            << std::setw (14) << error.angleDegrees << std::setw (14)
+            << error.relative << std::endl;
+}
+
+}
+
+int
+main (int argc, char **argv)
+{
+  auto numPositions = std::size_t (numPositionsDefault);
+  if (argc > 1)
+    numPositions = std::size_t (std::max (1, std::atoi (argv[1])));
+
+  std::mt19937 generator (1);
+  std::uniform_real_distribution<float> coordinate (-2.f, 2.f);
+  std::uniform_real_distribution<float> azimuth (-180.f, 180.f);
+  std::uniform_real_distribution<float> elevation (-90.f, 90.f);
+  std::uniform_real_distribution<float> distance (0.1f, 2.f);
+
+  Coordinates cartesian (numPositions), spherical (numPositions);
+  for (auto index = 0u; index < numPositions; ++index)
+    {
+      cartesian.a[index] = coordinate (generator);
+      cartesian.b[index] = coordinate (generator);
+      cartesian.c[index] = coordinate (generator);
+      spherical.a[index] = azimuth (generator);
+      spherical.b[index] = elevation (generator);
+      spherical.c[index] = distance (generator);
+    }
+
+  std::cout << std::scientific << std::setprecision (2);
+  std::cout << numPositions << " positions, errors against the scalar "
+            << "conversion in double precision" << std::endl;
+  std::cout << std::setw (22) << "" << std::setw (10) << "ns/pos"
+            << std::setw (14) << "max deg" << std::setw (14) << "max rel"
+            << std::endl;
+
+  Coordinates output (numPositions);
+  auto nanos = measureNanosPerPosition (numPositions, [&] {
+    for (auto index = 0u; index < numPositions; ++index)
+      {
+        auto const p = a3::Pos::fromCartesian (
+            cartesian.a[index], cartesian.b[index], cartesian.c[index]);
+        output.a[index] = p.azimuth ();
+        output.b[index] = p.elevation ();
+        output.c[index] = p.distance ();
+      }
+  });
+  report ("scalar to spherical", nanos,
+          errorToSpherical (cartesian, output));
+
+  nanos = measureNanosPerPosition (numPositions, [&] {
+    a3::convertCartesianToSpherical (
+        cartesian.a.data (), cartesian.b.data (), cartesian.c.data (),
+        output.a.data (), output.b.data (), output.c.data (), numPositions);
+  });
+  report ("batch to spherical", nanos, errorToSpherical (cartesian, output));
+
+  nanos = measureNanosPerPosition (numPositions, [&] {
+    for (auto index = 0u; index < numPositions; ++index)
+      {
+        auto const p = a3::Pos::fromSpherical (
+            spherical.a[index], spherical.b[index], spherical.c[index]);
+        output.a[index] = p.x ();
+        output.b[index] = p.y ();
+        output.c[index] = p.z ();
+      }
+  });
+  report ("scalar to cartesian", nanos,
+          errorToCartesian (spherical, output));
+
+  nanos = measureNanosPerPosition (numPositions, [&] {
+    a3::convertSphericalToCartesian (
+        spherical.a.data (), spherical.b.data (), spherical.c.data (),
+        output.a.data (), output.b.data (), output.c.data (), numPositions);
+  });
+  report ("batch to cartesian", nanos, errorToCartesian (spherical, output));
+
+  return 0;
+}
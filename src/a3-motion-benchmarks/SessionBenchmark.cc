@@ -0,0 +1,138 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Measures serializing and deserializing a session with a full
+ * pattern bank, compared to copying its patterns. Each operation is
+ * repeated and the median is reported, so allocations and page
+ * faults of the first run do not dominate.
+ *
+ * usage: a3-motion-session-benchmark [number of repetitions]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/Session.hh>
+#include <a3-motion-engine/tempo/TempoClock.hh>
+#include <a3-motion-engine/util/Timing.hh>
+
+namespace
+{
+
+auto constexpr numChannels = 4u;
+auto constexpr numPatternsPerChannel = 16u;
+auto constexpr lengthBeats = 16;
+auto constexpr numRepetitionsDefault = 100;
+
+a3::Session
+createFullSession ()
+{
+  a3::Session session;
+  session.channels.resize (numChannels);
+
+  auto const numTicks = lengthBeats * a3::TempoClock::getTicksPerBeat ();
+  for (auto channel = 0u; channel < numChannels; ++channel)
+    for (auto index = 0u; index < numPatternsPerChannel; ++index)
+      {
+        a3::Session::PatternData pattern;
+        pattern.channel = channel;
+        pattern.index = index;
+        pattern.playbackLength = a3::Measure (0, lengthBeats, 0);
+        for (auto tick = 0; tick < numTicks; ++tick)
+          pattern.ticks.push_back (
+              a3::Pos::fromCartesian (float (tick), float (index), -1.f));
+        session.patterns.push_back (std::move (pattern));
+      }
+  return session;
+}
+
+template <typename FunctionT>
+double
+measureMedianMicros (int numRepetitions, FunctionT &&function)
+{
+  a3::Timings<> timings;
+  for (auto repetition = 0; repetition < numRepetitions; ++repetition)
+    {
+      auto scopedTimer = a3::ScopedTimer<> (timings);
+      function ();
+    }
+
+  std::vector<double> micros;
+  for (auto const &measurement : timings.get ())
+    micros.push_back (std::chrono::duration<double, std::micro> (
+                          measurement.duration)
+                          .count ());
+  auto const median = micros.begin () + std::ptrdiff_t (micros.size () / 2);
+  std::nth_element (micros.begin (), median, micros.end ());
+  return *median;
+}
+
+}
+
+int
+main (int argc, char **argv)
+{
+  auto numRepetitions = numRepetitionsDefault;
+  if (argc > 1)
+    numRepetitions = std::max (1, std::atoi (argv[1]));
+
+  auto const session = createFullSession ();
+
+  auto const microsCopy = measureMedianMicros (numRepetitions, [&] {
+    auto const patterns = session.patterns;
+    juce::ignoreUnused (patterns);
+  });
+
+  juce::MemoryBlock data;
+  auto const microsSerialize = measureMedianMicros (
+      numRepetitions, [&] { session.serialize (data); });
+
+  auto numRestored = 0;
+  auto const microsDeserialize = measureMedianMicros (numRepetitions, [&] {
+    if (a3::Session::deserialize (data.getData (), data.getSize ()))
+      ++numRestored;
+  });
+  if (numRestored != numRepetitions)
+    {
+      std::cerr << "deserialization failed" << std::endl;
+      return 1;
+    }
+
+  std::cout << std::fixed << std::setprecision (1);
+  std::cout << "session of " << data.getSize () / 1024 << " KiB, median of "
+            << numRepetitions << " runs" << std::endl;
+  std::cout << std::setw (12) << "" << std::setw (10) << "us"
+            << std::setw (10) << "x copy" << std::endl;
+  for (auto const &[name, micros] :
+       { std::pair{ "copy", microsCopy },
+         std::pair{ "serialize", microsSerialize },
+         std::pair{ "deserialize", microsDeserialize } })
+    std::cout << std::setw (12) << name << std::setw (10) << micros
+              << std::setw (10) << micros / microsCopy << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,338 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Replays tap corpora through all TempoEstimator implementations and
+ * reports how quickly and how accurately each one finds the tempo.
+ *
+ * A corpus is a text file with one tap time in microseconds per line,
+ * as written to taps.csv by TempoEstimatorTest. Lines starting with
+ * '#' are comments, a "# bpm=<tempo>" comment gives the reference
+ * tempo. Without it the median inter-tap interval is used. The CPU
+ * load of the BeatTracker is reported at the end.
+ *
+ * usage: a3-motion-benchmarks [corpus files or directories...]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <JuceHeader.h>
+
+#include "BeatTrackerBenchmark.hh"
+
+#include <a3-motion-engine/tempo/TempoEstimator.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorIRLS.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorLast.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorMean.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorMeanSelective.hh>
+#include <a3-motion-engine/util/Timing.hh>
+
+namespace
+{
+
+// an estimate is considered converged when it stays within this
+// tolerance until the end of the corpus.
+auto constexpr toleranceBPM = 2.f;
+// errors are averaged from this tap on, earlier estimates are
+// covered by the convergence metric.
+auto constexpr numTapsSettle = 8;
+// every n-th tap of the outlier variant is displaced by a fraction of
+// the beat, alternating early and late.
+auto constexpr outlierPeriodTaps = 7;
+auto constexpr outlierFractionBeat = 0.2;
+auto constexpr numRepetitionsCPU = 200;
+
+struct Corpus
+{
+  juce::String name;
+  std::vector<juce::int64> tapTimesMicros;
+  float tempoBPM;
+};
+
+struct Estimator
+{
+  juce::String name;
+  std::function<std::unique_ptr<a3::TempoEstimator> ()> create;
+};
+
+struct Accuracy
+{
+  int numTapsConverged = -1;
+  float errorMeanBPM = 0.f;
+  float errorMaxBPM = 0.f;
+};
+
+float
+medianTempoBPM (std::vector<juce::int64> const &tapTimesMicros)
+{
+  std::vector<juce::int64> deltas;
+  for (auto index = 1u; index < tapTimesMicros.size (); ++index)
+    deltas.push_back (tapTimesMicros[index] - tapTimesMicros[index - 1]);
+
+  if (deltas.empty ())
+    return 0.f;
+
+  auto middle = deltas.begin () + deltas.size () / 2;
+  std::nth_element (deltas.begin (), middle, deltas.end ());
+  return float (60.0 * 1e6 / double (*middle));
+}
+
+std::optional<Corpus>
+loadCorpus (juce::File const &file)
+{
+  juce::StringArray lines;
+  file.readLines (lines);
+
+  Corpus corpus{ file.getFileNameWithoutExtension (), {}, 0.f };
+  for (auto const &line : lines)
+    {
+      auto const trimmed = line.trim ();
+      if (trimmed.startsWithChar ('#'))
+        {
+          auto const tempo = trimmed.fromFirstOccurrenceOf ("bpm=", false,
+                                                            false);
+          if (tempo.isNotEmpty ())
+            corpus.tempoBPM = tempo.getFloatValue ();
+        }
+      else if (trimmed.containsOnly ("0123456789") && trimmed.isNotEmpty ())
+        {
+          corpus.tapTimesMicros.push_back (trimmed.getLargeIntValue ());
+        }
+    }
+
+  if (corpus.tapTimesMicros.size () < 2)
+    {
+      std::cerr << "skipping " << file.getFullPathName () << ": no taps"
+                << std::endl;
+      return std::nullopt;
+    }
+
+  if (corpus.tempoBPM <= 0.f)
+    corpus.tempoBPM = medianTempoBPM (corpus.tapTimesMicros);
+
+  return corpus;
+}
+
+std::vector<juce::int64>
+withOutliers (Corpus const &corpus)
+{
+  auto tapTimesMicros = corpus.tapTimesMicros;
+  auto const displacement
+      = juce::int64 (outlierFractionBeat * 60.0 * 1e6 / corpus.tempoBPM);
+
+  auto sign = 1;
+  for (auto index = std::size_t (outlierPeriodTaps);
+       index < tapTimesMicros.size (); index += outlierPeriodTaps)
+    {
+      tapTimesMicros[index] += sign * displacement;
+      sign = -sign;
+    }
+  return tapTimesMicros;
+}
+
+Accuracy
+evaluateAccuracy (Estimator const &estimator,
+                  std::vector<juce::int64> const &tapTimesMicros,
+                  float tempoBPM)
+{
+  auto tempoEstimator = estimator.create ();
+
+  Accuracy accuracy;
+  auto numErrors = 0;
+  for (auto index = 0u; index < tapTimesMicros.size (); ++index)
+    {
+      auto const result = tempoEstimator->tap (tapTimesMicros[index]);
+      auto const available
+          = result == a3::TempoEstimator::TapResult::TempoAvailable;
+      auto const error
+          = available ? std::abs (tempoEstimator->getTempoBPM () - tempoBPM)
+                      : std::numeric_limits<float>::infinity ();
+
+      if (error > toleranceBPM)
+        accuracy.numTapsConverged = -1;
+      else if (accuracy.numTapsConverged < 0)
+        accuracy.numTapsConverged = int (index) + 1;
+
+      if (available && index + 1 >= numTapsSettle)
+        {
+          accuracy.errorMeanBPM += error;
+          accuracy.errorMaxBPM = std::max (accuracy.errorMaxBPM, error);
+          ++numErrors;
+        }
+    }
+
+  if (numErrors > 0)
+    accuracy.errorMeanBPM /= float (numErrors);
+
+  return accuracy;
+}
+
+double
+evaluateMicrosPerTap (Estimator const &estimator,
+                      std::vector<juce::int64> const &tapTimesMicros)
+{
+  auto tempoEstimator = estimator.create ();
+
+  // replay the corpus back to back with a pause in between that
+  // makes the estimator start over, like a user tapping again.
+  auto const pauseMicros = juce::int64 (3 * 1000 * 1000);
+  auto const lengthMicros
+      = tapTimesMicros.back () - tapTimesMicros.front () + pauseMicros;
+
+  a3::Timings<> timings;
+  auto tempoBPMSum = 0.f;
+  for (auto repetition = 0; repetition < numRepetitionsCPU; ++repetition)
+    {
+      auto const offset = repetition * lengthMicros;
+      auto scopedTimer = a3::ScopedTimer<> (timings);
+      for (auto tapTimeMicros : tapTimesMicros)
+        if (tempoEstimator->tap (tapTimeMicros + offset)
+            == a3::TempoEstimator::TapResult::TempoAvailable)
+          tempoBPMSum += tempoEstimator->getTempoBPM ();
+    }
+  juce::ignoreUnused (tempoBPMSum);
+
+  auto total = std::chrono::nanoseconds (0);
+  for (auto const &measurement : timings.get ())
+    total += std::chrono::duration_cast<std::chrono::nanoseconds> (
+        measurement.duration);
+
+  auto const numTaps = double (numRepetitionsCPU) * tapTimesMicros.size ();
+  return double (total.count ()) / 1000.0 / numTaps;
+}
+
+void
+collectCorpora (juce::File const &location, std::vector<Corpus> &corpora)
+{
+  if (location.isDirectory ())
+    {
+      auto files = location.findChildFiles (juce::File::findFiles, false,
+                                            "*.csv");
+      files.sort ();
+      for (auto const &file : files)
+        if (auto corpus = loadCorpus (file))
+          corpora.push_back (std::move (*corpus));
+    }
+  else if (location.existsAsFile ())
+    {
+      if (auto corpus = loadCorpus (location))
+        corpora.push_back (std::move (*corpus));
+    }
+  else
+    {
+      std::cerr << "not found: " << location.getFullPathName () << std::endl;
+    }
+}
+
+juce::String
+formatConvergence (Accuracy const &accuracy)
+{
+  return accuracy.numTapsConverged < 0
+             ? juce::String ("never")
+             : juce::String (accuracy.numTapsConverged);
+}
+
+}
+
+int
+main (int argc, char **argv)
+{
+  std::vector<Estimator> const estimators = {
+    { "last", [] { return std::make_unique<a3::TempoEstimatorLast> (); } },
+    { "mean", [] { return std::make_unique<a3::TempoEstimatorMean> (); } },
+    { "sel3",
+      [] { return std::make_unique<a3::TempoEstimatorMeanSelective> (3); } },
+    { "sel4",
+      [] { return std::make_unique<a3::TempoEstimatorMeanSelective> (4); } },
+    { "sel6",
+      [] { return std::make_unique<a3::TempoEstimatorMeanSelective> (6); } },
+    { "irls", [] { return std::make_unique<a3::TempoEstimatorIRLS> (); } },
+  };
+
+  std::vector<Corpus> corpora;
+  if (argc > 1)
+    {
+      for (auto arg = 1; arg < argc; ++arg)
+        {
+          auto const cwd = juce::File::getCurrentWorkingDirectory ();
+          collectCorpora (cwd.getChildFile (argv[arg]), corpora);
+        }
+    }
+  else
+    {
+      collectCorpora (juce::File (A3_BENCHMARK_CORPORA_DIR), corpora);
+    }
+
+  if (corpora.empty ())
+    {
+      std::cerr << "no tap corpora found" << std::endl;
+      return 1;
+    }
+
+  std::cout << std::fixed << std::setprecision (2);
+  std::cout << "convergence in taps until within " << toleranceBPM
+            << " BPM, errors in BPM from tap " << numTapsSettle
+            << ", outliers displace every " << outlierPeriodTaps
+            << "th tap by " << outlierFractionBeat << " beats" << std::endl;
+
+  for (auto const &corpus : corpora)
+    {
+      std::cout << std::endl
+                << corpus.name << " (" << corpus.tapTimesMicros.size ()
+                << " taps, " << corpus.tempoBPM << " BPM)" << std::endl;
+      std::cout << std::setw (6) << "" << std::setw (8) << "conv"
+                << std::setw (8) << "mean" << std::setw (8) << "max"
+                << std::setw (10) << "out conv" << std::setw (10)
+                << "out mean" << std::setw (9) << "out max" << std::setw (9)
+                << "us/tap" << std::endl;
+
+      auto const tapTimesOutliers = withOutliers (corpus);
+      for (auto const &estimator : estimators)
+        {
+          auto const accuracy = evaluateAccuracy (
+              estimator, corpus.tapTimesMicros, corpus.tempoBPM);
+          auto const accuracyOutliers = evaluateAccuracy (
+              estimator, tapTimesOutliers, corpus.tempoBPM);
+          auto const microsPerTap
+              = evaluateMicrosPerTap (estimator, corpus.tapTimesMicros);
+
+          std::cout << std::setw (6) << estimator.name << std::setw (8)
+                    << formatConvergence (accuracy) << std::setw (8)
+                    << accuracy.errorMeanBPM << std::setw (8)
+                    << accuracy.errorMaxBPM << std::setw (10)
+                    << formatConvergence (accuracyOutliers) << std::setw (10)
+                    << accuracyOutliers.errorMeanBPM << std::setw (9)
+                    << accuracyOutliers.errorMaxBPM << std::setw (9)
+                    << microsPerTap << std::endl;
+        }
+    }
+
+  a3::reportBeatTrackerCPU ();
+
+  return 0;
+}
@@ -20,47 +20,48 @@
 
 #include "AsyncCommandQueue.hh"
 
-#include <a3-motion-engine/backends/SpatBackendIEM.hh>
+#include <algorithm>
 
 namespace a3
 {
 
-AsyncCommandQueue::AsyncCommandQueue (std::unique_ptr<SpatBackend> backend)
-    : juce::Thread ("AsyncCommandQueue")
+AsyncCommandQueue::AsyncCommandQueue (std::unique_ptr<SpatBackend> backend,
+                                      index_t numChannels)
+    : juce::Thread ("AsyncCommandQueue"), _state (numChannels),
+      _statePublished (State (numChannels)), _stateSent (numChannels),
+      _backend (std::move (backend))
 {
-  _backend = std::move (backend);
 }
 
 AsyncCommandQueue::~AsyncCommandQueue () {}
 
 void
-AsyncCommandQueue::sendPosition (index_t channel, Pos position)
+AsyncCommandQueue::setPosition (index_t channel, Pos position)
 {
-  Message message;
-  message.command = Message::Command::SendPosition;
-  message.channel = channel;
-  message.position = position;
-  submitMessage (std::move (message));
+  _state[channel].position = position;
 }
 
 void
-AsyncCommandQueue::sendWidth (index_t channel, float width)
+AsyncCommandQueue::setWidth (index_t channel, float width)
 {
-  Message message;
-  message.command = Message::Command::SendWidth;
-  message.channel = channel;
-  message.width = width;
-  submitMessage (std::move (message));
+  _state[channel].width = width;
 }
 
 void
-AsyncCommandQueue::sendAmbisonicsOrder (index_t channel, int order)
+AsyncCommandQueue::setAmbisonicsOrder (index_t channel, int order)
 {
-  Message message;
-  message.command = Message::Command::SendAmbisonicsOrder;
-  message.channel = channel;
-  message.order = order;
-  submitMessage (std::move (message));
+  _state[channel].order = order;
+}
+
+void
+AsyncCommandQueue::flush ()
+{
+  // the write buffer has the same size, so this does not allocate
+  auto &statePublished = _statePublished.getWriteBuffer ();
+  std::copy (_state.begin (), _state.end (), statePublished.begin ());
+  _statePublished.publish ();
+
+  notify ();
 }
 
 void
@@ -72,74 +73,43 @@ AsyncCommandQueue::run ()
       if (threadShouldExit ())
         break;
 
-      processFifo ();
+      sendChanges ();
     }
 }
 
 void
-AsyncCommandQueue::submitMessage (Message &&message)
-{
-  jassert (_abstractFifo.getFreeSpace () > 0);
-
-  const auto scope = _abstractFifo.write (1);
-  jassert (scope.blockSize1 == 1);
-  jassert (scope.blockSize2 == 0);
-
-  jassert (scope.startIndex1 >= 0);
-  auto startIndex = static_cast<std::size_t> (scope.startIndex1);
-
-  _fifo[startIndex] = std::move (message);
-
-  notify ();
-}
-
-void
-AsyncCommandQueue::processFifo ()
+AsyncCommandQueue::sendChanges ()
 {
-  auto const ready = _abstractFifo.getNumReady ();
-  const auto scope = _abstractFifo.read (ready);
+  if (!_statePublished.update ())
+    return;
 
-  jassert (scope.blockSize1 + scope.blockSize2 == ready);
-
-  if (scope.blockSize1 > 0)
+  auto const &state = _statePublished.getReadBuffer ();
+  for (auto channel = 0u; channel < state.size (); ++channel)
     {
-      for (int idx = scope.startIndex1;
-           idx < scope.startIndex1 + scope.blockSize1; ++idx)
+      auto const &current = state[channel];
+      auto &sent = _stateSent[channel];
+
+      // nothing has been sent yet while the sent position is invalid,
+      // it must not be compared
+      if (current.position.isValid ()
+          && (!sent.position.isValid () || current.position != sent.position))
         {
-          jassert (idx >= 0);
-          processMessage (_fifo[static_cast<std::size_t> (idx)]);
+          _backend->sendPosition (channel, current.position);
+          sent.position = current.position;
         }
-    }
 
-  if (scope.blockSize2 > 0)
-    for (int idx = scope.startIndex2;
-         idx < scope.startIndex2 + scope.blockSize2; ++idx)
-      {
-        jassert (idx >= 0);
-        processMessage (_fifo[static_cast<std::size_t> (idx)]);
-      }
-}
+      if (current.width >= 0.f
+          && !juce::approximatelyEqual (current.width, sent.width))
+        {
+          _backend->sendWidth (channel, current.width);
+          sent.width = current.width;
+        }
 
-void
-AsyncCommandQueue::processMessage (Message const &message)
-{
-  switch (message.command)
-    {
-    case Message::Command::SendPosition:
-      {
-        _backend->sendPosition (message.channel, message.position);
-        break;
-      }
-    case Message::Command::SendWidth:
-      {
-        _backend->sendWidth (message.channel, message.width);
-        break;
-      }
-    case Message::Command::SendAmbisonicsOrder:
-      {
-        _backend->sendAmbisonicsOrder (message.channel, message.order);
-        break;
-      }
+      if (current.order >= 0 && current.order != sent.order)
+        {
+          _backend->sendAmbisonicsOrder (channel, current.order);
+          sent.order = current.order;
+        }
     }
 }
 
@@ -21,50 +21,60 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <JuceHeader.h>
 
 #include <a3-motion-engine/backends/SpatBackend.hh>
+#include <a3-motion-engine/util/TripleBuffer.hh>
 
 namespace a3
 {
 
+/* Passes the channel state from the tick thread to the backend on a
+ * thread of its own. Instead of queueing individual messages, the tick
+ * thread publishes the latest state of all channels and the queue's
+ * thread sends every value that differs from the one it sent last.
+ * Values that change again before the backend thread gets to them are
+ * coalesced, so no change is ever lost, however far the backend falls
+ * behind.
+ */
 class AsyncCommandQueue : public juce::Thread
 {
 public:
-  AsyncCommandQueue (std::unique_ptr<SpatBackend> backend);
+  AsyncCommandQueue (std::unique_ptr<SpatBackend> backend,
+                     index_t numChannels);
   ~AsyncCommandQueue ();
 
-  void sendPosition (index_t channel, Pos position);
-  void sendWidth (index_t channel, float width);
-  void sendAmbisonicsOrder (index_t channel, int order);
+  // Set the state to be sent with the next flush, called from the
+  // tick thread only.
+  void setPosition (index_t channel, Pos position);
+  void setWidth (index_t channel, float width);
+  void setAmbisonicsOrder (index_t channel, int order);
+
+  // Publishes the state set so far and wakes up the queue's thread to
+  // send the changes. Batching the changes of a tick saves a wakeup
+  // per value.
+  void flush ();
 
   void run () override;
 
 private:
-  // TODO turn this into a proper union using std::variant
-  struct Message
+  struct ChannelState
   {
-    enum class Command
-    {
-      SendPosition,
-      SendWidth,
-      SendAmbisonicsOrder,
-    } command;
-
-    index_t channel;
-    Pos position;
-    float width;
-    int order;
+    Pos position = Pos::invalid;
+    float width = -1.f;
+    int order = -1;
   };
+  using State = std::vector<ChannelState>;
 
-  void submitMessage (Message &&message);
-  void processFifo ();
-  void processMessage (Message const &message);
+  void sendChanges ();
 
-  static constexpr int fifoSize = 32;
-  juce::AbstractFifo _abstractFifo{ fifoSize };
-  std::array<Message, fifoSize> _fifo;
+  // accessed by the tick thread only
+  State _state;
+  TripleBuffer<State> _statePublished;
+  // accessed by the queue's thread only, nothing has been sent yet
+  State _stateSent;
 
   std::unique_ptr<SpatBackend> _backend;
 };
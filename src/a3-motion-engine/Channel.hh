@@ -24,6 +24,7 @@
 #include <shared_mutex>
 
 #include <a3-motion-engine/Measure.hh>
+#include <a3-motion-engine/PatternTransform.hh>
 #include <a3-motion-engine/util/Types.hh>
 
 namespace a3
@@ -54,6 +55,8 @@ private:
   std::shared_ptr<Pattern> _patternScheduledForPlaying;
   std::shared_ptr<Pattern> _patternPlaying;
   Measure _playingStarted;
+  // applied to the playing pattern, accessed by the tick thread only
+  PatternTransform _transform;
 
   Pos _position;
   std::atomic<float> _width = 45;
@@ -0,0 +1,102 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ChannelGroup.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include <JuceHeader.h>
+
+namespace a3
+{
+
+ChannelGroup::ChannelGroup (std::vector<index_t> channels,
+                            std::vector<Pos> const &positions,
+                            std::optional<index_t> leader)
+    : _channels (std::move (channels)), _leader (leader)
+{
+  jassert (_channels.size () == positions.size ());
+  jassert (!_leader
+           || std::find (_channels.begin (), _channels.end (), *_leader)
+                  == _channels.end ());
+
+  auto centerX = 0.f;
+  auto centerY = 0.f;
+  for (auto const &position : positions)
+    {
+      centerX += position.x ();
+      centerY += position.y ();
+    }
+  if (!positions.empty ())
+    {
+      centerX /= float (positions.size ());
+      centerY /= float (positions.size ());
+    }
+  _initialPose.translationX = centerX;
+  _initialPose.translationY = centerY;
+
+  for (auto const &position : positions)
+    {
+      _offsetsX.push_back (position.x () - centerX);
+      _offsetsY.push_back (position.y () - centerY);
+    }
+}
+
+std::vector<index_t> const &
+ChannelGroup::getChannels () const
+{
+  return _channels;
+}
+
+std::optional<index_t>
+ChannelGroup::getLeader () const
+{
+  return _leader;
+}
+
+ChannelGroup::Pose
+ChannelGroup::getInitialPose () const
+{
+  return _initialPose;
+}
+
+void
+ChannelGroup::place (Pose const &pose, float rotationDegreesLeader,
+                     float *x, float *y) const
+{
+  auto const angle
+      = (pose.rotationDegrees + rotationDegreesLeader) * pi<float> () / 180.f;
+  auto const cosine = pose.spread * std::cos (angle);
+  auto const sine = pose.spread * std::sin (angle);
+
+  auto const *offsetsX = _offsetsX.data ();
+  auto const *offsetsY = _offsetsY.data ();
+  auto const numMembers = _offsetsX.size ();
+  for (auto index = 0u; index < numMembers; ++index)
+    {
+      x[index] = cosine * offsetsX[index] - sine * offsetsY[index]
+                 + pose.translationX;
+      y[index] = sine * offsetsX[index] + cosine * offsetsY[index]
+                 + pose.translationY;
+    }
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Channels moved together by a single pose. The formation holds the
+ * horizontal offsets of the members from the group center. Every tick
+ * each member is placed at its offset scaled by the spread, rotated
+ * and moved to the translation, the height is left to the caller.
+ *
+ * If the group has a leader channel, the change of its azimuth since
+ * the group was created is added to the rotation by the caller, so a
+ * pattern played on the leader swirls the whole group. The leader is
+ * never a member. Groups are immutable once created, the pose is set
+ * separately.
+ */
+class ChannelGroup
+{
+public:
+  struct Pose
+  {
+    float rotationDegrees = 0.f;
+    float spread = 1.f;
+    float translationX = 0.f;
+    float translationY = 0.f;
+  };
+
+  // The formation is taken from the given positions of the members,
+  // relative to their centroid. The initial pose keeps all members
+  // in place.
+  ChannelGroup (std::vector<index_t> channels,
+                std::vector<Pos> const &positions,
+                std::optional<index_t> leader = std::nullopt);
+
+  std::vector<index_t> const &getChannels () const;
+  std::optional<index_t> getLeader () const;
+  Pose getInitialPose () const;
+
+  // computes the horizontal member positions in the order of
+  // getChannels, 'x' and 'y' must hold one entry per member
+  void place (Pose const &pose, float rotationDegreesLeader, float *x,
+              float *y) const;
+
+private:
+  std::vector<index_t> _channels;
+  std::optional<index_t> _leader;
+  Pose _initialPose;
+
+  // formation offsets, stored as separate arrays so that place
+  // vectorizes
+  std::vector<float> _offsetsX;
+  std::vector<float> _offsetsY;
+};
+
+}
@@ -0,0 +1,67 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <a3-motion-engine/Measure.hh>
+#include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/PatternTransform.hh>
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Consistent copy of the engine state as seen at the end of one tick.
+ * The tick thread publishes it through a TripleBuffer, so the UI can
+ * read all channels and patterns of the same tick without locking.
+ */
+struct EngineSnapshot
+{
+  struct ChannelState
+  {
+    Pos position;
+    float width = 0.f;
+    int ambisonicsOrder = 0;
+
+    std::shared_ptr<Pattern> patternPlaying;
+    Pattern::Status statusPlaying = Pattern::Status::Empty;
+    float playPosition = 0.f;
+    PatternTransform transform;
+  };
+  std::vector<ChannelState> channels;
+
+  std::shared_ptr<Pattern> patternRecording;
+  Pattern::Status statusRecording = Pattern::Status::Empty;
+  // fraction of the recording pattern that has been written
+  float recordingProgress = 0.f;
+
+  Measure now;
+
+  bool
+  isRecording () const
+  {
+    return patternRecording != nullptr;
+  }
+};
+
+}
@@ -20,10 +20,12 @@
 
 #include "MotionEngine.hh"
 
+#include <algorithm>
 #include <cstddef>
 
 #include <a3-motion-engine/Channel.hh>
 #include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/Session.hh>
 #include <a3-motion-engine/UserConfig.hh>
 #include <a3-motion-engine/backends/SpatBackendA3.hh>
 #include <a3-motion-engine/elevation/HeightMap.hh>
@@ -34,10 +36,24 @@ namespace a3
 {
 
 MotionEngine::MotionEngine (index_t numChannels, const HeightMap &heightMap)
-    : _heightMap (heightMap), _commandQueue (std::make_unique<SpatBackendA3> (
-                                  userConfig["hostname"], userConfig["port"]))
+    : MotionEngine (numChannels, heightMap,
+                    std::make_unique<SpatBackendA3> (userConfig["hostname"],
+                                                     userConfig["port"]),
+                    std::make_shared<TimeSourceSystem> ())
+{
+}
+
+MotionEngine::MotionEngine (index_t numChannels, const HeightMap &heightMap,
+                            std::unique_ptr<SpatBackend> backend,
+                            std::shared_ptr<TimeSource> timeSource)
+    : _heightMap (heightMap), _tempoClock (std::move (timeSource)),
+      _commandQueue (std::move (backend), numChannels),
+      _snapshots (EngineSnapshot{
+          std::vector<EngineSnapshot::ChannelState> (numChannels), nullptr,
+          Pattern::Status::Empty, 0.f, Measure () })
 {
   createChannels (numChannels);
+  publishSnapshot ();
 
   _callbackHandleTick = _tempoClock.scheduleEventHandlerAddition (
       { [this] (auto measure) {
@@ -61,9 +77,8 @@ void
 MotionEngine::createChannels (index_t const numChannels)
 {
   _channels.resize (numChannels);
-  _lastSentPositions.resize (numChannels);
-  _lastSentWidths.resize (numChannels);
-  _lastSentAmbisonicsOrders.resize (numChannels);
+  _channelGroupX.resize (numChannels);
+  _channelGroupY.resize (numChannels);
 
   auto constexpr spread = 120.f;
   auto const azimuthSpacing = spread / (numChannels - 1);
@@ -95,6 +110,13 @@ MotionEngine::getNumChannels ()
   return _channels.size ();
 }
 
+void
+MotionEngine::getSnapshot (EngineSnapshot &snapshot)
+{
+  _snapshots.update ();
+  snapshot = _snapshots.getReadBuffer ();
+}
+
 Pos
 MotionEngine::getChannelPosition (index_t channel)
 {
@@ -139,12 +161,6 @@ MotionEngine::setChannelAmbisonicsOrder (index_t channel, int order)
   _channels[channel]->setAmbisonicsOrder (order);
 }
 
-std::shared_ptr<Pattern>
-MotionEngine::getPlayingPattern (index_t channel)
-{
-  return _channels[channel]->_patternPlaying;
-}
-
 void
 MotionEngine::setRecording2DPosition (Pos const &position)
 {
@@ -210,6 +226,79 @@ MotionEngine::stopPattern (std::shared_ptr<Pattern> pattern, Measure timepoint)
   submitFifoMessage (message);
 }
 
+void
+MotionEngine::setChannelTransform (index_t channel,
+                                   PatternTransform const &transform)
+{
+  jassert (channel < _channels.size ());
+
+  Message message;
+  message.command = Message::Command::SetChannelTransform;
+  message.channel = channel;
+  message.transform = transform;
+  submitFifoMessage (message);
+}
+
+void
+MotionEngine::setChannelGroup (index_t group, std::vector<index_t> channels,
+                               std::optional<index_t> leader)
+{
+  jassert (group < maxNumChannelGroups);
+  jassert (!leader || *leader < _channels.size ());
+
+  // a channel can only be placed once per group, and a leader placed
+  // by its own rotation would spin the group forever.
+  if (leader)
+    channels.erase (std::remove (channels.begin (), channels.end (), *leader),
+                    channels.end ());
+  std::sort (channels.begin (), channels.end ());
+  channels.erase (std::unique (channels.begin (), channels.end ()),
+                  channels.end ());
+  channels.erase (std::remove_if (channels.begin (), channels.end (),
+                                  [this] (auto channel) {
+                                    return channel >= _channels.size ();
+                                  }),
+                  channels.end ());
+
+  std::vector<Pos> positions;
+  for (auto channel : channels)
+    positions.push_back (_channels[channel]->getPosition ());
+
+  auto channelGroup = std::make_shared<ChannelGroup> (std::move (channels),
+                                                     positions, leader);
+
+  Message message;
+  message.command = Message::Command::SetChannelGroup;
+  message.group = group;
+  message.pose = channelGroup->getInitialPose ();
+  message.channelGroup = std::move (channelGroup);
+  submitFifoMessage (message);
+}
+
+void
+MotionEngine::releaseChannelGroup (index_t group)
+{
+  jassert (group < maxNumChannelGroups);
+
+  Message message;
+  message.command = Message::Command::SetChannelGroup;
+  message.group = group;
+  submitFifoMessage (message);
+}
+
+void
+MotionEngine::setChannelGroupPose (index_t group,
+                                   ChannelGroup::Pose const &pose)
+{
+  jassert (group < maxNumChannelGroups);
+
+  Message message;
+  message.command = Message::Command::SetChannelGroupPose;
+  message.group = group;
+  message.pose = pose;
+  submitFifoMessage (message);
+}
+
 void
 MotionEngine::setRecordingMode (RecordingMode recordingMode)
 {
@@ -219,22 +308,27 @@ MotionEngine::setRecordingMode (RecordingMode recordingMode)
   submitFifoMessage (message);
 }
 
-MotionEngine::RecordingMode
-MotionEngine::getRecordingMode () const
+RecordingJournal &
+MotionEngine::getRecordingJournal ()
 {
-  return _recordingMode;
+  return _recordingJournal;
 }
 
-bool
-MotionEngine::isRecording () const
+void
+MotionEngine::restoreSession (std::shared_ptr<Session const> session)
 {
-  return _patternRecording != nullptr;
+  _tempoClock.setTempoBPM (session->tempoBPM);
+
+  Message message;
+  message.command = Message::Command::RestoreSession;
+  message.session = std::move (session);
+  submitFifoMessage (message);
 }
 
-std::shared_ptr<Pattern>
-MotionEngine::getRecordingPattern ()
+MotionEngine::RecordingMode
+MotionEngine::getRecordingMode () const
 {
-  return _patternRecording;
+  return _recordingMode;
 }
 
 void
@@ -258,31 +352,23 @@ MotionEngine::tickCallback ()
 
   performRecording ();
   performPlayback ();
+  performChannelGroups ();
 
-  // compare with last enqueued values and enqueue on change
+  // the command queue sends the values that changed since it last
+  // sent them
   for (auto index = 0u; index < _channels.size (); ++index)
     {
-      auto const position = _channels[index]->getPosition ();
-      if (position.isValid () && _lastSentPositions[index] != position)
-        {
-          _commandQueue.sendPosition (index, position);
-          _lastSentPositions[index] = position;
-        }
+      auto const &channel = *_channels[index];
+      auto const position = channel.getPosition ();
+      if (position.isValid ())
+        _commandQueue.setPosition (index, position);
+      _commandQueue.setWidth (index, channel.getWidth ());
+      _commandQueue.setAmbisonicsOrder (index, channel.getAmbisonicsOrder ());
+    }
 
-      auto const width = _channels[index]->getWidth ();
-      if (!juce::approximatelyEqual (_lastSentWidths[index], width))
-        {
-          _commandQueue.sendWidth (index, width);
-          _lastSentWidths[index] = width;
-        }
+  _commandQueue.flush ();
 
-      auto const order = _channels[index]->getAmbisonicsOrder ();
-      if (_lastSentAmbisonicsOrders[index] != order)
-        {
-          _commandQueue.sendAmbisonicsOrder (index, order);
-          _lastSentAmbisonicsOrders[index] = order;
-        }
-    }
+  publishSnapshot ();
 }
 
 void
@@ -349,6 +435,22 @@ MotionEngine::handleFifoMessage (Message const &message)
         _recordingMode = message.recordingMode;
         break;
       }
+    case Message::Command::SetChannelTransform:
+      {
+        _channels[message.channel]->_transform = message.transform;
+        break;
+      }
+    case Message::Command::SetChannelGroup:
+      {
+        _channelGroups[message.group] = { message.channelGroup, message.pose,
+                                          std::nullopt };
+        break;
+      }
+    case Message::Command::SetChannelGroupPose:
+      {
+        _channelGroups[message.group].pose = message.pose;
+        break;
+      }
     case Message::Command::StartRecording:
       {
         scheduledForRecording (message.pattern, message.timepoint);
@@ -369,6 +471,11 @@ MotionEngine::handleFifoMessage (Message const &message)
         _messagesStartStop.push (message);
         break;
       }
+    case Message::Command::RestoreSession:
+      {
+        applySession (*message.session);
+        break;
+      }
     }
 }
 
@@ -483,6 +590,10 @@ MotionEngine::handleStartStopMessages ()
         case Message::Command::SetRecordingPosition:
         case Message::Command::ReleaseRecordingPosition:
         case Message::Command::SetRecordingMode:
+        case Message::Command::SetChannelTransform:
+        case Message::Command::SetChannelGroup:
+        case Message::Command::SetChannelGroupPose:
+        case Message::Command::RestoreSession:
           {
             throw std::runtime_error (
                 "invalid command message in start/stop queue");
@@ -513,6 +624,7 @@ MotionEngine::startRecording (std::shared_ptr<Pattern> pattern, Measure length)
 
   _recordingPosition = Pos::invalid;
   _recordingStarted = _now;
+  ++_numRecordingsStarted;
   _patternRecording->setStatus (Pattern::Status::Recording);
 
   _patternScheduledForRecording = nullptr;
@@ -548,6 +660,41 @@ MotionEngine::stop (std::shared_ptr<Pattern> pattern)
   _patternRecording = nullptr;
 }
 
+void
+MotionEngine::applySession (Session const &session)
+{
+  // pending starts and stops refer to the patterns of the previous
+  // session
+  while (!_messagesStartStop.empty ())
+    _messagesStartStop.pop ();
+
+  auto const release = [this] (std::shared_ptr<Pattern> &pattern) {
+    if (!pattern)
+      return;
+    pattern->setStatus (Pattern::Status::Idle);
+    notifyPatternStatusListeners (PatternStatusMessage::Status::Stopped,
+                                  pattern);
+    pattern = nullptr;
+  };
+  release (_patternScheduledForRecording);
+  release (_patternRecording);
+  _recordingPosition = Pos::invalid;
+  _recordingMode = session.recordingMode;
+
+  for (auto index = 0u; index < _channels.size (); ++index)
+    {
+      auto &channel = *_channels[index];
+      release (channel._patternScheduledForPlaying);
+      release (channel._patternPlaying);
+
+      if (index < session.channels.size ())
+        {
+          channel.setWidth (session.channels[index].width);
+          channel.setAmbisonicsOrder (session.channels[index].ambisonicsOrder);
+        }
+    }
+}
+
 void
 MotionEngine::performRecording ()
 {
@@ -570,6 +717,9 @@ MotionEngine::performRecording ()
       auto const tick
           = static_cast<std::size_t> (ticksSinceStart) % ticksPatternLength;
       _patternRecording->setTick (tick, _recordingPosition);
+      _recordingJournal.appendTick (_patternRecording->getId (),
+                                    _numRecordingsStarted, tick,
+                                    ticksPatternLength, _recordingPosition);
 
       if (_recordingPosition.isValid ())
         {
@@ -595,10 +745,20 @@ MotionEngine::performPlayback ()
               || (status == Pattern::Status::ScheduledForRecording
                   && statusLast == Pattern::Status::Playing))
             {
-              auto const tick = updatePlayPosition (*channel->_patternPlaying);
-              auto position = channel->_patternPlaying->getTick (tick);
+              auto const &transform = channel->_transform;
+              auto const playPosition
+                  = updatePlayPosition (*channel->_patternPlaying);
+              auto position = channel->_patternPlaying->getPosition (
+                  transform.mapPhase (playPosition));
               if (position.isValid ())
                 {
+                  // the recorded height belongs to the untransformed
+                  // position, recompute it where the channel ends up
+                  if (!transform.isIdentity ())
+                    {
+                      position = transform.apply (position);
+                      position.setZ (_heightMap.computeHeight (position));
+                    }
                   channel->setPosition (position);
                 }
             }
@@ -606,10 +766,9 @@ MotionEngine::performPlayback ()
     }
 }
 
-index_t
+float
 MotionEngine::updatePlayPosition (Pattern &pattern)
 {
-  auto const ticksPatternLength = pattern.getNumTicks ();
   auto const ticksPlaybackLength = Measure::convertToTicks (
       pattern.getPlaybackLength (), _tempoClock.getBeatsPerBar ());
 
@@ -619,10 +778,92 @@ MotionEngine::updatePlayPosition (Pattern &pattern)
       = std::fmod (pattern.getPlayPosition () + playPositionDelta, 1.);
   pattern.setPlayPosition (static_cast<float> (playPosition));
 
-  auto step = static_cast<index_t> (ticksPatternLength * playPosition);
-  jassert (step < ticksPatternLength);
+  return static_cast<float> (playPosition);
+}
+
+void
+MotionEngine::performChannelGroups ()
+{
+  for (auto &state : _channelGroups)
+    {
+      if (!state.group)
+        continue;
+
+      // only the leader's rotation since the group was created turns
+      // the group, so it does not jump when created
+      auto rotationDegreesLeader = 0.f;
+      if (auto const leader = state.group->getLeader ())
+        {
+          auto const position = _channels[*leader]->getPosition ();
+          if (position.isValid ())
+            {
+              auto const azimuth = position.azimuth ();
+              if (!state.azimuthLeaderInitial)
+                state.azimuthLeaderInitial = azimuth;
+              rotationDegreesLeader = azimuth - *state.azimuthLeaderInitial;
+            }
+        }
+
+      state.group->place (state.pose, rotationDegreesLeader,
+                          _channelGroupX.data (), _channelGroupY.data ());
+
+      auto const &channels = state.group->getChannels ();
+      for (auto index = 0u; index < channels.size (); ++index)
+        {
+          auto position = Pos::fromCartesian (_channelGroupX[index],
+                                              _channelGroupY[index], 0.f);
+          position.setZ (_heightMap.computeHeight (position));
+          _channels[channels[index]]->setPosition (position);
+        }
+    }
+}
+
+void
+MotionEngine::publishSnapshot ()
+{
+  // NOTE: overwriting the shared_ptrs of an old snapshot may release
+  // the last reference to a pattern on the tick thread, see the note
+  // on _patternRecording.
+  auto &snapshot = _snapshots.getWriteBuffer ();
+  jassert (snapshot.channels.size () == _channels.size ());
+
+  for (auto index = 0u; index < _channels.size (); ++index)
+    {
+      auto const &channel = *_channels[index];
+      auto &state = snapshot.channels[index];
+      state.position = channel.getPosition ();
+      state.width = channel.getWidth ();
+      state.ambisonicsOrder = channel.getAmbisonicsOrder ();
+      state.transform = channel._transform;
+
+      state.patternPlaying = channel._patternPlaying;
+      if (channel._patternPlaying)
+        {
+          state.statusPlaying = channel._patternPlaying->getStatus ();
+          state.playPosition = channel._patternPlaying->getPlayPosition ();
+        }
+      else
+        {
+          state.statusPlaying = Pattern::Status::Empty;
+          state.playPosition = 0.f;
+        }
+    }
+
+  snapshot.patternRecording = _patternRecording;
+  snapshot.statusRecording = Pattern::Status::Empty;
+  snapshot.recordingProgress = 0.f;
+  if (_patternRecording)
+    {
+      snapshot.statusRecording = _patternRecording->getStatus ();
+      auto const numTicks = _patternRecording->getNumTicks ();
+      if (numTicks > 0)
+        snapshot.recordingProgress
+            = static_cast<float> (_patternRecording->getLastUpdatedTick ())
+              / static_cast<float> (numTicks);
+    }
 
-  return step;
+  snapshot.now = _now;
+  _snapshots.publish ();
 }
 
 void
@@ -21,9 +21,14 @@
 #pragma once
 
 #include <a3-motion-engine/AsyncCommandQueue.hh>
+#include <a3-motion-engine/ChannelGroup.hh>
+#include <a3-motion-engine/EngineSnapshot.hh>
 #include <a3-motion-engine/Master.hh>
+#include <a3-motion-engine/PatternTransform.hh>
+#include <a3-motion-engine/RecordingJournal.hh>
 #include <a3-motion-engine/tempo/TempoClock.hh>
 #include <a3-motion-engine/util/Helpers.hh>
+#include <a3-motion-engine/util/TripleBuffer.hh>
 
 namespace a3
 {
@@ -31,11 +36,18 @@ namespace a3
 class Channel;
 class Pattern;
 class HeightMap;
+class Session;
 
 class MotionEngine
 {
 public:
   MotionEngine (index_t numChannels, const HeightMap &heightMap);
+  // For simulation and testing, the backend receiving the motion
+  // commands and the time source driving the tempo clock can be
+  // injected.
+  MotionEngine (index_t numChannels, const HeightMap &heightMap,
+                std::unique_ptr<SpatBackend> backend,
+                std::shared_ptr<TimeSource> timeSource);
   ~MotionEngine ();
 
   TempoClock const &getTempoClock () const;
@@ -44,6 +56,14 @@ public:
   // TODO refactor to access channels directly
   index_t getNumChannels ();
 
+  /* Copies the engine state published at the end of the latest tick.
+   * This never blocks the tick thread and returns the state of all
+   * channels and patterns at the same tick. The snapshot is read
+   * through a single-consumer buffer, so all callers have to run on
+   * the same thread, usually the message thread.
+   */
+  void getSnapshot (EngineSnapshot &snapshot);
+
   Pos getChannelPosition (index_t channel);
   void setChannel2DPosition (index_t channel, Pos const &position);
   void setChannel3DPosition (index_t channel, Pos const &position);
@@ -54,6 +74,25 @@ public:
   int getChannelAmbisonicsOrder (index_t channel);
   void setChannelAmbisonicsOrder (index_t channel, int order);
 
+  // Transform applied to the patterns played by a channel, takes
+  // effect with the next tick. The current one is in the snapshot.
+  void setChannelTransform (index_t channel,
+                            PatternTransform const &transform);
+
+  /* Moves the given channels together as a group, replacing a
+   * previous group of the same index. The formation is taken from
+   * the current channel positions. Each tick the group pose overrides
+   * the positions of its members, patterns played on them have no
+   * effect while grouped. The leader's rotation since the group was
+   * picked up by the tick thread rotates the group, a leader that is
+   * also listed as a member is removed from the members.
+   */
+  static constexpr index_t maxNumChannelGroups = 8;
+  void setChannelGroup (index_t group, std::vector<index_t> channels,
+                        std::optional<index_t> leader = std::nullopt);
+  void releaseChannelGroup (index_t group);
+  void setChannelGroupPose (index_t group, ChannelGroup::Pose const &pose);
+
   enum class RecordingMode
   {
     Loop,
@@ -68,19 +107,25 @@ public:
   void setRecordingMode (RecordingMode recordingMode);
   RecordingMode getRecordingMode () const;
 
-  bool isRecording () const;
-  std::shared_ptr<Pattern> getRecordingPattern ();
-
   void recordPattern (std::shared_ptr<Pattern> pattern, //
                       Measure timepoint, Measure length);
 
+  // Recorded ticks are journaled by pattern id once the journal is
+  // opened.
+  RecordingJournal &getRecordingJournal ();
+
   // Playback
-  std::shared_ptr<Pattern> getPlayingPattern (index_t channel);
   void playPattern (std::shared_ptr<Pattern> pattern, Measure timepoint);
 
   // Stop
   void stopPattern (std::shared_ptr<Pattern> pattern, Measure timepoint);
 
+  /* Stops all patterns and applies the engine parameters of a
+   * restored session at once on the tick thread. The tempo is set
+   * right away, the clock picks it up with the next tick.
+   */
+  void restoreSession (std::shared_ptr<Session const> session);
+
   class PatternStatusMessage : public juce::Message
   {
   public:
@@ -123,9 +168,13 @@ private:
       SetRecordingPosition,
       ReleaseRecordingPosition,
       SetRecordingMode,
+      SetChannelTransform,
+      SetChannelGroup,
+      SetChannelGroupPose,
       StartRecording,
       StartPlaying,
       Stop,
+      RestoreSession,
     } command;
 
     Pos position;
@@ -134,6 +183,14 @@ private:
     Measure length;
 
     RecordingMode recordingMode;
+    std::shared_ptr<Session const> session;
+
+    index_t channel = 0;
+    PatternTransform transform;
+
+    index_t group = 0;
+    std::shared_ptr<ChannelGroup const> channelGroup;
+    ChannelGroup::Pose pose;
 
     friend bool
     operator> (const Message &lhs, const Message &rhs)
@@ -159,13 +216,18 @@ private:
   void startRecording (std::shared_ptr<Pattern> pattern, Measure length);
   void startPlaying (std::shared_ptr<Pattern> pattern);
   void stop (std::shared_ptr<Pattern> pattern);
+  void applySession (Session const &session);
 
   std::priority_queue<Message, std::vector<Message>, std::greater<Message> >
       _messagesStartStop;
 
   void performRecording ();
   void performPlayback ();
-  index_t updatePlayPosition (Pattern &pattern);
+  // advances and returns the play position in [0, 1)
+  float updatePlayPosition (Pattern &pattern);
+  void performChannelGroups ();
+
+  void publishSnapshot ();
 
   Measure _now;
   Measure _recordingStarted;
@@ -179,15 +241,32 @@ private:
   std::shared_ptr<Pattern> _patternRecording;
   std::shared_ptr<Pattern> _patternScheduledForRecording;
 
+  struct ChannelGroupState
+  {
+    std::shared_ptr<ChannelGroup const> group;
+    ChannelGroup::Pose pose;
+    // azimuth of the leader on the first tick of the group
+    std::optional<float> azimuthLeaderInitial;
+  };
+  // accessed by the tick thread only, releasing a group may
+  // deallocate it there, see the note above.
+  std::array<ChannelGroupState, maxNumChannelGroups> _channelGroups;
+  // member positions computed by ChannelGroup::place
+  std::vector<float> _channelGroupX;
+  std::vector<float> _channelGroupY;
+
+  RecordingJournal _recordingJournal;
+  std::uint32_t _numRecordingsStarted = 0;
+
   // The command dispatcher runs on its own high-priority thread and
   // receives motion / effect commands from the high-prio TempoClock
   // thread via a lockless command queue. It passes the messages to a
   // backend implementation that in turn performs the network
   // communication.
   AsyncCommandQueue _commandQueue;
-  std::vector<Pos> _lastSentPositions;
-  std::vector<float> _lastSentWidths;
-  std::vector<int> _lastSentAmbisonicsOrders;
+
+  // written by the tick thread, read by getSnapshot
+  TripleBuffer<EngineSnapshot> _snapshots;
 
   void notifyPatternStatusListeners (PatternStatusMessage::Status status,
                                      std::shared_ptr<Pattern> pattern);
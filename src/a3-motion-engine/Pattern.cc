@@ -23,21 +23,31 @@
 namespace a3
 {
 
-// TODO default-initializing to channel 0 is not clean. Needs to be
-// redesigned. Patterns should be channel-agnostic to begin with.
-Pattern::Pattern () : _channel (0) {}
+// TODO default-initializing to channel 0 is not clean. The owner of
+// the slot should assign the channel on construction.
+Pattern::Pattern () : _channel (0), _buffer (std::make_shared<TickBuffer> ())
+{
+}
 
 void
 Pattern::clear ()
 {
-  std::fill (_ticks.begin (), _ticks.end (), Pos::invalid);
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  auto const numTicks = getNumTicksLocked ();
+  if (_buffer.use_count () > 1 || _buffer->shape)
+    _buffer = std::make_shared<TickBuffer> ();
+  _buffer->ticks.assign (numTicks, Pos::invalid);
+  _versionRunStart = ++_version;
 }
 
 void
 Pattern::resize (index_t lengthTicks)
 {
   std::lock_guard<std::mutex> guard (_ticksMutex);
-  _ticks.resize (lengthTicks, Pos::invalid);
+  if (_buffer->shape)
+    _buffer = std::make_shared<TickBuffer> ();
+  detachLocked ().ticks.resize (lengthTicks, Pos::invalid);
+  _versionRunStart = ++_version;
 }
 
 void
@@ -76,28 +86,81 @@ Pattern::getChannel () const
   return _channel;
 }
 
+void
+Pattern::setId (std::uint32_t id)
+{
+  _id = id;
+}
+
+std::uint32_t
+Pattern::getId () const
+{
+  return _id;
+}
+
+void
+Pattern::shareTicks (Pattern const &source)
+{
+  if (&source == this)
+    return;
+
+  std::shared_ptr<TickBuffer> buffer;
+  {
+    std::lock_guard<std::mutex> guard (source._ticksMutex);
+    buffer = source._buffer;
+  }
+
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  _buffer = std::move (buffer);
+  _lastUpdatedTick = 0;
+  _versionRunStart = ++_version;
+}
+
+bool
+Pattern::isSharingTicks () const
+{
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  return _buffer.use_count () > 1;
+}
+
 index_t
 Pattern::getNumTicks () const
 {
   std::lock_guard<std::mutex> guard (_ticksMutex);
-  return _ticks.size ();
+  return getNumTicksLocked ();
 }
 
 Pos
 Pattern::getTick (index_t tick) const
 {
-  jassert (tick < _ticks.size ());
   std::lock_guard<std::mutex> guard (_ticksMutex);
-  return _ticks[tick];
+  jassert (tick < getNumTicksLocked ());
+  return getTickLocked (tick);
 }
 
 void
 Pattern::setTick (index_t tick, Pos position)
 {
-  jassert (tick < _ticks.size ());
   std::lock_guard<std::mutex> guard (_ticksMutex);
-  _ticks[tick] = position;
+  materializeLocked ();
+  auto &ticks = detachLocked ().ticks;
+  jassert (tick < ticks.size ());
+  ticks[tick] = position;
+
+  if (tick != (_lastUpdatedTick + 1) % ticks.size ())
+    _versionRunStart = _version;
   _lastUpdatedTick = tick;
+  ++_version;
+}
+
+void
+Pattern::setTicks (std::vector<Pos> ticks)
+{
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  _buffer = std::make_shared<TickBuffer> ();
+  _buffer->ticks = std::move (ticks);
+  _lastUpdatedTick = 0;
+  _versionRunStart = ++_version;
 }
 
 index_t
@@ -107,13 +170,103 @@ Pattern::getLastUpdatedTick () const
   return _lastUpdatedTick;
 }
 
+void
+Pattern::setShape (std::shared_ptr<PatternShape const> shape,
+                   index_t numTicks)
+{
+  jassert (shape != nullptr);
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  _buffer = std::make_shared<TickBuffer> ();
+  _buffer->shape = std::move (shape);
+  _buffer->numTicksShape = numTicks;
+  _lastUpdatedTick = 0;
+  _versionRunStart = ++_version;
+}
+
+bool
+Pattern::isProcedural () const
+{
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  return _buffer->shape != nullptr;
+}
+
+void
+Pattern::materialize ()
+{
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  materializeLocked ();
+}
+
+Pos
+Pattern::getPosition (float phase) const
+{
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+  if (_buffer->shape)
+    return _buffer->shape->evaluate (phase);
+
+  auto const &ticks = _buffer->ticks;
+  if (ticks.empty ())
+    return Pos::invalid;
+
+  // the phase may round up to 1 when converted from double
+  auto const tick = std::min (static_cast<index_t> (phase * ticks.size ()),
+                              static_cast<index_t> (ticks.size () - 1));
+  return ticks[tick];
+}
+
 Pattern::Ticks
 Pattern::getTicks () const
 {
   // for now we just lock and return a copy while benchmarking and
   // thinking of a better solution.
   std::lock_guard<std::mutex> guard (_ticksMutex);
-  return { _ticks, _lastUpdatedTick };
+  if (!_buffer->shape)
+    return { _buffer->ticks, _lastUpdatedTick, _version };
+
+  std::vector<Pos> positions (_buffer->numTicksShape);
+  for (auto tick = 0u; tick < positions.size (); ++tick)
+    positions[tick] = getTickLocked (tick);
+  return { std::move (positions), _lastUpdatedTick, _version };
+}
+
+std::uint64_t
+Pattern::getVersion () const
+{
+  return _version;
+}
+
+Pattern::DirtyRange
+Pattern::getDirtyTicks (std::uint64_t sinceVersion,
+                        std::vector<Pos> &positions) const
+{
+  std::lock_guard<std::mutex> guard (_ticksMutex);
+
+  auto const numTicksTotal = getNumTicksLocked ();
+  auto const version = _version.load ();
+
+  auto range = DirtyRange{ 0, 0, version, false };
+  if (sinceVersion > version || sinceVersion < _versionRunStart
+      || version - sinceVersion >= numTicksTotal)
+    {
+      range.complete = true;
+      range.numTicks = numTicksTotal;
+    }
+  else
+    {
+      range.numTicks = static_cast<index_t> (version - sinceVersion);
+    }
+
+  positions.clear ();
+  if (numTicksTotal == 0)
+    return range;
+
+  range.firstTick = (_lastUpdatedTick + 1 + numTicksTotal - range.numTicks)
+                    % numTicksTotal;
+  for (auto offset = 0u; offset < range.numTicks; ++offset)
+    positions.push_back (
+        getTickLocked ((range.firstTick + offset) % numTicksTotal));
+
+  return range;
 }
 
 Measure
@@ -140,4 +293,39 @@ Pattern::setPlayPosition (float playPosition)
   _playPosition = playPosition;
 }
 
+index_t
+Pattern::getNumTicksLocked () const
+{
+  return _buffer->shape ? _buffer->numTicksShape : _buffer->ticks.size ();
+}
+
+Pos
+Pattern::getTickLocked (index_t tick) const
+{
+  if (_buffer->shape)
+    return _buffer->shape->evaluate (float (tick) / _buffer->numTicksShape);
+  return _buffer->ticks[tick];
+}
+
+Pattern::TickBuffer &
+Pattern::detachLocked ()
+{
+  if (_buffer.use_count () > 1)
+    _buffer = std::make_shared<TickBuffer> (*_buffer);
+  return *_buffer;
+}
+
+void
+Pattern::materializeLocked ()
+{
+  if (!_buffer->shape)
+    return;
+
+  auto buffer = std::make_shared<TickBuffer> ();
+  buffer->ticks.resize (_buffer->numTicksShape);
+  for (auto tick = 0u; tick < buffer->ticks.size (); ++tick)
+    buffer->ticks[tick] = getTickLocked (tick);
+  _buffer = std::move (buffer);
+}
+
 }
@@ -20,12 +20,19 @@
 
 #pragma once
 
+#include <a3-motion-engine/PatternShape.hh>
 #include <a3-motion-engine/tempo/TempoClock.hh>
 #include <a3-motion-engine/util/Types.hh>
 
 namespace a3
 {
 
+/* A pattern is a playback slot: its status, channel and play position
+ * belong to the slot, while the tick data can be shared with other
+ * patterns through shareTicks, e.g. to play one gesture on several
+ * channels. Shared tick data is never modified, the first write to a
+ * shared pattern copies it (copy-on-write).
+ */
 class Pattern
 {
 public:
@@ -54,20 +61,72 @@ public:
   void setChannel (index_t channel);
   index_t getChannel () const;
 
+  // Makes this pattern play the tick data of 'source' without copying
+  // it. Status, channel and play position are left unchanged.
+  void shareTicks (Pattern const &source);
+  bool isSharingTicks () const;
+
+  // identifies the pattern in the recording journal, assigned by the
+  // owner of the pattern
+  void setId (std::uint32_t id);
+  std::uint32_t getId () const;
+
   index_t getNumTicks () const;
   Pos getTick (index_t tick) const;
   void setTick (index_t tick, Pos position);
+  // replaces all ticks at once, e.g. when restoring a session
+  void setTicks (std::vector<Pos> ticks);
   index_t getLastUpdatedTick () const;
 
+  /* Procedural patterns hold a shape instead of tick data. The tick
+   * accessors evaluate the shape at the tick phases of the nominal
+   * length, playback evaluates it at the exact play position via
+   * getPosition. Modifying a tick materializes the pattern, as does
+   * clearing or resizing it for recording.
+   */
+  void setShape (std::shared_ptr<PatternShape const> shape,
+                 index_t numTicks);
+  bool isProcedural () const;
+  // evaluates the shape into tick data and drops it
+  void materialize ();
+
+  // position at a phase in [0, 1), for tick data the tick covering it
+  Pos getPosition (float phase) const;
+
+  // The version is incremented on every modification of the tick
+  // data, so consumers can cheaply detect whether cached derived data
+  // (e.g. preview geometry) is still up to date.
+  std::uint64_t getVersion () const;
+
   // The Ticks struct enables us to atomically return the positions
-  // together with the last updated value.
+  // together with the last updated value and the version.
   struct Ticks
   {
     std::vector<Pos> positions;
     index_t lastUpdatedTick;
+    std::uint64_t version;
   };
   Ticks getTicks () const;
 
+  /* Ticks modified after a given version. Recording writes ticks
+   * sequentially, so the modifications form a contiguous (possibly
+   * wrapping) range that ends at the last updated tick. If that does
+   * not hold since the given version, e.g. because the pattern was
+   * cleared or resized, the whole pattern is reported as dirty,
+   * starting after the last updated tick.
+   */
+  struct DirtyRange
+  {
+    index_t firstTick;
+    index_t numTicks;
+    std::uint64_t version;
+    bool complete;
+  };
+  // Copies the positions of the dirty range into 'positions', which
+  // callers can reuse to avoid allocations.
+  DirtyRange getDirtyTicks (std::uint64_t sinceVersion,
+                            std::vector<Pos> &positions) const;
+
   Measure getPlaybackLength () const;
   void setPlaybackLength (Measure playbackLength);
 
@@ -75,18 +134,42 @@ public:
   void setPlayPosition (float playPosition);
 
 private:
+  struct TickBuffer
+  {
+    std::vector<Pos> ticks;
+    // procedural patterns leave ticks empty
+    std::shared_ptr<PatternShape const> shape;
+    index_t numTicksShape = 0;
+  };
+
+  // callers hold _ticksMutex
+  index_t getNumTicksLocked () const;
+  Pos getTickLocked (index_t tick) const;
+  // makes _buffer exclusive to this pattern before modifying it
+  TickBuffer &detachLocked ();
+  void materializeLocked ();
+
   static_assert (std::atomic<Status>::is_always_lock_free);
   std::atomic<Status> _status = Status::Empty;
   std::atomic<Status> _statusLast = Status::Empty;
 
-  // for now patterns are fixed to a channel, this will probably
-  // change later on.
+  // the channel this slot plays on, the tick data is channel-agnostic
   std::atomic<index_t> _channel;
+  std::atomic<std::uint32_t> _id = 0;
 
-  index_t _lastUpdatedTick;
-  std::vector<Pos> _ticks;
+  index_t _lastUpdatedTick = 0;
+  // Other patterns only obtain a reference while holding our
+  // _ticksMutex, so a use count of one can not increase concurrently
+  // and the buffer may be modified in place.
+  std::shared_ptr<TickBuffer> _buffer;
   mutable std::mutex _ticksMutex;
 
+  static_assert (std::atomic<std::uint64_t>::is_always_lock_free);
+  std::atomic<std::uint64_t> _version = 0;
+  // all modifications after this version were sequential ticks
+  // ending at _lastUpdatedTick, guarded by _ticksMutex
+  std::uint64_t _versionRunStart = 0;
+
   // TODO is float precision sufficient here? do the math!
   static_assert (std::atomic<float>::is_always_lock_free);
   std::atomic<float> _playPosition = 0.;
@@ -0,0 +1,480 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PatternBank.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/util/Helpers.hh>
+
+namespace a3
+{
+
+namespace
+{
+
+constexpr char magicBank[8] = { 'A', '3', 'B', 'A', 'N', 'K', 0, 0 };
+// "A3WL" read as a little-endian integer
+constexpr std::uint32_t magicRecord = 0x4c573341;
+constexpr std::uint64_t alignment = 16;
+constexpr std::uint64_t bytesPerTick = 3 * sizeof (float);
+
+struct Header
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t numEntries;
+  std::uint64_t fileSize;
+  std::uint64_t reserved;
+};
+
+struct IndexEntry
+{
+  std::uint32_t slot;
+  std::uint32_t numTicks;
+  std::uint64_t offsetTicks;
+  std::int32_t playbackLength[3];
+  std::uint32_t reserved;
+};
+
+// a log record is followed by its ticks, padded to the alignment
+struct RecordHeader
+{
+  std::uint32_t magic;
+  std::uint32_t slot;
+  std::uint32_t numTicks;
+  std::int32_t playbackLength[3];
+  // CRC-32 of the header with this field zeroed and the ticks
+  std::uint32_t checksum;
+  std::uint32_t reserved;
+};
+
+static_assert (sizeof (Header) % alignment == 0);
+static_assert (sizeof (IndexEntry) % alignment == 0);
+static_assert (sizeof (RecordHeader) % alignment == 0);
+static_assert (std::is_trivially_copyable_v<Header>
+               && std::is_trivially_copyable_v<IndexEntry>
+               && std::is_trivially_copyable_v<RecordHeader>);
+
+std::uint64_t
+align (std::uint64_t size)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+std::uint32_t
+checksumRecord (RecordHeader header, std::uint8_t const *ticks)
+{
+  header.checksum = 0;
+  auto const crc = crc32 (&header, sizeof (header));
+  return crc32 (ticks, header.numTicks * bytesPerTick, crc);
+}
+
+void
+logError (juce::String const &what, std::string const &path)
+{
+  juce::Logger::writeToLog ("PatternBank: " + what + " " + path + ": "
+                            + std::strerror (errno));
+}
+
+bool
+writeAll (int fd, std::uint8_t const *data, std::uint64_t size,
+          std::uint64_t offset)
+{
+  while (size > 0)
+    {
+      auto const numWritten = ::pwrite (fd, data, size, off_t (offset));
+      if (numWritten < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return false;
+        }
+      data += numWritten;
+      size -= std::uint64_t (numWritten);
+      offset += std::uint64_t (numWritten);
+    }
+  return true;
+}
+
+void
+writeTicks (std::vector<Pos> const &ticks, std::uint8_t *destination)
+{
+  for (auto const &tick : ticks)
+    {
+      float const xyz[3] = { tick.x (), tick.y (), tick.z () };
+      std::memcpy (destination, xyz, bytesPerTick);
+      destination += bytesPerTick;
+    }
+}
+
+}
+
+PatternBank::PatternBank () {}
+
+PatternBank::~PatternBank () { close (); }
+
+bool
+PatternBank::open (std::string const &path)
+{
+  close ();
+
+  // the format is defined as little-endian and mapped as is
+  if (juce::ByteOrder::isBigEndian ())
+    {
+      juce::Logger::writeToLog ("PatternBank: big-endian hosts are not "
+                                "supported");
+      return false;
+    }
+
+  _path = path;
+  _bank.fd = ::open (_path.c_str (), O_RDONLY | O_CLOEXEC);
+  if (_bank.fd < 0 && errno != ENOENT)
+    {
+      logError ("could not open", _path);
+      close ();
+      return false;
+    }
+  if (_bank.fd >= 0 && !(map (_bank) && readBank ()))
+    {
+      juce::Logger::writeToLog ("PatternBank: could not read " + _path);
+      close ();
+      return false;
+    }
+
+  auto const pathLog = _path + ".wal";
+  _log.fd = ::open (pathLog.c_str (), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (_log.fd < 0 || !map (_log) || !replayLog ())
+    {
+      logError ("could not open", pathLog);
+      close ();
+      return false;
+    }
+
+  return true;
+}
+
+void
+PatternBank::close ()
+{
+  for (auto *file : { &_bank, &_log })
+    {
+      unmap (*file);
+      if (file->fd >= 0)
+        ::close (file->fd);
+      file->fd = -1;
+    }
+  _entries.clear ();
+}
+
+bool
+PatternBank::isOpen () const
+{
+  return _log.fd >= 0;
+}
+
+std::vector<std::uint32_t>
+PatternBank::getSlots () const
+{
+  std::vector<std::uint32_t> slots;
+  slots.reserve (_entries.size ());
+  for (auto const &[slot, entry] : _entries)
+    slots.push_back (slot);
+  return slots;
+}
+
+bool
+PatternBank::contains (std::uint32_t slot) const
+{
+  return _entries.count (slot) > 0;
+}
+
+bool
+PatternBank::load (std::uint32_t slot, Pattern &pattern) const
+{
+  auto const it = _entries.find (slot);
+  if (it == _entries.end ())
+    return false;
+
+  auto const &entry = it->second;
+  auto const *ticks
+      = (entry.inLog ? _log.data : _bank.data) + entry.offsetTicks;
+
+  pattern.resize (entry.numTicks);
+  for (auto tick = 0u; tick < entry.numTicks; ++tick)
+    {
+      float xyz[3];
+      std::memcpy (xyz, ticks + tick * bytesPerTick, bytesPerTick);
+      pattern.setTick (tick, Pos::fromCartesian (xyz[0], xyz[1], xyz[2]));
+    }
+  pattern.setPlaybackLength (entry.playbackLength);
+  return true;
+}
+
+bool
+PatternBank::store (std::uint32_t slot, Pattern const &pattern)
+{
+  jassert (isOpen ());
+  if (!isOpen ())
+    return false;
+
+  auto const ticks = pattern.getTicks ().positions;
+  auto const playbackLength = pattern.getPlaybackLength ();
+
+  RecordHeader header{};
+  header.magic = magicRecord;
+  header.slot = slot;
+  header.numTicks = std::uint32_t (ticks.size ());
+  header.playbackLength[0] = playbackLength.bar ();
+  header.playbackLength[1] = playbackLength.beat ();
+  header.playbackLength[2] = playbackLength.tick ();
+
+  std::vector<std::uint8_t> record (
+      sizeof (header) + align (ticks.size () * bytesPerTick), 0);
+  writeTicks (ticks, record.data () + sizeof (header));
+  header.checksum = checksumRecord (header, record.data () + sizeof (header));
+  std::memcpy (record.data (), &header, sizeof (header));
+
+  auto const offset = _log.size;
+  if (!writeAll (_log.fd, record.data (), record.size (), offset)
+      || !syncFileData (_log.fd))
+    {
+      logError ("could not write", _path + ".wal");
+      // keep the log free of partial records for later appends
+      if (::ftruncate (_log.fd, off_t (offset)) != 0)
+        logError ("could not truncate", _path + ".wal");
+      return false;
+    }
+
+  unmap (_log);
+  if (!map (_log))
+    {
+      logError ("could not map", _path + ".wal");
+      return false;
+    }
+
+  _entries[slot]
+      = { true, header.numTicks, offset + sizeof (header), playbackLength };
+  return true;
+}
+
+bool
+PatternBank::compact ()
+{
+  jassert (isOpen ());
+  if (!isOpen ())
+    return false;
+
+  auto const sizeIndex
+      = sizeof (Header) + _entries.size () * sizeof (IndexEntry);
+  auto sizeFile = sizeIndex;
+  for (auto const &[slot, entry] : _entries)
+    sizeFile += align (entry.numTicks * bytesPerTick);
+
+  std::vector<std::uint8_t> contents (sizeFile, 0);
+
+  Header header{};
+  std::memcpy (header.magic, magicBank, sizeof (magicBank));
+  header.version = formatVersion;
+  header.numEntries = std::uint32_t (_entries.size ());
+  header.fileSize = sizeFile;
+  std::memcpy (contents.data (), &header, sizeof (header));
+
+  auto offsetIndex = sizeof (Header);
+  auto offsetTicks = sizeIndex;
+  for (auto const &[slot, entry] : _entries)
+    {
+      IndexEntry indexEntry{};
+      indexEntry.slot = slot;
+      indexEntry.numTicks = entry.numTicks;
+      indexEntry.offsetTicks = offsetTicks;
+      indexEntry.playbackLength[0] = entry.playbackLength.bar ();
+      indexEntry.playbackLength[1] = entry.playbackLength.beat ();
+      indexEntry.playbackLength[2] = entry.playbackLength.tick ();
+      std::memcpy (contents.data () + offsetIndex, &indexEntry,
+                   sizeof (indexEntry));
+      offsetIndex += sizeof (indexEntry);
+
+      auto const *ticks
+          = (entry.inLog ? _log.data : _bank.data) + entry.offsetTicks;
+      std::memcpy (contents.data () + offsetTicks, ticks,
+                   entry.numTicks * bytesPerTick);
+      offsetTicks += align (entry.numTicks * bytesPerTick);
+    }
+
+  // write a new bank file and rename it over the old one, so a crash
+  // leaves either of them in place together with the log.
+  auto const pathTemporary = _path + ".tmp";
+  auto const fd = ::open (pathTemporary.c_str (),
+                          O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    {
+      logError ("could not create", pathTemporary);
+      return false;
+    }
+  auto const written = writeAll (fd, contents.data (), contents.size (), 0)
+                       && ::fsync (fd) == 0;
+  ::close (fd);
+  if (!written || ::rename (pathTemporary.c_str (), _path.c_str ()) != 0)
+    {
+      logError ("could not write", _path);
+      ::unlink (pathTemporary.c_str ());
+      return false;
+    }
+
+  auto const separator = _path.rfind ('/');
+  auto const pathDirectory
+      = separator == std::string::npos ? "." : _path.substr (0, separator + 1);
+  auto const fdDirectory = ::open (pathDirectory.c_str (), O_RDONLY);
+  if (fdDirectory >= 0)
+    {
+      ::fsync (fdDirectory);
+      ::close (fdDirectory);
+    }
+
+  // the log is only emptied once the new bank file is durable
+  auto const path = _path;
+  if (::ftruncate (_log.fd, 0) != 0 || !syncFileData (_log.fd))
+    logError ("could not truncate", _path + ".wal");
+
+  return open (path);
+}
+
+std::uint64_t
+PatternBank::getLogSize () const
+{
+  return _log.size;
+}
+
+bool
+PatternBank::map (MappedFile &file)
+{
+  struct stat status;
+  if (::fstat (file.fd, &status) != 0)
+    return false;
+
+  file.size = std::uint64_t (status.st_size);
+  if (file.size == 0)
+    return true;
+
+  auto *data = ::mmap (nullptr, file.size, PROT_READ, MAP_SHARED, file.fd, 0);
+  if (data == MAP_FAILED)
+    {
+      file.size = 0;
+      return false;
+    }
+  file.data = static_cast<std::uint8_t *> (data);
+  return true;
+}
+
+void
+PatternBank::unmap (MappedFile &file)
+{
+  if (file.data)
+    ::munmap (file.data, file.size);
+  file.data = nullptr;
+  file.size = 0;
+}
+
+bool
+PatternBank::readBank ()
+{
+  Header header;
+  if (_bank.size < sizeof (header))
+    return false;
+  std::memcpy (&header, _bank.data, sizeof (header));
+
+  if (std::memcmp (header.magic, magicBank, sizeof (magicBank)) != 0
+      || header.version != formatVersion || header.fileSize != _bank.size
+      || header.numEntries
+             > (_bank.size - sizeof (header)) / sizeof (IndexEntry))
+    return false;
+
+  for (auto index = 0u; index < header.numEntries; ++index)
+    {
+      IndexEntry indexEntry;
+      std::memcpy (&indexEntry,
+                   _bank.data + sizeof (header) + index * sizeof (indexEntry),
+                   sizeof (indexEntry));
+
+      if (indexEntry.offsetTicks % alignment != 0
+          || indexEntry.offsetTicks > _bank.size
+          || indexEntry.numTicks
+                 > (_bank.size - indexEntry.offsetTicks) / bytesPerTick)
+        return false;
+
+      _entries[indexEntry.slot]
+          = { false, indexEntry.numTicks, indexEntry.offsetTicks,
+              Measure (indexEntry.playbackLength[0],
+                       indexEntry.playbackLength[1],
+                       indexEntry.playbackLength[2]) };
+    }
+  return true;
+}
+
+bool
+PatternBank::replayLog ()
+{
+  std::uint64_t offset = 0;
+  while (offset + sizeof (RecordHeader) <= _log.size)
+    {
+      RecordHeader header;
+      std::memcpy (&header, _log.data + offset, sizeof (header));
+
+      auto const offsetTicks = offset + sizeof (header);
+      auto const sizeTicks = std::uint64_t (header.numTicks) * bytesPerTick;
+      if (header.magic != magicRecord
+          || align (sizeTicks) > _log.size - offsetTicks
+          || header.checksum
+                 != checksumRecord (header, _log.data + offsetTicks))
+        break;
+
+      _entries[header.slot]
+          = { true, header.numTicks, offsetTicks,
+              Measure (header.playbackLength[0], header.playbackLength[1],
+                       header.playbackLength[2]) };
+      offset = offsetTicks + align (sizeTicks);
+    }
+
+  if (offset != _log.size)
+    {
+      // all records up to here were synced before the next one was
+      // started, so this is the tail of an interrupted store ().
+      juce::Logger::writeToLog ("PatternBank: discarding "
+                                + juce::String (_log.size - offset)
+                                + " bytes of a torn log record");
+      unmap (_log);
+      if (::ftruncate (_log.fd, off_t (offset)) != 0 || !map (_log))
+        return false;
+    }
+  return true;
+}
+
+}
@@ -0,0 +1,110 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <a3-motion-engine/Measure.hh>
+
+namespace a3
+{
+
+class Pattern;
+
+/* Pattern bank on disk. The bank file stores a header, an index of
+ * the stored slots and the tick arrays of the patterns, each array
+ * 16 byte aligned and all values little-endian:
+ *
+ *   Header   magic "A3BANK", version, number of entries, file size
+ *   Index    per entry: slot, number of ticks, offset of the ticks,
+ *            playback length
+ *   Ticks    per entry: x, y, z as 32 bit floats per tick
+ *
+ * The bank file is memory-mapped, opening it only reads the index and
+ * the ticks of a pattern are paged in when it is loaded. Stored
+ * patterns are appended to a write-ahead log next to the bank file
+ * (path + ".wal") as checksummed records, which are replayed when the
+ * bank is opened. A record that was torn by a crash is discarded.
+ * compact () merges the log into a new bank file that atomically
+ * replaces the old one and empties the log.
+ *
+ * Slots are plain numbers, the caller decides what they refer to.
+ */
+class PatternBank
+{
+public:
+  static constexpr std::uint32_t formatVersion = 1;
+
+  PatternBank ();
+  ~PatternBank ();
+
+  // Opens the bank at 'path', creating it if it does not exist.
+  // Returns false if the files can not be accessed or the bank file
+  // is corrupted.
+  bool open (std::string const &path);
+  void close ();
+  bool isOpen () const;
+
+  // sorted slot numbers of the stored patterns
+  std::vector<std::uint32_t> getSlots () const;
+  bool contains (std::uint32_t slot) const;
+
+  // Copies the ticks and playback length of a stored pattern into
+  // 'pattern', replacing its content. The status is left untouched.
+  bool load (std::uint32_t slot, Pattern &pattern) const;
+  // Appends the pattern to the log and syncs it to disk.
+  bool store (std::uint32_t slot, Pattern const &pattern);
+
+  // Rewrites the bank file including all logged patterns.
+  bool compact ();
+  std::uint64_t getLogSize () const;
+
+private:
+  struct MappedFile
+  {
+    int fd = -1;
+    std::uint8_t *data = nullptr;
+    std::uint64_t size = 0;
+  };
+  static bool map (MappedFile &file);
+  static void unmap (MappedFile &file);
+
+  bool readBank ();
+  bool replayLog ();
+
+  struct Entry
+  {
+    bool inLog = false;
+    std::uint32_t numTicks = 0;
+    std::uint64_t offsetTicks = 0;
+    Measure playbackLength;
+  };
+  std::map<std::uint32_t, Entry> _entries;
+
+  std::string _path;
+  MappedFile _bank;
+  MappedFile _log;
+};
+
+}
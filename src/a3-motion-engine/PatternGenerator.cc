@@ -25,89 +25,137 @@
 namespace a3
 {
 
-std::unique_ptr<Pattern>
-PatternGenerator::createCircle (index_t lengthBeats, float radius,
-                                float degrees, HeightMap const &heightMap)
+namespace
+{
+
+class CircleShape : public PatternShape
+{
+public:
+  CircleShape (float radius, float degrees, HeightMap const &heightMap)
+      : _radius (radius), _degrees (degrees), _heightMap (heightMap)
+  {
+  }
+
+  Pos
+  evaluate (float phase) const override
+  {
+    auto position = Pos::fromSpherical (phase * _degrees, 0.f, _radius);
+    position.setZ (_heightMap.computeHeight (position));
+    return position;
+  }
+
+private:
+  float _radius;
+  float _degrees;
+  HeightMap const &_heightMap;
+};
+
+class FigureOfEightShape : public PatternShape
 {
-  std::unique_ptr<Pattern> pattern = std::make_unique<Pattern> ();
+public:
+  FigureOfEightShape (float radius, HeightMap const &heightMap)
+      : _radius (radius), _heightMap (heightMap)
+  {
+  }
+
+  Pos
+  evaluate (float phase) const override
+  {
+    auto constexpr offsetX = 0.05; // avoid azimuth singularity
+    auto y = _radius * std::sin (phase * 2.f * pi<float> ());
+    auto x = _radius * std::sin (phase * 4.f * pi<float> ()) + offsetX;
+
+    auto position = Pos::fromCartesian (x, y, 0);
+    position.setZ (_heightMap.computeHeight (position));
+    return position;
+  }
+
+private:
+  float _radius;
+  HeightMap const &_heightMap;
+};
+
+/* Steps through the four corners. The last tick of each quadrant at
+ * the nominal length is left empty, which separates the corners in
+ * the pattern preview.
+ */
+class CornerStepShape : public PatternShape
+{
+public:
+  CornerStepShape (float radius, index_t numTicks,
+                   HeightMap const &heightMap)
+      : _radius (radius), _numTicksPerQuadrant (numTicks / 4),
+        _heightMap (heightMap)
+  {
+  }
+
+  Pos
+  evaluate (float phase) const override
+  {
+    auto const quadrant = std::min (static_cast<int> (phase * 4), 3);
+    auto const tickInQuadrant = static_cast<index_t> (
+        (phase * 4 - quadrant) * _numTicksPerQuadrant);
+    if (tickInQuadrant >= _numTicksPerQuadrant - 1)
+      return Pos::invalid;
+
+    auto const x = -_radius * (2 * (quadrant % 2) - 1) / std::sqrt (2.f);
+    auto const y = -_radius * (2 * (quadrant / 2) - 1) / std::sqrt (2.f);
+
+    auto position = Pos::fromCartesian (x, y, 0);
+    position.setZ (_heightMap.computeHeight (position));
+    return position;
+  }
+
+private:
+  float _radius;
+  index_t _numTicksPerQuadrant;
+  HeightMap const &_heightMap;
+};
 
-  auto const numTicks
-      = lengthBeats
-        * static_cast<std::size_t> (TempoClock::getTicksPerBeat ());
-  pattern->resize (numTicks);
+std::unique_ptr<Pattern>
+createProcedural (index_t numTicks, std::shared_ptr<PatternShape const> shape)
+{
+  auto pattern = std::make_unique<Pattern> ();
+  pattern->setShape (std::move (shape), numTicks);
   pattern->setStatus (Pattern::Status::Idle);
+  return pattern;
+}
+
+index_t
+getNumTicks (index_t lengthBeats)
+{
+  return lengthBeats
+         * static_cast<std::size_t> (TempoClock::getTicksPerBeat ());
+}
 
-  for (auto tick = 0u; tick < numTicks; ++tick)
-    {
-      auto phase = float (tick) / numTicks * degrees;
-      auto position = Pos::fromSpherical (phase, 0.f, radius);
-      position.setZ (heightMap.computeHeight (position));
-      pattern->setTick (tick, position);
-    }
+}
 
-  return pattern;
+std::unique_ptr<Pattern>
+PatternGenerator::createCircle (index_t lengthBeats, float radius,
+                                float degrees, HeightMap const &heightMap)
+{
+  return createProcedural (
+      getNumTicks (lengthBeats),
+      std::make_shared<CircleShape> (radius, degrees, heightMap));
 }
 
 std::unique_ptr<Pattern>
 PatternGenerator::createFigureOfEight (index_t lengthBeats, float radius,
                                        HeightMap const &heightMap)
 {
-  std::unique_ptr<Pattern> pattern = std::make_unique<Pattern> ();
-
-  auto const numTicks
-      = lengthBeats
-        * static_cast<std::size_t> (TempoClock::getTicksPerBeat ());
-  pattern->resize (numTicks);
-  pattern->setStatus (Pattern::Status::Idle);
-
-  for (auto tick = 0u; tick < numTicks; ++tick)
-    {
-      auto phase = float (tick) / numTicks;
-
-      auto constexpr offsetX = 0.05; // avoid azimuth singularity
-      auto y = radius * std::sin (phase * 2.f * pi<float> ());
-      auto x = radius * std::sin (phase * 4.f * pi<float> ()) + offsetX;
-
-      auto position = Pos::fromCartesian (x, y, 0);
-      position.setZ (heightMap.computeHeight (position));
-      pattern->setTick (tick, position);
-    }
-
-  return pattern;
+  return createProcedural (
+      getNumTicks (lengthBeats),
+      std::make_shared<FigureOfEightShape> (radius, heightMap));
 }
 
 std::unique_ptr<Pattern>
 PatternGenerator::createCornerStep (index_t lengthBeats, float radius,
                                     HeightMap const &heightMap)
 {
-  std::unique_ptr<Pattern> pattern = std::make_unique<Pattern> ();
-
-  auto const numTicks
-      = lengthBeats
-        * static_cast<std::size_t> (TempoClock::getTicksPerBeat ());
-  pattern->resize (numTicks);
-  pattern->setStatus (Pattern::Status::Idle);
-
-  auto const ticksPerQuadrant = numTicks / 4;
-  for (auto tick = 0u; tick < numTicks; ++tick)
-    {
-      if (tick % ticksPerQuadrant == ticksPerQuadrant - 1)
-        {
-          pattern->setTick (tick, Pos::invalid);
-        }
-      else
-        {
-          auto const quadrant = static_cast<int> (tick * 4 / numTicks);
-          auto const x = -radius * (2 * (quadrant % 2) - 1) / std::sqrt (2.f);
-          auto const y = -radius * (2 * (quadrant / 2) - 1) / std::sqrt (2.f);
-
-          auto position = Pos::fromCartesian (x, y, 0);
-          position.setZ (heightMap.computeHeight (position));
-          pattern->setTick (tick, position);
-        }
-    }
-
-  return pattern;
+  auto const numTicks = getNumTicks (lengthBeats);
+  return createProcedural (
+      numTicks,
+      std::make_shared<CornerStepShape> (radius, numTicks, heightMap));
 }
 
 }
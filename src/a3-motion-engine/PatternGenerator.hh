@@ -27,6 +27,10 @@ namespace a3
 
 class HeightMap;
 
+/* Creates procedural patterns that evaluate their shape during
+ * playback, the length in beats only sets the nominal tick count used
+ * for previews and when materializing the pattern.
+ */
 class PatternGenerator
 {
 public:
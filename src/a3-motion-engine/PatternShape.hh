@@ -0,0 +1,42 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Analytic description of a pattern's trajectory. Procedural patterns
+ * store a shape instead of tick data and are evaluated from the play
+ * phase in [0, 1), so they play back exactly at any playback length.
+ * Shapes are immutable and may be shared between threads.
+ */
+class PatternShape
+{
+public:
+  virtual ~PatternShape () = default;
+
+  // returns Pos::invalid where the pattern should not move the channel
+  virtual Pos evaluate (float phase) const = 0;
+};
+
+}
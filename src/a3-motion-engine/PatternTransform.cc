@@ -0,0 +1,102 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PatternTransform.hh"
+
+#include <cmath>
+
+namespace a3
+{
+
+PatternTransform::PatternTransform () {}
+
+PatternTransform::PatternTransform (float rotationDegrees, float scale,
+                                    bool mirror, bool reverse,
+                                    float phaseOffset)
+    : _rotationDegrees (rotationDegrees), _scale (scale), _mirror (mirror),
+      _reverse (reverse), _phaseOffset (phaseOffset)
+{
+  auto const angle = rotationDegrees * pi<float> () / 180.f;
+  auto const cosine = scale * std::cos (angle);
+  auto const sine = scale * std::sin (angle);
+  // mirroring negates y before the rotation
+  auto const signY = mirror ? -1.f : 1.f;
+  _matrix = { cosine, -sine * signY, sine, cosine * signY };
+}
+
+float
+PatternTransform::getRotationDegrees () const
+{
+  return _rotationDegrees;
+}
+
+float
+PatternTransform::getScale () const
+{
+  return _scale;
+}
+
+bool
+PatternTransform::isMirrored () const
+{
+  return _mirror;
+}
+
+bool
+PatternTransform::isReversed () const
+{
+  return _reverse;
+}
+
+float
+PatternTransform::getPhaseOffset () const
+{
+  return _phaseOffset;
+}
+
+bool
+PatternTransform::isIdentity () const
+{
+  return _rotationDegrees == 0.f && _scale == 1.f && !_mirror && !_reverse
+         && _phaseOffset == 0.f;
+}
+
+float
+PatternTransform::mapPhase (float phase) const
+{
+  if (_reverse)
+    phase = 1.f - phase;
+  phase += _phaseOffset;
+  phase -= std::floor (phase);
+
+  // rounding may end up at 1 for tiny negative phases
+  return phase < 1.f ? phase : 0.f;
+}
+
+Pos
+PatternTransform::apply (Pos const &position) const
+{
+  auto const x = position.x ();
+  auto const y = position.y ();
+  return Pos::fromCartesian (_matrix[0] * x + _matrix[1] * y,
+                             _matrix[2] * x + _matrix[3] * y, position.z ());
+}
+
+}
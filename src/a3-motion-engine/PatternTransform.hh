@@ -0,0 +1,73 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Variation of a pattern applied by the channel playing it, so one
+ * recording can be played rotated, mirrored, scaled, reversed or
+ * shifted in time without copying its ticks.
+ *
+ * The spatial part maps the horizontal plane: the position is first
+ * mirrored left / right, then scaled and rotated in azimuth. The
+ * height is kept, the engine recomputes it from its height map for
+ * the new horizontal position. The 2x2 matrix is computed on construction, so
+ * applying it per tick costs a handful of multiply-adds. The time
+ * part reverses the play phase and then adds an offset in pattern
+ * lengths.
+ */
+class PatternTransform
+{
+public:
+  PatternTransform ();
+  PatternTransform (float rotationDegrees, float scale, bool mirror,
+                    bool reverse, float phaseOffset);
+
+  float getRotationDegrees () const;
+  float getScale () const;
+  bool isMirrored () const;
+  bool isReversed () const;
+  float getPhaseOffset () const;
+
+  bool isIdentity () const;
+
+  // maps the play phase of the channel to the pattern, in [0, 1)
+  float mapPhase (float phase) const;
+  // invalid positions stay invalid
+  Pos apply (Pos const &position) const;
+
+private:
+  float _rotationDegrees = 0.f;
+  float _scale = 1.f;
+  bool _mirror = false;
+  bool _reverse = false;
+  float _phaseOffset = 0.f;
+
+  // row-major, applied to (x, y)
+  std::array<float, 4> _matrix{ 1.f, 0.f, 0.f, 1.f };
+};
+
+}
@@ -0,0 +1,267 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "RecordingJournal.hh"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <a3-motion-engine/util/Helpers.hh>
+
+namespace a3
+{
+
+namespace
+{
+
+constexpr char magicJournal[8] = { 'A', '3', 'J', 'R', 'N', 'L', 0, 0 };
+constexpr std::uint32_t formatVersion = 1;
+// guards replay against absurd lengths from a damaged file
+constexpr std::uint32_t maxNumTicks = 1u << 24;
+
+struct Header
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+};
+
+struct Record
+{
+  std::uint32_t patternId;
+  std::uint32_t recording;
+  std::uint32_t tick;
+  std::uint32_t numTicks;
+  float position[3];
+  // CRC-32 of the preceding fields
+  std::uint32_t checksum;
+};
+
+static_assert (sizeof (Header) == 16 && sizeof (Record) == 32);
+
+bool
+writeAll (int fd, void const *data, std::size_t size)
+{
+  auto const *bytes = static_cast<std::uint8_t const *> (data);
+  while (size > 0)
+    {
+      auto const numWritten = ::write (fd, bytes, size);
+      if (numWritten < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return false;
+        }
+      bytes += numWritten;
+      size -= std::size_t (numWritten);
+    }
+  return true;
+}
+
+}
+
+RecordingJournal::RecordingJournal () : juce::Thread ("RecordingJournal") {}
+
+RecordingJournal::~RecordingJournal () { close (); }
+
+bool
+RecordingJournal::open (std::string const &path, int intervalSyncMillis)
+{
+  close ();
+
+  _fd = ::open (path.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644);
+  Header header{};
+  std::memcpy (header.magic, magicJournal, sizeof (magicJournal));
+  header.version = formatVersion;
+  if (_fd < 0 || !writeAll (_fd, &header, sizeof (header))
+      || !syncFileData (_fd))
+    {
+      juce::Logger::writeToLog ("RecordingJournal: could not open " + path
+                                + ": " + std::strerror (errno));
+      close ();
+      return false;
+    }
+
+  _path = path;
+  _intervalSyncMillis = intervalSyncMillis;
+  _isOpen = true;
+  startThread ();
+  return true;
+}
+
+void
+RecordingJournal::close ()
+{
+  _isOpen = false;
+  // the writer flushes the remaining ticks before it exits
+  stopThread (-1);
+
+  if (_fd >= 0)
+    ::close (_fd);
+  _fd = -1;
+}
+
+bool
+RecordingJournal::isOpen () const
+{
+  return _isOpen;
+}
+
+void
+RecordingJournal::appendTick (std::uint32_t patternId,
+                              std::uint32_t recording, index_t tick,
+                              index_t numTicks, Pos position)
+{
+  if (!_isOpen)
+    return;
+
+  if (_abstractFifo.getFreeSpace () == 0)
+    {
+      ++_numTicksDropped;
+      return;
+    }
+
+  const auto scope = _abstractFifo.write (1);
+  jassert (scope.blockSize1 == 1);
+  jassert (scope.blockSize2 == 0);
+
+  jassert (scope.startIndex1 >= 0);
+  _fifo[static_cast<std::size_t> (scope.startIndex1)]
+      = { patternId, recording, std::uint32_t (tick),
+          std::uint32_t (numTicks), position };
+}
+
+int
+RecordingJournal::getNumTicksDropped () const
+{
+  return _numTicksDropped;
+}
+
+void
+RecordingJournal::run ()
+{
+  while (!threadShouldExit ())
+    {
+      wait (_intervalSyncMillis);
+      writeFifo ();
+    }
+  writeFifo ();
+}
+
+void
+RecordingJournal::writeFifo ()
+{
+  auto const ready = _abstractFifo.getNumReady ();
+  if (ready == 0)
+    return;
+
+  std::array<Record, fifoSize> records;
+  auto numRecords = std::size_t (0);
+  auto const appendRecord = [&] (Entry const &entry) {
+    auto &record = records[numRecords++];
+    record = { entry.patternId,
+               entry.recording,
+               entry.tick,
+               entry.numTicks,
+               { entry.position.x (), entry.position.y (),
+                 entry.position.z () },
+               0 };
+    record.checksum = crc32 (&record, offsetof (Record, checksum));
+  };
+
+  {
+    const auto scope = _abstractFifo.read (ready);
+    for (auto idx = scope.startIndex1;
+         idx < scope.startIndex1 + scope.blockSize1; ++idx)
+      appendRecord (_fifo[static_cast<std::size_t> (idx)]);
+    for (auto idx = scope.startIndex2;
+         idx < scope.startIndex2 + scope.blockSize2; ++idx)
+      appendRecord (_fifo[static_cast<std::size_t> (idx)]);
+  }
+
+  if (!writeAll (_fd, records.data (), numRecords * sizeof (Record))
+      || !syncFileData (_fd))
+    juce::Logger::writeToLog ("RecordingJournal: could not write " + _path
+                              + ": " + std::strerror (errno));
+
+  auto const numTicksDropped = _numTicksDropped.load ();
+  if (numTicksDropped != _numTicksDroppedLogged)
+    {
+      juce::Logger::writeToLog ("RecordingJournal: "
+                                + juce::String (numTicksDropped)
+                                + " ticks dropped");
+      _numTicksDroppedLogged = numTicksDropped;
+    }
+}
+
+std::map<std::uint32_t, RecordingJournal::Recording>
+RecordingJournal::replay (std::string const &path)
+{
+  std::map<std::uint32_t, Recording> recordings;
+
+  std::ifstream file (path, std::ios::binary);
+  std::vector<char> const contents ((std::istreambuf_iterator<char> (file)),
+                                    std::istreambuf_iterator<char> ());
+
+  Header header;
+  if (contents.size () < sizeof (header))
+    return recordings;
+  std::memcpy (&header, contents.data (), sizeof (header));
+  if (std::memcmp (header.magic, magicJournal, sizeof (magicJournal)) != 0
+      || header.version != formatVersion)
+    {
+      juce::Logger::writeToLog ("RecordingJournal: ignoring " + path);
+      return recordings;
+    }
+
+  // the first damaged record is the torn end of the last write
+  for (auto offset = sizeof (header);
+       offset + sizeof (Record) <= contents.size ();
+       offset += sizeof (Record))
+    {
+      Record record;
+      std::memcpy (&record, contents.data () + offset, sizeof (record));
+      if (record.checksum != crc32 (&record, offsetof (Record, checksum))
+          || record.numTicks > maxNumTicks || record.tick >= record.numTicks)
+        break;
+
+      auto [it, inserted] = recordings.try_emplace (record.patternId);
+      auto &recording = it->second;
+      if (inserted || recording.recording != record.recording
+          || recording.ticks.size () != record.numTicks)
+        {
+          recording.recording = record.recording;
+          recording.ticks.assign (record.numTicks, Pos::invalid);
+        }
+      recording.ticks[record.tick] = Pos::fromCartesian (
+          record.position[0], record.position[1], record.position[2]);
+    }
+
+  return recordings;
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Append-only journal of recorded ticks, so recordings survive a
+ * crash. The tick thread submits each recorded tick to a lock-free
+ * FIFO, a background thread writes them to the journal file in
+ * batches and syncs it at a fixed interval. The tick thread never
+ * touches the file, ticks are dropped when the FIFO is full.
+ *
+ * Each record holds the pattern id, a recording number that changes
+ * with every new recording, the tick, the pattern length and the
+ * position, protected by a CRC-32. replay () reconstructs the latest
+ * recording of each pattern up to the last synced tick.
+ */
+class RecordingJournal : public juce::Thread
+{
+public:
+  RecordingJournal ();
+  ~RecordingJournal ();
+
+  // Truncates or creates the journal file and starts the writer.
+  bool open (std::string const &path, int intervalSyncMillis);
+  void close ();
+  bool isOpen () const;
+
+  // called from the tick thread, a no-op while the journal is closed
+  void appendTick (std::uint32_t patternId, std::uint32_t recording,
+                   index_t tick, index_t numTicks, Pos position);
+
+  int getNumTicksDropped () const;
+
+  struct Recording
+  {
+    std::uint32_t recording = 0;
+    // ticks not in the journal are invalid
+    std::vector<Pos> ticks;
+  };
+  // latest recording per pattern id found in the journal file
+  static std::map<std::uint32_t, Recording> replay (std::string const &path);
+
+  void run () override;
+
+private:
+  struct Entry
+  {
+    std::uint32_t patternId;
+    std::uint32_t recording;
+    std::uint32_t tick;
+    std::uint32_t numTicks;
+    Pos position;
+  };
+
+  void writeFifo ();
+
+  static constexpr int fifoSize = 1024;
+  juce::AbstractFifo _abstractFifo{ fifoSize };
+  std::array<Entry, fifoSize> _fifo;
+  std::atomic<int> _numTicksDropped{ 0 };
+  std::atomic<bool> _isOpen{ false };
+
+  // accessed by the writer thread while it runs
+  int _numTicksDroppedLogged = 0;
+  int _fd = -1;
+  int _intervalSyncMillis = 0;
+  std::string _path;
+};
+
+}
@@ -0,0 +1,215 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "Session.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace a3
+{
+
+namespace
+{
+
+constexpr char magicSession[8] = { 'A', '3', 'S', 'E', 'S', 'S', 0, 0 };
+
+struct Header
+{
+  char magic[8];
+  std::uint32_t version;
+  float tempoBPM;
+  std::uint32_t recordingMode;
+  std::uint32_t numChannels;
+  std::uint32_t numPatterns;
+  std::uint32_t reserved;
+};
+
+struct ChannelRecord
+{
+  float width;
+  std::int32_t ambisonicsOrder;
+  std::int32_t lengthBarLog2;
+  std::uint32_t reserved;
+};
+
+struct PatternRecord
+{
+  std::uint32_t channel;
+  std::uint32_t index;
+  std::uint32_t numTicks;
+  std::int32_t playbackLength[3];
+};
+
+// ticks are copied as arrays of three floats
+static_assert (sizeof (Pos) == 3 * sizeof (float)
+               && std::is_trivially_copyable_v<Pos>);
+
+template <typename T>
+void
+write (std::uint8_t *&destination, T const &value)
+{
+  static_assert (std::is_trivially_copyable_v<T>);
+  std::memcpy (destination, &value, sizeof (value));
+  destination += sizeof (value);
+}
+
+class Reader
+{
+public:
+  Reader (void const *data, std::size_t size)
+      : _data (static_cast<std::uint8_t const *> (data)), _size (size)
+  {
+  }
+
+  bool
+  read (void *destination, std::size_t size)
+  {
+    if (size > getRemaining ())
+      return false;
+    std::memcpy (destination, _data + _offset, size);
+    _offset += size;
+    return true;
+  }
+
+  template <typename T>
+  bool
+  read (T &value)
+  {
+    static_assert (std::is_trivially_copyable_v<T>);
+    return read (&value, sizeof (value));
+  }
+
+  std::size_t
+  getRemaining () const
+  {
+    return _size - _offset;
+  }
+
+private:
+  std::uint8_t const *_data;
+  std::size_t _size;
+  std::size_t _offset = 0;
+};
+
+}
+
+void
+Session::serialize (juce::MemoryBlock &destination) const
+{
+  auto size = sizeof (Header) + channels.size () * sizeof (ChannelRecord);
+  for (auto const &pattern : patterns)
+    size += sizeof (PatternRecord) + pattern.ticks.size () * sizeof (Pos);
+
+  destination.setSize (size);
+  auto *data = static_cast<std::uint8_t *> (destination.getData ());
+
+  Header header{};
+  std::memcpy (header.magic, magicSession, sizeof (magicSession));
+  header.version = formatVersion;
+  header.tempoBPM = tempoBPM;
+  header.recordingMode = std::uint32_t (recordingMode);
+  header.numChannels = std::uint32_t (channels.size ());
+  header.numPatterns = std::uint32_t (patterns.size ());
+  write (data, header);
+
+  for (auto const &channel : channels)
+    write (data, ChannelRecord{ channel.width, channel.ambisonicsOrder,
+                                channel.lengthBarLog2, 0 });
+
+  for (auto const &pattern : patterns)
+    {
+      write (data, PatternRecord{ std::uint32_t (pattern.channel),
+                                  std::uint32_t (pattern.index),
+                                  std::uint32_t (pattern.ticks.size ()),
+                                  { pattern.playbackLength.bar (),
+                                    pattern.playbackLength.beat (),
+                                    pattern.playbackLength.tick () } });
+      auto const sizeTicks = pattern.ticks.size () * sizeof (Pos);
+      std::memcpy (data, pattern.ticks.data (), sizeTicks);
+      data += sizeTicks;
+    }
+}
+
+std::unique_ptr<Session>
+Session::deserialize (void const *data, std::size_t size)
+{
+  // the format is defined as little-endian and copied as is
+  if (juce::ByteOrder::isBigEndian ())
+    return nullptr;
+
+  Reader reader (data, size);
+  Header header;
+  if (!reader.read (header)
+      || std::memcmp (header.magic, magicSession, sizeof (magicSession)) != 0
+      || header.version != formatVersion
+      || !(header.tempoBPM >= tempoBPMMin && header.tempoBPM <= tempoBPMMax)
+      || header.recordingMode
+             > std::uint32_t (MotionEngine::RecordingMode::OneShot)
+      || header.numChannels > reader.getRemaining () / sizeof (ChannelRecord))
+    return nullptr;
+
+  auto session = std::make_unique<Session> ();
+  session->tempoBPM = header.tempoBPM;
+  session->recordingMode = MotionEngine::RecordingMode (header.recordingMode);
+
+  session->channels.resize (header.numChannels);
+  for (auto &channel : session->channels)
+    {
+      ChannelRecord record;
+      reader.read (record);
+      if (!std::isfinite (record.width))
+        return nullptr;
+
+      channel = { std::clamp (record.width, 0.f, widthMax),
+                  std::clamp (int (record.ambisonicsOrder), 0,
+                              ambisonicsOrderMax),
+                  record.lengthBarLog2 };
+    }
+
+  if (header.numPatterns > reader.getRemaining () / sizeof (PatternRecord))
+    return nullptr;
+
+  session->patterns.resize (header.numPatterns);
+  for (auto &pattern : session->patterns)
+    {
+      PatternRecord record;
+      if (!reader.read (record) || record.channel >= header.numChannels
+          || record.numTicks > reader.getRemaining () / sizeof (Pos))
+        return nullptr;
+
+      pattern.channel = record.channel;
+      pattern.index = record.index;
+      pattern.playbackLength
+          = Measure (record.playbackLength[0], record.playbackLength[1],
+                     record.playbackLength[2]);
+      pattern.ticks.resize (record.numTicks);
+      reader.read (pattern.ticks.data (), record.numTicks * sizeof (Pos));
+    }
+
+  if (reader.getRemaining () != 0)
+    return nullptr;
+
+  return session;
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/Measure.hh>
+#include <a3-motion-engine/MotionEngine.hh>
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Everything a host saves with a project: engine parameters, all
+ * patterns and the per-channel settings of the UI. The binary format
+ * is little-endian and consists of a header, the channels and the
+ * patterns, each pattern followed by its ticks as x, y, z floats:
+ *
+ *   Header   magic "A3SESS", version, tempo, recording mode, number
+ *            of channels and patterns
+ *   Channel  width, ambisonics order, length in bars (log2)
+ *   Pattern  channel, index, number of ticks, playback length, ticks
+ *
+ * Ticks are copied as a whole to and from Pos arrays, so a full bank
+ * serializes in well under a millisecond.
+ */
+class Session
+{
+public:
+  static constexpr std::uint32_t formatVersion = 1;
+
+  // sessions with a tempo outside this range are rejected, widths and
+  // orders outside theirs are clamped when deserializing.
+  static constexpr float tempoBPMMin = 20.f;
+  static constexpr float tempoBPMMax = 400.f;
+  static constexpr float widthMax = 180.f;
+  static constexpr int ambisonicsOrderMax = 3;
+
+  struct Channel
+  {
+    float width = 45.f;
+    int ambisonicsOrder = 3;
+    // record and playback length selected in the UI
+    int lengthBarLog2 = 0;
+  };
+
+  struct PatternData
+  {
+    index_t channel = 0;
+    // position of the pattern on the channel's pads
+    index_t index = 0;
+    std::vector<Pos> ticks;
+    Measure playbackLength;
+  };
+
+  float tempoBPM = 120.f;
+  MotionEngine::RecordingMode recordingMode
+      = MotionEngine::RecordingMode::OneShot;
+  std::vector<Channel> channels;
+  std::vector<PatternData> patterns;
+
+  void serialize (juce::MemoryBlock &destination) const;
+  // returns nullptr if the data is not a valid session
+  static std::unique_ptr<Session> deserialize (void const *data,
+                                               std::size_t size);
+};
+
+}
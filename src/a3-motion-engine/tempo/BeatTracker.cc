@@ -0,0 +1,428 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BeatTracker.hh"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+// Computes bin magnitudes from the interleaved complex output of
+// juce::dsp::FFT::performRealOnlyForwardTransform. Four bins are
+// processed per iteration where SIMD is available, the remainder
+// falls back to scalar code.
+void
+computeMagnitudes (float const *interleaved, float *magnitudes, int numBins)
+{
+  auto bin = 0;
+#if defined(__SSE2__)
+  for (; bin + 4 <= numBins; bin += 4)
+    {
+      auto const lo = _mm_loadu_ps (interleaved + 2 * bin);
+      auto const hi = _mm_loadu_ps (interleaved + 2 * bin + 4);
+      auto const re = _mm_shuffle_ps (lo, hi, _MM_SHUFFLE (2, 0, 2, 0));
+      auto const im = _mm_shuffle_ps (lo, hi, _MM_SHUFFLE (3, 1, 3, 1));
+      auto const power
+          = _mm_add_ps (_mm_mul_ps (re, re), _mm_mul_ps (im, im));
+      _mm_storeu_ps (magnitudes + bin, _mm_sqrt_ps (power));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; bin + 4 <= numBins; bin += 4)
+    {
+      auto const reim = vld2q_f32 (interleaved + 2 * bin);
+      auto const power = vmlaq_f32 (vmulq_f32 (reim.val[0], reim.val[0]),
+                                    reim.val[1], reim.val[1]);
+      vst1q_f32 (magnitudes + bin, vsqrtq_f32 (power));
+    }
+#endif
+  for (; bin < numBins; ++bin)
+    {
+      auto const re = interleaved[2 * bin];
+      auto const im = interleaved[2 * bin + 1];
+      magnitudes[bin] = std::sqrt (re * re + im * im);
+    }
+}
+
+}
+
+namespace a3
+{
+
+BeatTracker::BeatTracker () {}
+
+void
+BeatTracker::prepare (double sampleRate)
+{
+  jassert (sampleRate > 0.);
+  _sampleRate = sampleRate;
+
+  // choose a power-of-two hop size that yields roughly the targeted
+  // ODF frame rate, independent of the device sample rate.
+  auto const hopOrder = juce::jmax (
+      6, juce::roundToInt (std::log2 (sampleRate / frameRateTarget)));
+  _hopSize = 1 << hopOrder;
+  _fftSize = 4 * _hopSize;
+  _frameRate = sampleRate / _hopSize;
+
+  _minLag = static_cast<int> (std::floor (_frameRate * 60. / tempoBPMMax));
+  _maxLag = static_cast<int> (std::ceil (_frameRate * 60. / tempoBPMMin));
+  jassert ((numHarmonics + 1) * _maxLag <= numOnsetFrames);
+
+  _fft = std::make_unique<juce::dsp::FFT> (hopOrder + 2);
+  _window = std::make_unique<juce::dsp::WindowingFunction<float> > (
+      static_cast<std::size_t> (_fftSize),
+      juce::dsp::WindowingFunction<float>::hann, false);
+  _fftAutocorrelation
+      = std::make_unique<juce::dsp::FFT> (onsetHistoryOrder + 1);
+
+  auto const fftSize = static_cast<std::size_t> (_fftSize);
+  auto const numBins = fftSize / 2 + 1;
+  _input.assign (fftSize, 0.f);
+  _frame.assign (2 * fftSize, 0.f);
+  _magnitudes.assign (numBins, 0.f);
+  _magnitudesLast.assign (numBins, 0.f);
+  _flux.assign (numBins, 0.f);
+  _onsets.assign (numOnsetFrames, 0.f);
+  _autocorrelation.assign (4 * numOnsetFrames, 0.f);
+
+  reset ();
+}
+
+void
+BeatTracker::reset ()
+{
+  std::fill (_input.begin (), _input.end (), 0.f);
+  std::fill (_magnitudesLast.begin (), _magnitudesLast.end (), 0.f);
+  std::fill (_onsets.begin (), _onsets.end (), 0.f);
+
+  _inputWriteIndex = 0;
+  _samplesUntilHop = _hopSize;
+  _numFrames = 0;
+  _numFramesAutocorrelation = 0;
+
+  _periodFrames = 0.;
+  _nextBeatFrame = 0.;
+  _lastEmittedBeatFrame = -std::numeric_limits<double>::infinity ();
+  _isFirstBeatSinceReset = true;
+
+  _tempoBPM = 0.f;
+  _tracking = false;
+  _abstractFifo.reset ();
+}
+
+void
+BeatTracker::process (float const *const *channels, int numChannels,
+                      int numSamples)
+{
+  jassert (_hopSize > 0); // prepare () has to be called first
+  if (numChannels <= 0 || _hopSize <= 0)
+    return;
+
+  auto const gain = 1.f / static_cast<float> (numChannels);
+  auto const indexMask = _fftSize - 1;
+
+  auto sample = 0;
+  while (sample < numSamples)
+    {
+      auto const numSamplesChunk
+          = std::min (numSamples - sample, _samplesUntilHop);
+
+      // downmix into the circular input buffer
+      for (auto offset = sample; offset < sample + numSamplesChunk; ++offset)
+        {
+          auto sum = 0.f;
+          for (auto channel = 0; channel < numChannels; ++channel)
+            sum += channels[channel][offset];
+
+          _input[static_cast<std::size_t> (_inputWriteIndex)] = sum * gain;
+          _inputWriteIndex = (_inputWriteIndex + 1) & indexMask;
+        }
+
+      sample += numSamplesChunk;
+      _samplesUntilHop -= numSamplesChunk;
+
+      if (_samplesUntilHop == 0)
+        {
+          processFrame ();
+          _samplesUntilHop = _hopSize;
+        }
+    }
+}
+
+bool
+BeatTracker::popBeat (Beat &beat)
+{
+  if (_abstractFifo.getNumReady () == 0)
+    return false;
+
+  const auto scope = _abstractFifo.read (1);
+  jassert (scope.blockSize1 == 1);
+  jassert (scope.startIndex1 >= 0);
+
+  beat = _fifo[static_cast<std::size_t> (scope.startIndex1)];
+  return true;
+}
+
+float
+BeatTracker::getTempoBPM () const
+{
+  return _tempoBPM;
+}
+
+bool
+BeatTracker::isTracking () const
+{
+  return _tracking;
+}
+
+void
+BeatTracker::processFrame ()
+{
+  // unroll the circular input buffer, oldest sample first
+  auto const inputWriteIndex = static_cast<std::ptrdiff_t> (_inputWriteIndex);
+  std::copy (_input.begin () + inputWriteIndex, _input.end (),
+             _frame.begin ());
+  std::copy (_input.begin (), _input.begin () + inputWriteIndex,
+             _frame.begin () + (_fftSize - inputWriteIndex));
+
+  _window->multiplyWithWindowingTable (_frame.data (),
+                                       static_cast<std::size_t> (_fftSize));
+  _fft->performRealOnlyForwardTransform (_frame.data (), true);
+
+  auto const numBins = static_cast<int> (_magnitudes.size ());
+  computeMagnitudes (_frame.data (), _magnitudes.data (), numBins);
+
+  // half-wave rectified spectral flux
+  juce::FloatVectorOperations::subtract (
+      _flux.data (), _magnitudes.data (), _magnitudesLast.data (), numBins);
+  juce::FloatVectorOperations::max (_flux.data (), _flux.data (), 0.f,
+                                    numBins);
+  auto const onset = std::accumulate (_flux.begin (), _flux.end (), 0.f);
+  std::swap (_magnitudes, _magnitudesLast);
+
+  _onsets[static_cast<std::size_t> (_numFrames % numOnsetFrames)] = onset;
+  ++_numFrames;
+
+  if (_numFrames % framesPerTempoUpdate == 0)
+    {
+      estimateTempo ();
+      if (_tracking)
+        estimatePhase ();
+    }
+
+  emitBeats ();
+}
+
+void
+BeatTracker::estimateTempo ()
+{
+  auto const numFrames = static_cast<int> (
+      std::min (_numFrames, static_cast<juce::int64> (numOnsetFrames)));
+  if (numFrames < (numHarmonics + 1) * _maxLag)
+    return;
+
+  // copy the ODF history in chronological order and remove its mean
+  auto mean = 0.f;
+  for (auto framesAgo = 0; framesAgo < numFrames; ++framesAgo)
+    mean += getOnset (framesAgo);
+  mean /= static_cast<float> (numFrames);
+
+  std::fill (_autocorrelation.begin (), _autocorrelation.end (), 0.f);
+  for (auto index = 0; index < numFrames; ++index)
+    _autocorrelation[static_cast<std::size_t> (index)]
+        = getOnset (numFrames - 1 - index) - mean;
+
+  // Wiener-Khinchin: the autocorrelation is the inverse transform of
+  // the power spectrum. Zero padding to twice the history length
+  // avoids circular wrap-around.
+  _fftAutocorrelation->performRealOnlyForwardTransform (
+      _autocorrelation.data (), true);
+  auto const numBins = _fftAutocorrelation->getSize () / 2 + 1;
+  for (auto bin = 0; bin < numBins; ++bin)
+    {
+      auto &re = _autocorrelation[static_cast<std::size_t> (2 * bin)];
+      auto &im = _autocorrelation[static_cast<std::size_t> (2 * bin + 1)];
+      re = re * re + im * im;
+      im = 0.f;
+    }
+  _fftAutocorrelation->performRealOnlyInverseTransform (
+      _autocorrelation.data ());
+  _numFramesAutocorrelation = numFrames;
+
+  auto const variance = getAutocorrelation (0);
+  if (!(variance > std::numeric_limits<float>::min ()))
+    {
+      _tracking = false;
+      return;
+    }
+
+  // comb over the first harmonics of each candidate period, weighted
+  // by a Rayleigh distribution peaking at the prior tempo.
+  auto const beta = _frameRate * 60. / tempoBPMPrior;
+  auto const computeScore = [&] (int lag) {
+    auto score = 0.f;
+    for (auto harmonic = 1; harmonic <= numHarmonics; ++harmonic)
+      score += getAutocorrelation (harmonic * lag);
+    auto const weight
+        = lag / (beta * beta) * std::exp (-lag * lag / (2. * beta * beta));
+    return score * static_cast<float> (weight);
+  };
+
+  auto lagBest = _minLag;
+  auto scoreBest = computeScore (_minLag);
+  for (auto lag = _minLag + 1; lag <= _maxLag; ++lag)
+    {
+      auto const score = computeScore (lag);
+      if (score > scoreBest)
+        {
+          scoreBest = score;
+          lagBest = lag;
+        }
+    }
+
+  auto confidence = 0.f;
+  for (auto harmonic = 1; harmonic <= numHarmonics; ++harmonic)
+    confidence += getAutocorrelation (harmonic * lagBest);
+  confidence /= numHarmonics * variance;
+
+  if (confidence < confidenceMin)
+    {
+      _tracking = false;
+      return;
+    }
+
+  // refine to a fractional period by parabolic interpolation
+  auto period = static_cast<double> (lagBest);
+  if (lagBest > _minLag && lagBest < _maxLag)
+    {
+      auto const scorePrev = computeScore (lagBest - 1);
+      auto const scoreNext = computeScore (lagBest + 1);
+      auto const denominator = scorePrev - 2.f * scoreBest + scoreNext;
+      if (denominator < 0.f)
+        period += 0.5 * (scorePrev - scoreNext) / denominator;
+    }
+
+  _periodFrames = period;
+  _tempoBPM = static_cast<float> (60. * _frameRate / period);
+  _tracking = true;
+}
+
+void
+BeatTracker::estimatePhase ()
+{
+  jassert (_periodFrames > 0.);
+
+  auto const numFrames = _numFramesAutocorrelation;
+  auto const numOffsets = static_cast<int> (std::ceil (_periodFrames));
+
+  auto offsetBest = 0;
+  auto scoreBest = -std::numeric_limits<float>::infinity ();
+  for (auto offset = 0; offset < numOffsets; ++offset)
+    {
+      auto score = 0.f;
+      for (auto beat = 0; beat < numBeatsPhase; ++beat)
+        {
+          auto const framesAgo
+              = offset + juce::roundToInt (beat * _periodFrames);
+          if (framesAgo < numFrames)
+            score += getOnset (framesAgo);
+        }
+
+      if (score > scoreBest)
+        {
+          scoreBest = score;
+          offsetBest = offset;
+        }
+    }
+
+  auto const frameNewest = static_cast<double> (_numFrames - 1);
+  auto nextBeatFrame = frameNewest - offsetBest;
+
+  // the most recent beat may not have been emitted yet if the phase
+  // moved backwards, but don't emit the same beat twice either.
+  while (nextBeatFrame - _lastEmittedBeatFrame < 0.5 * _periodFrames)
+    nextBeatFrame += _periodFrames;
+
+  _nextBeatFrame = nextBeatFrame;
+}
+
+void
+BeatTracker::emitBeats ()
+{
+  if (!_tracking)
+    return;
+
+  auto const frameNewest = static_cast<double> (_numFrames - 1);
+  if (frameNewest >= _nextBeatFrame)
+    {
+      submitBeatTime (_nextBeatFrame);
+      _lastEmittedBeatFrame = _nextBeatFrame;
+      _nextBeatFrame += _periodFrames;
+    }
+}
+
+void
+BeatTracker::submitBeatTime (double frame)
+{
+  // the consumer is not draining the queue, drop the beat rather
+  // than blocking the audio thread.
+  if (_abstractFifo.getFreeSpace () == 0)
+    return;
+
+  const auto scope = _abstractFifo.write (1);
+  jassert (scope.blockSize1 == 1);
+  jassert (scope.blockSize2 == 0);
+  jassert (scope.startIndex1 >= 0);
+
+  auto const timeMicros
+      = static_cast<juce::int64> (frame * _hopSize * 1.0e6 / _sampleRate);
+  _fifo[static_cast<std::size_t> (scope.startIndex1)]
+      = { timeMicros, _isFirstBeatSinceReset };
+  _isFirstBeatSinceReset = false;
+}
+
+float
+BeatTracker::getOnset (int framesAgo) const
+{
+  jassert (framesAgo >= 0 && framesAgo < numOnsetFrames);
+  jassert (framesAgo < _numFrames);
+  auto const frame = _numFrames - 1 - framesAgo;
+  return _onsets[static_cast<std::size_t> (frame % numOnsetFrames)];
+}
+
+float
+BeatTracker::getAutocorrelation (int lag) const
+{
+  // unbiased estimate, normalized by the number of overlapping frames
+  jassert (lag >= 0 && lag < _numFramesAutocorrelation);
+  return _autocorrelation[static_cast<std::size_t> (lag)]
+         / static_cast<float> (_numFramesAutocorrelation - lag);
+}
+
+}
@@ -0,0 +1,148 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <JuceHeader.h>
+
+namespace a3
+{
+
+/*
+ * BeatTracker follows the beat of an audio signal so that the
+ * TempoClock can be driven from the music instead of tap input.
+ *
+ * The onset detection function (ODF) is the half-wave rectified
+ * spectral flux of consecutive STFT frames. The tempo is estimated
+ * from the autocorrelation of the ODF history, scored with a comb
+ * over the first few multiples of each candidate period and weighted
+ * towards 120 BPM. The beat phase is the offset that best aligns a
+ * comb of the estimated period with the most recent onsets.
+ *
+ * Detected beats are published via a lock-free FIFO in the same
+ * microsecond format as hardware taps and can be passed on to
+ * TempoClock::tap with TapSource::BeatTracker. The times count the
+ * audio processed since the last prepare () or reset (), so they
+ * must not be mixed with taps of the controller's clock. process ()
+ * is real-time safe: all buffers are allocated in prepare () and no
+ * locks are taken.
+ */
+class BeatTracker
+{
+public:
+  BeatTracker ();
+
+  // Allocates all buffers for the given sample rate. Must not be
+  // called concurrently with process ().
+  void prepare (double sampleRate);
+  void reset ();
+
+  void process (float const *const *channels, int numChannels,
+                int numSamples);
+
+  struct Beat
+  {
+    juce::int64 timeMicros;
+    // the clock restarted since the previous beat, earlier times
+    // are not comparable
+    bool isFirstSinceReset;
+  };
+
+  // Consumer side, e.g. the message thread. Returns false when no
+  // beat is pending. Beats are only emitted while tracking.
+  bool popBeat (Beat &beat);
+
+  float getTempoBPM () const;
+  bool isTracking () const;
+
+private:
+  static constexpr float tempoBPMMin = 70.f;
+  static constexpr float tempoBPMMax = 180.f;
+  static constexpr float tempoBPMPrior = 120.f;
+  static constexpr int numHarmonics = 4;
+  static constexpr int numBeatsPhase = 4;
+  static constexpr float confidenceMin = 0.1f;
+
+  // ~5.5 seconds of ODF history at the targeted frame rate
+  static constexpr int onsetHistoryOrder = 10;
+  static constexpr int numOnsetFrames = 1 << onsetHistoryOrder;
+  static constexpr int framesPerTempoUpdate = 16;
+  static constexpr float frameRateTarget = 150.f;
+
+  void processFrame ();
+  void estimateTempo ();
+  void estimatePhase ();
+  void emitBeats ();
+  void submitBeatTime (double frame);
+
+  float getOnset (int framesAgo) const;
+  float getAutocorrelation (int lag) const;
+
+  double _sampleRate = 0.;
+  double _frameRate = 0.;
+  int _hopSize = 0;
+  int _fftSize = 0;
+  int _minLag = 0;
+  int _maxLag = 0;
+
+  std::unique_ptr<juce::dsp::FFT> _fft;
+  std::unique_ptr<juce::dsp::WindowingFunction<float> > _window;
+  std::unique_ptr<juce::dsp::FFT> _fftAutocorrelation;
+
+  // circular mono input buffer of _fftSize samples
+  std::vector<float> _input;
+  int _inputWriteIndex = 0;
+  int _samplesUntilHop = 0;
+
+  std::vector<float> _frame;
+  std::vector<float> _magnitudes;
+  std::vector<float> _magnitudesLast;
+  std::vector<float> _flux;
+
+  // circular ODF history, one value per hop
+  std::vector<float> _onsets;
+  juce::int64 _numFrames = 0;
+
+  // zero-padded to twice the history length, interleaved complex
+  // after the forward transform
+  std::vector<float> _autocorrelation;
+  int _numFramesAutocorrelation = 0;
+
+  double _periodFrames = 0.;
+  double _nextBeatFrame = 0.;
+  double _lastEmittedBeatFrame = 0.;
+  bool _isFirstBeatSinceReset = true;
+
+  std::atomic<float> _tempoBPM{ 0.f };
+  std::atomic<bool> _tracking{ false };
+  static_assert (std::atomic<float>::is_always_lock_free);
+  static_assert (std::atomic<bool>::is_always_lock_free);
+
+  static constexpr int fifoSize = 32;
+  juce::AbstractFifo _abstractFifo{ fifoSize };
+  std::array<Beat, fifoSize> _fifo;
+};
+
+}
@@ -20,6 +20,8 @@
 
 #include "TempoClock.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <future>
 
 #include <JuceHeader.h>
@@ -44,7 +46,16 @@ public:
     a3::TempoClock::Execution execution;
   };
 
-  ClockTimer (a3::TempoClock const &tempoClock) : _tempoClock (tempoClock)
+  struct TempoChange
+  {
+    float tempoBPM;
+    float durationBeats;
+    a3::TempoClock::RampShape shape;
+  };
+
+  ClockTimer (a3::TempoClock const &tempoClock,
+              a3::TimeSource const &timeSource)
+      : _tempoClock (tempoClock), _timeSource (timeSource)
   {
     forEachHandlerType ([&] (auto, auto, auto &container) {
       container.reserve (numHandlersPreAllocated);
@@ -68,6 +79,30 @@ public:
     return _fifo[startIndex].acknowledge.get_future ();
   }
 
+  // Only the latest tempo change is of interest, so instead of a FIFO
+  // we publish it via a sequence lock. The writer side has to be
+  // serialized by the caller.
+  void
+  submitTempoChange (TempoChange const &change)
+  {
+    auto const sequence
+        = _tempoChangeSequence.load (std::memory_order_relaxed);
+    _tempoChangeSequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    _tempoChangeBPM.store (change.tempoBPM, std::memory_order_relaxed);
+    _tempoChangeBeats.store (change.durationBeats, std::memory_order_relaxed);
+    _tempoChangeShape.store (change.shape, std::memory_order_relaxed);
+
+    _tempoChangeSequence.store (sequence + 2, std::memory_order_release);
+  }
+
+  float
+  getCurrentTempoBPM () const
+  {
+    return _tempoBPMCurrent;
+  }
+
   void
   hiResTimerCallback () override
   {
@@ -78,6 +113,79 @@ public:
   std::atomic<bool> reset{ true };
 
 private:
+  bool
+  pollTempoChange (TempoChange &change)
+  {
+    auto const sequence
+        = _tempoChangeSequence.load (std::memory_order_acquire);
+    if (sequence == _tempoChangeSequenceRead || (sequence & 1u))
+      return false;
+
+    change.tempoBPM = _tempoChangeBPM.load (std::memory_order_relaxed);
+    change.durationBeats = _tempoChangeBeats.load (std::memory_order_relaxed);
+    change.shape = _tempoChangeShape.load (std::memory_order_relaxed);
+
+    // a writer interfered, try again on the next timer callback
+    std::atomic_thread_fence (std::memory_order_acquire);
+    if (_tempoChangeSequence.load (std::memory_order_relaxed) != sequence)
+      return false;
+
+    _tempoChangeSequenceRead = sequence;
+    return true;
+  }
+
+  void
+  startTempoChange (TempoChange const &change)
+  {
+    auto const numTicks
+        = std::lround (change.durationBeats * _tempoClock.getTicksPerBeat ());
+
+    _rampStartBPM = _tempoBPM;
+    _rampTargetBPM = change.tempoBPM;
+    _rampShape = change.shape;
+    _rampNumTicks = std::max (numTicks, 0l);
+    _rampTick = 0;
+
+    if (_rampNumTicks == 0)
+      setTempo (_rampTargetBPM);
+  }
+
+  void
+  advanceTempoRamp ()
+  {
+    if (_rampTick >= _rampNumTicks)
+      return;
+
+    ++_rampTick;
+    if (_rampTick == _rampNumTicks)
+      {
+        setTempo (_rampTargetBPM);
+        return;
+      }
+
+    auto const progress = double (_rampTick) / double (_rampNumTicks);
+    switch (_rampShape)
+      {
+      case a3::TempoClock::RampShape::Linear:
+        setTempo (_rampStartBPM
+                  + progress * (_rampTargetBPM - _rampStartBPM));
+        break;
+      case a3::TempoClock::RampShape::Exponential:
+        setTempo (_rampStartBPM
+                  * std::pow (_rampTargetBPM / _rampStartBPM, progress));
+        break;
+      }
+  }
+
+  void
+  setTempo (double tempoBPM)
+  {
+    _tempoBPM = tempoBPM;
+    _nsPerTick = int64_t (60.0 * 1.0e9 / tempoBPM
+                          / _tempoClock.getTicksPerBeat ());
+    _tempoBPMCurrent = float (tempoBPM);
+  }
+
   struct SubmittedMessage : public Message
   {
     SubmittedMessage () : Message{} {}
@@ -160,11 +268,14 @@ private:
   void
   advanceMeasure ()
   {
-    auto now = ClockT::now ();
-    auto nsPerTick = _tempoClock.getNanoSecondsPerTick ();
+    auto now = _timeSource.now ();
 
     if (reset)
       {
+        TempoChange change;
+        if (pollTempoChange (change))
+          startTempoChange (change);
+
         _startTime = _lastTick = now;
         _measure = {};
 
@@ -180,11 +291,28 @@ private:
         while (std::chrono::duration_cast<std::chrono::nanoseconds> (
                    now - _lastTick)
                    .count ()
-               >= nsPerTick)
+               >= _nsPerTick)
           {
-            _lastTick += std::chrono::nanoseconds (nsPerTick);
+            _lastTick += std::chrono::nanoseconds (_nsPerTick);
+            advanceTempoRamp ();
             countTick ();
           }
+
+        // keep the fraction of the running tick when the tempo
+        // changes, otherwise the beat phase would jump.
+        TempoChange change;
+        if (pollTempoChange (change))
+          {
+            auto const phase = double (std::chrono::duration_cast<
+                                           std::chrono::nanoseconds> (
+                                           now - _lastTick)
+                                           .count ())
+                               / double (_nsPerTick);
+            startTempoChange (change);
+            _lastTick = now
+                        - std::chrono::nanoseconds (
+                            int64_t (phase * double (_nsPerTick)));
+          }
       }
   }
 
@@ -266,20 +394,52 @@ private:
       _handlers;
 
   a3::TempoClock const &_tempoClock;
+  a3::TimeSource const &_timeSource;
 
   ClockT::time_point _startTime;
   ClockT::time_point _lastTick;
 
+  std::atomic<uint32_t> _tempoChangeSequence{ 0 };
+  std::atomic<float> _tempoChangeBPM{ 60.f };
+  std::atomic<float> _tempoChangeBeats{ 0.f };
+  std::atomic<a3::TempoClock::RampShape> _tempoChangeShape{
+    a3::TempoClock::RampShape::Linear
+  };
+  uint32_t _tempoChangeSequenceRead = 0;
+
+  // tempo state, only accessed by the timer thread except for the
+  // published current tempo.
+  double _tempoBPM = 60.0;
+  int64_t _nsPerTick
+      = int64_t (60.0 * 1.0e9 / 60.0 / a3::TempoClock::getTicksPerBeat ());
+  std::atomic<float> _tempoBPMCurrent{ 60.f };
+
+  double _rampStartBPM = 60.0;
+  double _rampTargetBPM = 60.0;
+  a3::TempoClock::RampShape _rampShape = a3::TempoClock::RampShape::Linear;
+  long _rampNumTicks = 0;
+  long _rampTick = 0;
+
   a3::Measure _measure;
 };
 
 namespace a3
 {
 
-TempoClock::TempoClock ()
+TempoClock::TempoClock (std::shared_ptr<TimeSource> timeSource)
+    : _timeSource (std::move (timeSource))
 {
-  _timer = std::make_unique<ClockTimer> (*this);
+  jassert (_timeSource);
+  if (!_timeSource->isRealTime ())
+    {
+      _timeSourceVirtual
+          = dynamic_cast<TimeSourceVirtual *> (_timeSource.get ());
+      jassert (_timeSourceVirtual != nullptr);
+    }
+
+  _timer = std::make_unique<ClockTimer> (*this, *_timeSource);
   _tempoEstimator = std::make_unique<TempoEstimatorMean> ();
+  _tempoEstimatorBeatTracker = std::make_unique<TempoEstimatorMean> ();
 }
 
 TempoClock::~TempoClock () {}
@@ -312,10 +472,32 @@ TempoClock::getTempoBPM () const
   return _beatsPerMinute;
 }
 
-void
+float
+TempoClock::getCurrentTempoBPM () const
+{
+  return _timer->getCurrentTempoBPM ();
+}
+
+bool
 TempoClock::setTempoBPM (float tempoBPM)
 {
+  return rampTempoBPM (tempoBPM, 0.f);
+}
+
+bool
+TempoClock::rampTempoBPM (float tempoBPM, float durationBeats,
+                          RampShape shape)
+{
+  jassert (durationBeats >= 0.f);
+
+  // the timer would never reach the next tick
+  if (!std::isfinite (tempoBPM) || tempoBPM <= 0.f)
+    return false;
+
+  std::lock_guard<std::mutex> const guard{ _mutexWriteTempo };
   _beatsPerMinute = tempoBPM;
+  _timer->submitTempoChange ({ tempoBPM, durationBeats, shape });
+  return true;
 }
 
 int
@@ -333,16 +515,18 @@ TempoClock::setBeatsPerBar (int beatsPerBar)
 int64_t
 TempoClock::getNanoSecondsPerTick () const
 {
-  return int64_t (60) * 1000000000 / double (_beatsPerMinute) / ticksPerBeat;
+  return int64_t (60) * 1000000000 / double (getCurrentTempoBPM ())
+         / ticksPerBeat;
 }
 
 TempoClock::TapResult
-TempoClock::tap (juce::int64 timeMicros)
+TempoClock::tap (juce::int64 timeMicros, TapSource source)
 {
-  if (_tempoEstimator->tap (timeMicros)
-      == TempoEstimator::TapResult::TempoAvailable)
+  auto &tempoEstimator = getTempoEstimator (source);
+  if (tempoEstimator.tap (timeMicros)
+          == TempoEstimator::TapResult::TempoAvailable
+      && rampTempoBPM (tempoEstimator.getTempoBPM (), tapRampBeats))
     {
-      setTempoBPM (_tempoEstimator->getTempoBPM ());
       return TapResult::TempoAvailable;
       // TODO: send OSC tempo via async command queue
       // we will have to indirect this through the MotionEngine
@@ -350,9 +534,38 @@ TempoClock::tap (juce::int64 timeMicros)
   return TapResult::TempoNotAvailable;
 }
 
+void
+TempoClock::resetTaps (TapSource source)
+{
+  getTempoEstimator (source).reset ();
+}
+
+TempoEstimator &
+TempoClock::getTempoEstimator (TapSource source)
+{
+  switch (source)
+    {
+    case TapSource::Controller:
+      return *_tempoEstimator;
+    case TapSource::BeatTracker:
+      return *_tempoEstimatorBeatTracker;
+    }
+  jassertfalse;
+  return *_tempoEstimator;
+}
+
 void
 TempoClock::start ()
 {
+  if (_timeSourceVirtual)
+    {
+      // start counting at the current virtual time
+      _timer->reset = true;
+      _isRunningVirtual = true;
+      _timer->hiResTimerCallback ();
+      return;
+    }
+
   if (!_timer->isTimerRunning ())
     {
       _timer->reset = true;
@@ -372,6 +585,8 @@ TempoClock::start ()
 void
 TempoClock::stop ()
 {
+  _isRunningVirtual = false;
+
   if (_timer->isTimerRunning ())
     {
       _timer->stopTimer ();
@@ -387,6 +602,26 @@ TempoClock::reset ()
   _timer->reset = true;
 }
 
+void
+TempoClock::advance (TimeSource::ClockT::duration duration)
+{
+  jassert (_timeSourceVirtual != nullptr);
+  if (_timeSourceVirtual == nullptr)
+    return;
+
+  auto constexpr interval = std::chrono::milliseconds (timerIntervalMs);
+  while (duration > decltype (duration)::zero ())
+    {
+      auto const step = std::min<TimeSource::ClockT::duration> (duration,
+                                                                interval);
+      _timeSourceVirtual->advance (step);
+      duration -= step;
+
+      if (_isRunningVirtual)
+        _timer->hiResTimerCallback ();
+    }
+}
+
 Measure
 TempoClock::nextDownBeat (Measure const &measure)
 {
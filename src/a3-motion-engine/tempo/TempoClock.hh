@@ -30,6 +30,7 @@
 
 #include <a3-motion-engine/Config.hh>
 #include <a3-motion-engine/Measure.hh>
+#include <a3-motion-engine/tempo/TimeSource.hh>
 #include <a3-motion-engine/util/Types.hh>
 
 class ClockTimer;
@@ -77,16 +78,47 @@ public:
     TempoNotAvailable
   };
 
+  enum class RampShape
+  {
+    Linear,
+    Exponential
+  };
+
+  // Taps of different sources are stamped with different clocks and
+  // must not be mixed, so each source has its own estimator.
+  enum class TapSource
+  {
+    Controller,
+    BeatTracker
+  };
+
   using CallbackT = void (Measure);
   using PointerT = std::shared_ptr<std::function<CallbackT> >;
 
-  TempoClock ();
+  TempoClock (std::shared_ptr<TimeSource> timeSource
+              = std::make_shared<TimeSourceSystem> ());
   ~TempoClock ();
 
-  TapResult tap (juce::int64 timeMicros);
-
+  TapResult tap (juce::int64 timeMicros,
+                TapSource source = TapSource::Controller);
+  // Forgets the taps of a source, e.g. when its clock restarts.
+  void resetTaps (TapSource source);
+
+  /* Tempo changes are picked up by the timer thread and applied at
+   the current position within the running tick, so the beat phase
+   does not jump. A ramp changes the tempo on every tick until the
+   target is reached after the given number of beats, linearly or
+   with a constant ratio per tick (exponential). getTempoBPM ()
+   returns the target of the latest change, getCurrentTempoBPM () the
+   tempo the clock is running at, which differs during a ramp.
+   Tempos that are not finite or not positive are rejected and false
+   is returned.
+   */
   float getTempoBPM () const;
-  void setTempoBPM (float tempoBPM);
+  float getCurrentTempoBPM () const;
+  bool setTempoBPM (float tempoBPM);
+  bool rampTempoBPM (float tempoBPM, float durationBeats,
+                     RampShape shape = RampShape::Linear);
 
   int getBeatsPerBar () const;
   void setBeatsPerBar (int beatsPerBar);
@@ -103,9 +135,18 @@ public:
                                          Event event, Execution execution,
                                          bool waitForAck = false);
 
+  /* With a real-time source, start () runs the clock on a high
+   priority timer thread. With a virtual time source, start () emits
+   the initial events on the calling thread and the clock only moves
+   on when advance () is called. It steps the time source forward by
+   the timer interval and runs the timer callback after each step,
+   so handlers with Execution::TimerThread are called synchronously
+   from within advance ().
+   */
   void start ();
   void stop ();
   void reset ();
+  void advance (TimeSource::ClockT::duration duration);
 
   static constexpr int
   getTicksPerBeat ()
@@ -121,15 +162,26 @@ private:
   // modern sequencers up to 960 (Wikipedia) to capture timing
   // nuances.
   static constexpr int ticksPerBeat = 128;
+  // tap tempo corrections are smoothed over this many beats
+  static constexpr float tapRampBeats = 1.f;
+
+  std::shared_ptr<TimeSource> _timeSource;
+  TimeSourceVirtual *_timeSourceVirtual = nullptr;
+  bool _isRunningVirtual = false;
 
   std::unique_ptr<ClockTimer> _timer;
   std::unique_ptr<TempoEstimator> _tempoEstimator;
+  std::unique_ptr<TempoEstimator> _tempoEstimatorBeatTracker;
+
+  TempoEstimator &getTempoEstimator (TapSource source);
 
   // We use a single-producer single-consumer lock-less ring buffer to
   // forward add/delete requests of event handlers to the timer
   // thread. To extend this to multiple callers we lock on the
   // producer side.
   std::mutex _mutexWriteFifo;
+  // Same for tempo changes, which only keep the latest request.
+  std::mutex _mutexWriteTempo;
 
   std::atomic<float> _beatsPerMinute{ 60.f };
   std::atomic<int> _beatsPerBar{ 4 };
@@ -20,7 +20,6 @@
 
 #include "TempoEstimator.hh"
 
-#include <algorithm>
 #include <chrono>
 
 #include <JuceHeader.h>
@@ -34,21 +33,28 @@ TempoEstimator::tap (juce::int64 timeMicros)
   auto deltaT = timeMicros - timeTapLastMicros;
   timeTapLastMicros = timeMicros;
 
-  if (deltaT > std::chrono::duration_cast<std::chrono::microseconds> (
-                   timeBetweenTapsMax)
-                   .count ())
+  // a tap that is not later than the previous one means the clock
+  // restarted or taps from different clocks were mixed
+  if (deltaT <= 0
+      || deltaT > std::chrono::duration_cast<std::chrono::microseconds> (
+                      timeBetweenTapsMax)
+                      .count ())
     {
       // juce::Logger::writeToLog ("flushing tap time queue");
-      std::deque<ClockT::time_point> queueEmpty;
-      std::swap (_queueTapTimes, queueEmpty);
+      _indexTapOldest = 0;
+      _numTaps = 0;
+    }
+  else if (_numTaps == numTapsMax)
+    {
+      _indexTapOldest = (_indexTapOldest + 1) % numTapsMax;
+      --_numTaps;
     }
-  else if (_queueTapTimes.size () == numTapsMax)
-    _queueTapTimes.pop_front ();
 
-  _queueTapTimes.push_back (ClockT::time_point ()
-                            + std::chrono::microseconds (timeMicros));
+  _tapTimes[(_indexTapOldest + _numTaps) % numTapsMax]
+      = ClockT::time_point () + std::chrono::microseconds (timeMicros);
+  ++_numTaps;
 
-  if (_queueTapTimes.size () >= numTapsMin)
+  if (_numTaps >= numTapsMin)
     {
       estimateTempo ();
       return TapResult::TempoAvailable;
@@ -57,35 +63,33 @@ TempoEstimator::tap (juce::int64 timeMicros)
   return TapResult::TempoNotAvailable;
 }
 
-std::vector<TempoEstimator::ClockT::time_point>
-TempoEstimator::getTapTimes ()
+void
+TempoEstimator::reset ()
 {
-  std::vector<ClockT::time_point> tapTimes;
-  tapTimes.reserve (_queueTapTimes.size ());
-  std::copy (_queueTapTimes.begin (), _queueTapTimes.end (),
-             std::back_inserter (tapTimes));
-  return tapTimes;
+  _indexTapOldest = 0;
+  _numTaps = 0;
+  timeTapLastMicros = 0;
+  _tempoDeltaT = ClockT::duration (0);
 }
 
-std::vector<TempoEstimator::ClockT::duration>
-TempoEstimator::getTapTimeDeltas ()
+std::size_t
+TempoEstimator::getNumTaps () const
 {
-  auto tapTimeDeltas
-      = std::vector<ClockT::duration> (_queueTapTimes.size () - 1);
-  auto timeLast = ClockT::time_point ();
-  for (auto index = 0u; index < _queueTapTimes.size (); ++index)
-    {
-      if (index == 0)
-        {
-          timeLast = _queueTapTimes[index];
-          continue;
-        }
-
-      tapTimeDeltas[index - 1] = _queueTapTimes[index] - timeLast;
-      timeLast = _queueTapTimes[index];
-    }
+  return _numTaps;
+}
 
-  return tapTimeDeltas;
+TempoEstimator::ClockT::time_point
+TempoEstimator::getTapTime (std::size_t index) const
+{
+  jassert (index < _numTaps);
+  return _tapTimes[(_indexTapOldest + index) % numTapsMax];
+}
+
+TempoEstimator::ClockT::duration
+TempoEstimator::getTapTimeDelta (std::size_t index) const
+{
+  jassert (index + 1 < _numTaps);
+  return getTapTime (index + 1) - getTapTime (index);
 }
 
 void
@@ -20,8 +20,8 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
-#include <deque>
 
 #include <JuceHeader.h>
 
@@ -42,6 +42,9 @@ public:
   TapResult tap (juce::int64 timeMicros);
   virtual void estimateTempo () = 0;
 
+  // forgets all taps, e.g. when the tap clock restarts
+  void reset ();
+
   float getTempoBPM () const;
 
   // for testing
@@ -49,19 +52,29 @@ public:
   ClockT::duration getTempoDeltaT () const;
 
 protected:
-  static auto constexpr numTapsMin = 2;
-  static auto constexpr numTapsMax = 16;
+  static std::size_t constexpr numTapsMin = 2;
+  static std::size_t constexpr numTapsMax = 16;
   static auto constexpr timeBetweenTapsMax = std::chrono::seconds (2);
 
-  std::vector<ClockT::time_point> getTapTimes ();
-  std::vector<ClockT::duration> getTapTimeDeltas ();
+  // Accessors into the tap ring buffer. Index 0 refers to the
+  // oldest tap that is still considered for estimation. The delta at
+  // index i is the time between taps i and i+1.
+  std::size_t getNumTaps () const;
+  ClockT::time_point getTapTime (std::size_t index) const;
+  ClockT::duration getTapTimeDelta (std::size_t index) const;
 
   void setTempoDeltaT (ClockT::duration deltaT);
 
 private:
-  std::deque<ClockT::time_point> _queueTapTimes;
-  juce::int64 timeTapLastMicros;
-  ClockT::duration _tempoDeltaT;
+  // Taps are kept in a fixed-size ring buffer so that tapping does
+  // not allocate and can be handled from any thread at constant
+  // cost.
+  std::array<ClockT::time_point, numTapsMax> _tapTimes;
+  std::size_t _indexTapOldest = 0;
+  std::size_t _numTaps = 0;
+
+  juce::int64 timeTapLastMicros = 0;
+  ClockT::duration _tempoDeltaT{ 0 };
 };
 
 }
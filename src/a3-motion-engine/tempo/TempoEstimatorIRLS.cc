@@ -45,6 +45,37 @@ namespace a3
 TempoEstimatorIRLS::TempoEstimatorIRLS ()
 {
   gsl_set_error_handler (gsl_error_handler);
+
+  _X = gsl_matrix_alloc (numTapsMax, numParameters);
+  for (auto index = 0u; index < numTapsMax; ++index)
+    {
+      gsl_matrix_set (_X, index, 0, 1.0);
+      gsl_matrix_set (_X, index, 1, index);
+    }
+
+  _y = gsl_vector_alloc (numTapsMax);
+  _coefficients = gsl_vector_alloc (numParameters);
+  _covariance = gsl_matrix_alloc (numParameters, numParameters);
+
+  for (auto numObservations = numTapsMin; numObservations <= numTapsMax;
+       ++numObservations)
+    {
+      _workspaces[numObservations] = gsl_multifit_robust_alloc (
+          gsl_multifit_robust_default, numObservations, numParameters);
+    }
+}
+
+TempoEstimatorIRLS::~TempoEstimatorIRLS ()
+{
+  for (auto workspace : _workspaces)
+    {
+      if (workspace)
+        gsl_multifit_robust_free (workspace);
+    }
+  gsl_matrix_free (_covariance);
+  gsl_vector_free (_coefficients);
+  gsl_vector_free (_y);
+  gsl_matrix_free (_X);
 }
 
 void
@@ -54,47 +85,27 @@ TempoEstimatorIRLS::estimateTempo ()
   // adapted from
   // http://transit.iut2.upmf-grenoble.fr/doc/gsl-ref-html/Fitting-robust-linear-regression-example.html
 
-  auto const tapTimes = getTapTimes ();
-  jassert (tapTimes.size () >= numTapsMin);
-  std::cout << "tapTimes.size (): " << tapTimes.size () << std::endl;
+  auto const numObservations = getNumTaps ();
+  jassert (numObservations >= numTapsMin);
 
-  auto const numObservations = tapTimes.size ();
-  auto constexpr numParameters = 2; // linear slope and offset
-
-  auto y = gsl_vector_alloc (numObservations);
+  auto const tapTimeFirst = getTapTime (0);
   for (auto index = 0u; index < numObservations; ++index)
     {
       auto timeMicros = std::chrono::duration_cast<std::chrono::microseconds> (
-                            tapTimes[index] - tapTimes[0])
+                            getTapTime (index) - tapTimeFirst)
                             .count ();
-      gsl_vector_set (y, index, timeMicros);
+      gsl_vector_set (_y, index, timeMicros);
     }
 
-  auto X = gsl_matrix_alloc (numObservations, numParameters);
-  for (auto index = 0u; index < numObservations; ++index)
-    {
-      gsl_matrix_set (X, index, 0, 1.0);
-      gsl_matrix_set (X, index, 1, index);
-    }
+  auto const X
+      = gsl_matrix_const_submatrix (_X, 0, 0, numObservations, numParameters);
+  auto const y = gsl_vector_const_subvector (_y, 0, numObservations);
 
-  auto coefficients = gsl_vector_alloc (numParameters);
-  auto covariance = gsl_matrix_alloc (numParameters, numParameters);
-  auto workspace = gsl_multifit_robust_alloc (gsl_multifit_robust_default,
-                                              numObservations, numParameters);
-
-  auto iterations
-      = gsl_multifit_robust (X, y, coefficients, covariance, workspace);
-  juce::Logger::writeToLog ("robust fit iterations: "
-                            + juce::String (iterations));
+  gsl_multifit_robust (&X.matrix, &y.vector, _coefficients, _covariance,
+                       _workspaces[numObservations]);
 
   setTempoDeltaT (std::chrono::microseconds (
-      (long long)(gsl_vector_get (coefficients, 1))));
-
-  gsl_multifit_robust_free (workspace);
-  gsl_matrix_free (covariance);
-  gsl_vector_free (coefficients);
-  gsl_matrix_free (X);
-  gsl_vector_free (y);
+      (long long)(gsl_vector_get (_coefficients, 1))));
 }
 
 }
@@ -20,8 +20,11 @@
 
 #include <a3-motion-engine/tempo/TempoEstimator.hh>
 
+#include <array>
 #include <chrono>
 
+#include <gsl/gsl_multifit.h>
+
 namespace a3
 {
 
@@ -29,7 +32,25 @@ class TempoEstimatorIRLS : public TempoEstimator
 {
 public:
   TempoEstimatorIRLS ();
+  ~TempoEstimatorIRLS ();
+
+  TempoEstimatorIRLS (TempoEstimatorIRLS const &) = delete;
+  TempoEstimatorIRLS &operator= (TempoEstimatorIRLS const &) = delete;
+
   void estimateTempo () override;
+
+private:
+  static auto constexpr numParameters = 2; // linear slope and offset
+
+  // The design matrix and observation vector are allocated for
+  // numTapsMax rows, estimation operates on views of the first
+  // getNumTaps () rows. GSL robust workspaces are bound to a fixed
+  // number of observations, so we keep one per possible tap count.
+  gsl_matrix *_X;
+  gsl_vector *_y;
+  gsl_vector *_coefficients;
+  gsl_matrix *_covariance;
+  std::array<gsl_multifit_robust_workspace *, numTapsMax + 1> _workspaces{};
 };
 
 }
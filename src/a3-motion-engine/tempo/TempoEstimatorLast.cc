@@ -20,8 +20,6 @@
 
 #include "TempoEstimatorLast.hh"
 
-#include <numeric>
-
 #include <JuceHeader.h>
 
 namespace a3
@@ -32,9 +30,9 @@ TempoEstimatorLast::TempoEstimatorLast () {}
 void
 TempoEstimatorLast::estimateTempo ()
 {
-  auto deltaTs = getTapTimeDeltas ();
-  jassert (deltaTs.size () > 0);
-  setTempoDeltaT (deltaTs.back ());
+  auto const numTaps = getNumTaps ();
+  jassert (numTaps >= numTapsMin);
+  setTempoDeltaT (getTapTimeDelta (numTaps - 2));
 }
 
 }
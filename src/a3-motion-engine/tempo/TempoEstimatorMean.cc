@@ -20,8 +20,6 @@
 
 #include "TempoEstimatorMean.hh"
 
-#include <numeric>
-
 #include <JuceHeader.h>
 
 namespace a3
@@ -32,15 +30,13 @@ TempoEstimatorMean::TempoEstimatorMean () {}
 void
 TempoEstimatorMean::estimateTempo ()
 {
-  auto deltaTs = getTapTimeDeltas ();
-  jassert (deltaTs.size () > 0);
-
-  ClockT::duration sumDeltaT{ 0 };
-  for (auto &deltaT : deltaTs)
-    {
-      sumDeltaT += deltaT;
-    }
-  auto tempoDeltaT = sumDeltaT / deltaTs.size ();
+  auto const numTaps = getNumTaps ();
+  jassert (numTaps >= numTapsMin);
+
+  // the sum of all consecutive deltas telescopes to the time between
+  // the oldest and the newest tap, so the mean is O(1).
+  auto const sumDeltaT = getTapTime (numTaps - 1) - getTapTime (0);
+  auto const tempoDeltaT = sumDeltaT / static_cast<ClockT::rep> (numTaps - 1);
   setTempoDeltaT (tempoDeltaT);
 }
 
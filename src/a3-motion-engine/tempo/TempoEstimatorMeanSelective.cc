@@ -22,7 +22,6 @@
 
 #include <algorithm>
 #include <chrono>
-#include <limits>
 #include <numeric>
 
 #include <JuceHeader.h>
@@ -39,51 +38,33 @@ TempoEstimatorMeanSelective::TempoEstimatorMeanSelective (
 void
 TempoEstimatorMeanSelective::estimateTempo ()
 {
-  auto deltaTs = getTapTimeDeltas ();
-  jassert (deltaTs.size () > 0);
-
-  ClockT::duration sumDeltaT{ 0 };
-  for (auto &deltaT : deltaTs)
-    {
-      sumDeltaT += deltaT;
-    }
-
-  // casting because chrono::abs below chokes on signedness with
-  // gcc 13.1
-  jassert (deltaTs.size () <= std::numeric_limits<ssize_t>::max ());
-  auto deltaTAverage = sumDeltaT / static_cast<ssize_t> (deltaTs.size ());
-
-  std::sort (deltaTs.begin (), deltaTs.end (),
-             [deltaTAverage] (auto &a, auto &b) {
-               auto const deltaA = std::chrono::abs (a - deltaTAverage);
-               auto const deltaB = std::chrono::abs (b - deltaTAverage);
-               return deltaA < deltaB;
-             });
-
-  juce::Logger::writeToLog ("-----------------");
-  for (auto &deltaT : deltaTs)
-    {
-      juce::Logger::writeToLog (juce::String (
-          std::abs (std::chrono::duration_cast<std::chrono::milliseconds> (
-                        deltaT - deltaTAverage)
-                        .count ())));
-    }
-
-  jassert (deltaTs.size () < std::numeric_limits<int>::max ());
-  auto numSelected
-      = std::min (_numSelectedDeltas, static_cast<int> (deltaTs.size ()));
-  sumDeltaT = std::accumulate (
-      deltaTs.begin (), deltaTs.begin () + numSelected, ClockT::duration{ 0 });
-  auto const tempoDeltaT = sumDeltaT / numSelected;
-
-  // juce::Logger::writeToLog ("averaging time deltas: "
-  //                           + juce::String (_queueDeltaTs.size ()));
-  // juce::Logger::writeToLog (
-  //     "tempo: "
-  //     + juce::String (
-  //         std::abs (std::chrono::duration_cast<std::chrono::milliseconds> (
-  //                       tempoDeltaT - deltaTAverage)
-  //                       .count ())));
+  auto const numTaps = getNumTaps ();
+  jassert (numTaps >= numTapsMin);
+
+  auto const numDeltas = numTaps - 1;
+  for (auto index = 0u; index < numDeltas; ++index)
+    _deltaTs[index] = getTapTimeDelta (index);
+
+  // dividing by the signed representation because chrono::abs below
+  // chokes on unsigned durations with gcc 13.1
+  auto const deltaTAverage = (getTapTime (numTaps - 1) - getTapTime (0))
+                             / static_cast<ClockT::rep> (numDeltas);
+
+  // we only need the numSelected deltas closest to the average, not
+  // their order, so a partial selection suffices.
+  auto const numSelected = std::min (
+      static_cast<std::size_t> (std::max (_numSelectedDeltas, 1)), numDeltas);
+  auto const begin = _deltaTs.begin ();
+  std::nth_element (begin, begin + (numSelected - 1), begin + numDeltas,
+                    [deltaTAverage] (auto const &a, auto const &b) {
+                      auto const deltaA = std::chrono::abs (a - deltaTAverage);
+                      auto const deltaB = std::chrono::abs (b - deltaTAverage);
+                      return deltaA < deltaB;
+                    });
+
+  auto const sumDeltaT
+      = std::accumulate (begin, begin + numSelected, ClockT::duration{ 0 });
+  auto const tempoDeltaT = sumDeltaT / static_cast<ClockT::rep> (numSelected);
 
   setTempoDeltaT (tempoDeltaT);
 }
@@ -20,6 +20,7 @@
 
 #include <a3-motion-engine/tempo/TempoEstimator.hh>
 
+#include <array>
 #include <chrono>
 
 namespace a3
@@ -33,6 +34,10 @@ public:
 
 private:
   int _numSelectedDeltas;
+
+  // scratch space for selecting the deltas closest to the average,
+  // allocated once with the estimator.
+  std::array<ClockT::duration, numTapsMax - 1> _deltaTs;
 };
 
 }
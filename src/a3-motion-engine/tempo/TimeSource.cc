@@ -0,0 +1,56 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "TimeSource.hh"
+
+namespace a3
+{
+
+TimeSource::ClockT::time_point
+TimeSourceSystem::now () const
+{
+  return ClockT::now ();
+}
+
+bool
+TimeSourceSystem::isRealTime () const
+{
+  return true;
+}
+
+TimeSource::ClockT::time_point
+TimeSourceVirtual::now () const
+{
+  return ClockT::time_point (ClockT::duration (_now.load ()));
+}
+
+bool
+TimeSourceVirtual::isRealTime () const
+{
+  return false;
+}
+
+void
+TimeSourceVirtual::advance (ClockT::duration duration)
+{
+  _now += duration.count ();
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+namespace a3
+{
+
+/*
+ * TimeSource provides the current time to the TempoClock. The system
+ * time source follows the real time, while a virtual time source only
+ * moves forward when it is advanced explicitly. The latter lets tests
+ * and simulations step the clock deterministically and run much
+ * faster than real time, see TempoClock::advance ().
+ */
+class TimeSource
+{
+public:
+  using ClockT = std::chrono::high_resolution_clock;
+
+  virtual ~TimeSource (){};
+
+  virtual ClockT::time_point now () const = 0;
+  virtual bool isRealTime () const = 0;
+};
+
+class TimeSourceSystem : public TimeSource
+{
+public:
+  ClockT::time_point now () const override;
+  bool isRealTime () const override;
+};
+
+class TimeSourceVirtual : public TimeSource
+{
+public:
+  ClockT::time_point now () const override;
+  bool isRealTime () const override;
+
+  void advance (ClockT::duration duration);
+
+private:
+  std::atomic<ClockT::rep> _now{ 0 };
+  static_assert (std::atomic<ClockT::rep>::is_always_lock_free);
+};
+
+}
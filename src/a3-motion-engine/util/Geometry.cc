@@ -0,0 +1,545 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "Geometry.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+using namespace a3;
+
+/* The kernels below are written once against a small set of
+ * operations, which are implemented for plain floats and for four
+ * lanes of SSE2 or NEON. The scalar version also converts the
+ * remainder of the arrays, so all positions get the same
+ * approximation.
+ */
+struct Scalar
+{
+  using Float = float;
+  using Int = std::int32_t;
+  using Mask = bool;
+  static constexpr std::size_t width = 1;
+
+  static Float
+  load (float const *p)
+  {
+    return *p;
+  }
+  static void
+  store (float *p, Float v)
+  {
+    *p = v;
+  }
+  static Float
+  splat (float v)
+  {
+    return v;
+  }
+
+  static Float
+  add (Float a, Float b)
+  {
+    return a + b;
+  }
+  static Float
+  sub (Float a, Float b)
+  {
+    return a - b;
+  }
+  static Float
+  mul (Float a, Float b)
+  {
+    return a * b;
+  }
+  static Float
+  div (Float a, Float b)
+  {
+    return a / b;
+  }
+  // a * b + c
+  static Float
+  madd (Float a, Float b, Float c)
+  {
+    return a * b + c;
+  }
+  static Float
+  sqrt (Float v)
+  {
+    return std::sqrt (v);
+  }
+  static Float
+  abs (Float v)
+  {
+    return std::abs (v);
+  }
+  static Float
+  min (Float a, Float b)
+  {
+    return std::min (a, b);
+  }
+  static Float
+  max (Float a, Float b)
+  {
+    return std::max (a, b);
+  }
+
+  static Mask
+  greater (Float a, Float b)
+  {
+    return a > b;
+  }
+  static Mask
+  isNegative (Float v)
+  {
+    return std::signbit (v);
+  }
+  static Float
+  select (Mask m, Float a, Float b)
+  {
+    return m ? a : b;
+  }
+  static Float
+  negateIf (Mask m, Float v)
+  {
+    return m ? -v : v;
+  }
+
+  static Int
+  roundToInt (Float v)
+  {
+    return Int (std::lrint (v));
+  }
+  static Float
+  toFloat (Int v)
+  {
+    return Float (v);
+  }
+  static Int
+  addInt (Int v, int n)
+  {
+    return v + n;
+  }
+  static Mask
+  isBitSet (Int v, int bit)
+  {
+    return (v & bit) != 0;
+  }
+};
+
+#if defined(__SSE2__)
+struct Simd
+{
+  using Float = __m128;
+  using Int = __m128i;
+  using Mask = __m128;
+  static constexpr std::size_t width = 4;
+
+  static Float
+  load (float const *p)
+  {
+    return _mm_loadu_ps (p);
+  }
+  static void
+  store (float *p, Float v)
+  {
+    _mm_storeu_ps (p, v);
+  }
+  static Float
+  splat (float v)
+  {
+    return _mm_set1_ps (v);
+  }
+
+  static Float
+  add (Float a, Float b)
+  {
+    return _mm_add_ps (a, b);
+  }
+  static Float
+  sub (Float a, Float b)
+  {
+    return _mm_sub_ps (a, b);
+  }
+  static Float
+  mul (Float a, Float b)
+  {
+    return _mm_mul_ps (a, b);
+  }
+  static Float
+  div (Float a, Float b)
+  {
+    return _mm_div_ps (a, b);
+  }
+  static Float
+  madd (Float a, Float b, Float c)
+  {
+    return _mm_add_ps (_mm_mul_ps (a, b), c);
+  }
+  static Float
+  sqrt (Float v)
+  {
+    return _mm_sqrt_ps (v);
+  }
+  static Float
+  abs (Float v)
+  {
+    return _mm_andnot_ps (_mm_set1_ps (-0.f), v);
+  }
+  static Float
+  min (Float a, Float b)
+  {
+    return _mm_min_ps (a, b);
+  }
+  static Float
+  max (Float a, Float b)
+  {
+    return _mm_max_ps (a, b);
+  }
+
+  static Mask
+  greater (Float a, Float b)
+  {
+    return _mm_cmpgt_ps (a, b);
+  }
+  static Mask
+  isNegative (Float v)
+  {
+    return _mm_castsi128_ps (_mm_srai_epi32 (_mm_castps_si128 (v), 31));
+  }
+  static Float
+  select (Mask m, Float a, Float b)
+  {
+    return _mm_or_ps (_mm_and_ps (m, a), _mm_andnot_ps (m, b));
+  }
+  static Float
+  negateIf (Mask m, Float v)
+  {
+    return _mm_xor_ps (v, _mm_and_ps (m, _mm_set1_ps (-0.f)));
+  }
+
+  static Int
+  roundToInt (Float v)
+  {
+    return _mm_cvtps_epi32 (v);
+  }
+  static Float
+  toFloat (Int v)
+  {
+    return _mm_cvtepi32_ps (v);
+  }
+  static Int
+  addInt (Int v, int n)
+  {
+    return _mm_add_epi32 (v, _mm_set1_epi32 (n));
+  }
+  static Mask
+  isBitSet (Int v, int bit)
+  {
+    auto const bits = _mm_set1_epi32 (bit);
+    return _mm_castsi128_ps (
+        _mm_cmpeq_epi32 (_mm_and_si128 (v, bits), bits));
+  }
+};
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+struct Simd
+{
+  using Float = float32x4_t;
+  using Int = int32x4_t;
+  using Mask = uint32x4_t;
+  static constexpr std::size_t width = 4;
+
+  static Float
+  load (float const *p)
+  {
+    return vld1q_f32 (p);
+  }
+  static void
+  store (float *p, Float v)
+  {
+    vst1q_f32 (p, v);
+  }
+  static Float
+  splat (float v)
+  {
+    return vdupq_n_f32 (v);
+  }
+
+  static Float
+  add (Float a, Float b)
+  {
+    return vaddq_f32 (a, b);
+  }
+  static Float
+  sub (Float a, Float b)
+  {
+    return vsubq_f32 (a, b);
+  }
+  static Float
+  mul (Float a, Float b)
+  {
+    return vmulq_f32 (a, b);
+  }
+  static Float
+  div (Float a, Float b)
+  {
+    return vdivq_f32 (a, b);
+  }
+  static Float
+  madd (Float a, Float b, Float c)
+  {
+    return vfmaq_f32 (c, a, b);
+  }
+  static Float
+  sqrt (Float v)
+  {
+    return vsqrtq_f32 (v);
+  }
+  static Float
+  abs (Float v)
+  {
+    return vabsq_f32 (v);
+  }
+  static Float
+  min (Float a, Float b)
+  {
+    return vminq_f32 (a, b);
+  }
+  static Float
+  max (Float a, Float b)
+  {
+    return vmaxq_f32 (a, b);
+  }
+
+  static Mask
+  greater (Float a, Float b)
+  {
+    return vcgtq_f32 (a, b);
+  }
+  static Mask
+  isNegative (Float v)
+  {
+    return vreinterpretq_u32_s32 (vshrq_n_s32 (vreinterpretq_s32_f32 (v), 31));
+  }
+  static Float
+  select (Mask m, Float a, Float b)
+  {
+    return vbslq_f32 (m, a, b);
+  }
+  static Float
+  negateIf (Mask m, Float v)
+  {
+    auto const sign = vandq_u32 (m, vdupq_n_u32 (0x80000000u));
+    return vreinterpretq_f32_u32 (
+        veorq_u32 (vreinterpretq_u32_f32 (v), sign));
+  }
+
+  static Int
+  roundToInt (Float v)
+  {
+    return vcvtnq_s32_f32 (v);
+  }
+  static Float
+  toFloat (Int v)
+  {
+    return vcvtq_f32_s32 (v);
+  }
+  static Int
+  addInt (Int v, int n)
+  {
+    return vaddq_s32 (v, vdupq_n_s32 (n));
+  }
+  static Mask
+  isBitSet (Int v, int bit)
+  {
+    return vtstq_s32 (v, vdupq_n_s32 (bit));
+  }
+};
+#endif
+
+auto constexpr radiansPerDegree = pi<float> () / 180.f;
+auto constexpr degreesPerRadian = 180.f / pi<float> ();
+
+// pi / 2 split into a part with few significant bits and the rest,
+// so that subtracting multiples of it is exact for moderate angles.
+auto constexpr piHalfHigh = 1.5703125f;
+auto constexpr piHalfLow = 4.8382679e-4f;
+
+/* sin and cos of the angle reduced to [-pi / 4, pi / 4], with the
+ * quadrant selecting and negating the results. The truncated Taylor
+ * series are accurate to a few 1e-9 on the reduced range.
+ */
+template <typename O>
+void
+sinCosApprox (typename O::Float radians, typename O::Float &sine,
+              typename O::Float &cosine)
+{
+  auto const quadrant
+      = O::roundToInt (O::mul (radians, O::splat (2.f / pi<float> ())));
+  auto const k = O::toFloat (quadrant);
+  auto r = O::sub (radians, O::mul (k, O::splat (piHalfHigh)));
+  r = O::sub (r, O::mul (k, O::splat (piHalfLow)));
+  auto const r2 = O::mul (r, r);
+
+  auto s = O::splat (2.7557319e-6f);
+  s = O::madd (s, r2, O::splat (-1.9841270e-4f));
+  s = O::madd (s, r2, O::splat (8.3333333e-3f));
+  s = O::madd (s, r2, O::splat (-1.6666667e-1f));
+  s = O::madd (O::mul (s, r2), r, r);
+
+  auto c = O::splat (2.4801587e-5f);
+  c = O::madd (c, r2, O::splat (-1.3888889e-3f));
+  c = O::madd (c, r2, O::splat (4.1666667e-2f));
+  c = O::madd (c, r2, O::splat (-0.5f));
+  c = O::madd (c, r2, O::splat (1.f));
+
+  auto const swap = O::isBitSet (quadrant, 1);
+  sine = O::negateIf (O::isBitSet (quadrant, 2), O::select (swap, c, s));
+  cosine = O::negateIf (O::isBitSet (O::addInt (quadrant, 1), 2),
+                        O::select (swap, s, c));
+}
+
+/* atan2 from the atan of the ratio of the smaller and the larger
+ * magnitude in [0, 1], using the polynomial of Abramowitz and Stegun
+ * 4.4.49 with an error below 2e-8. The signs are handled like
+ * std::atan2, including signed zeros.
+ */
+template <typename O>
+typename O::Float
+atan2Approx (typename O::Float y, typename O::Float x)
+{
+  auto const absX = O::abs (x);
+  auto const absY = O::abs (y);
+  auto const larger = O::max (absX, absY);
+  auto const smaller = O::min (absX, absY);
+  auto const t = O::div (
+      smaller,
+      O::max (larger, O::splat (std::numeric_limits<float>::min ())));
+  auto const t2 = O::mul (t, t);
+
+  auto p = O::splat (0.0028662257f);
+  p = O::madd (p, t2, O::splat (-0.0161657367f));
+  p = O::madd (p, t2, O::splat (0.0429096138f));
+  p = O::madd (p, t2, O::splat (-0.0752896400f));
+  p = O::madd (p, t2, O::splat (0.1065626393f));
+  p = O::madd (p, t2, O::splat (-0.1420889944f));
+  p = O::madd (p, t2, O::splat (0.1999355085f));
+  p = O::madd (p, t2, O::splat (-0.3333314528f));
+  p = O::madd (p, t2, O::splat (1.f));
+  p = O::mul (p, t);
+
+  p = O::select (O::greater (absY, absX),
+                 O::sub (O::splat (pi<float> () / 2.f), p), p);
+  p = O::select (O::isNegative (x), O::sub (O::splat (pi<float> ()), p), p);
+  return O::negateIf (O::isNegative (y), p);
+}
+
+template <typename O>
+std::size_t
+convertToSpherical (float const *x, float const *y, float const *z,
+                    float *azimuth, float *elevation, float *distance,
+                    std::size_t index, std::size_t numPositions)
+{
+  for (; index + O::width <= numPositions; index += O::width)
+    {
+      auto const vx = O::load (x + index);
+      auto const vy = O::load (y + index);
+      auto const vz = O::load (z + index);
+
+      auto const rho2 = O::madd (vx, vx, O::mul (vy, vy));
+      auto const inclination = atan2Approx<O> (O::sqrt (rho2), vz);
+
+      O::store (azimuth + index,
+                O::mul (atan2Approx<O> (vy, vx), O::splat (degreesPerRadian)));
+      O::store (elevation + index,
+                O::sub (O::splat (90.f),
+                        O::mul (inclination, O::splat (degreesPerRadian))));
+      O::store (distance + index, O::sqrt (O::madd (vz, vz, rho2)));
+    }
+  return index;
+}
+
+template <typename O>
+std::size_t
+convertToCartesian (float const *azimuth, float const *elevation,
+                    float const *distance, float *x, float *y, float *z,
+                    std::size_t index, std::size_t numPositions)
+{
+  for (; index + O::width <= numPositions; index += O::width)
+    {
+      auto const radiansPerDegreeV = O::splat (radiansPerDegree);
+      typename O::Float sineA, cosineA, sineE, cosineE;
+      sinCosApprox<O> (O::mul (O::load (azimuth + index), radiansPerDegreeV),
+                       sineA, cosineA);
+      sinCosApprox<O> (O::mul (O::load (elevation + index), radiansPerDegreeV),
+                       sineE, cosineE);
+
+      auto const d = O::load (distance + index);
+      auto const rho = O::mul (cosineE, d);
+      O::store (x + index, O::mul (cosineA, rho));
+      O::store (y + index, O::mul (sineA, rho));
+      O::store (z + index, O::mul (sineE, d));
+    }
+  return index;
+}
+
+}
+
+namespace a3
+{
+
+void
+convertCartesianToSpherical (float const *x, float const *y, float const *z,
+                             float *azimuth, float *elevation,
+                             float *distance, std::size_t numPositions)
+{
+  auto index = std::size_t (0);
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+  index = convertToSpherical<Simd> (x, y, z, azimuth, elevation, distance,
+                                    index, numPositions);
+#endif
+  convertToSpherical<Scalar> (x, y, z, azimuth, elevation, distance, index,
+                              numPositions);
+}
+
+void
+convertSphericalToCartesian (float const *azimuth, float const *elevation,
+                             float const *distance, float *x, float *y,
+                             float *z, std::size_t numPositions)
+{
+  auto index = std::size_t (0);
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+  index = convertToCartesian<Simd> (azimuth, elevation, distance, x, y, z,
+                                    index, numPositions);
+#endif
+  convertToCartesian<Scalar> (azimuth, elevation, distance, x, y, z, index,
+                              numPositions);
+}
+
+}
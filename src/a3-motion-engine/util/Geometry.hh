@@ -21,6 +21,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 
 #include <JuceHeader.h>
 #include <limits>
@@ -261,6 +262,23 @@ Position<ScalarT>::fromSpherical (ScalarT const &azimuth,
   return p;
 }
 
+/* Batch conversions of many positions, stored as one array per
+ * coordinate (structure of arrays). Angles are in degrees like those
+ * of Position. sin, cos and atan2 are evaluated with polynomial
+ * approximations, four positions at a time where SSE2 or NEON is
+ * available. The absolute error is below 1e-4 degrees for angles and
+ * below 1e-6 times the distance for cartesian coordinates. The output
+ * arrays may be the input arrays.
+ */
+void convertCartesianToSpherical (float const *x, float const *y,
+                                  float const *z, float *azimuth,
+                                  float *elevation, float *distance,
+                                  std::size_t numPositions);
+void convertSphericalToCartesian (float const *azimuth,
+                                  float const *elevation,
+                                  float const *distance, float *x, float *y,
+                                  float *z, std::size_t numPositions);
+
 template <typename ScalarT>
 const Position<ScalarT> Position<ScalarT>::invalid
     = Position<ScalarT>::fromCartesian (
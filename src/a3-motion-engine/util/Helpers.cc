@@ -20,6 +20,8 @@
 
 #include "Helpers.hh"
 
+#include <unistd.h>
+
 namespace a3
 {
 
@@ -40,4 +42,28 @@ toString (Measure const &measure)
          juce::String (measure.tick ());
 }
 
+std::uint32_t
+crc32 (void const *data, std::size_t size, std::uint32_t crc)
+{
+  auto const *bytes = static_cast<std::uint8_t const *> (data);
+  crc = ~crc;
+  for (auto index = std::size_t (0); index < size; ++index)
+    {
+      crc ^= bytes[index];
+      for (auto bit = 0; bit < 8; ++bit)
+        crc = (crc >> 1) ^ (0xedb88320 & (0u - (crc & 1)));
+    }
+  return ~crc;
+}
+
+bool
+syncFileData (int fd)
+{
+#if defined(__linux__)
+  return ::fdatasync (fd) == 0;
+#else
+  return ::fsync (fd) == 0;
+#endif
+}
+
 }
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 
 #include <JuceHeader.h>
 
@@ -47,4 +48,11 @@ print (Timings<ClockT> const &timings)
 juce::String toString (Pos const &position);
 juce::String toString (Measure const &measure);
 
+// CRC-32 as used by zlib, pass the previous result to continue it
+std::uint32_t crc32 (void const *data, std::size_t size,
+                     std::uint32_t crc = 0);
+
+// flushes file data to disk, using fdatasync where available
+bool syncFileData (int fd);
+
 }
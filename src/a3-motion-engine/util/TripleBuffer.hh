@@ -0,0 +1,93 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace a3
+{
+
+/* Lock-free single-producer single-consumer triple buffer. The
+ * producer fills the write buffer and publishes it by swapping it with
+ * the shared middle buffer, the consumer picks up the latest published
+ * buffer the same way. Neither side ever waits, and the consumer always
+ * sees a complete value, skipping intermediate ones if it falls behind.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+  TripleBuffer () = default;
+  explicit TripleBuffer (T const &initial)
+      : _buffers{ initial, initial, initial }
+  {
+  }
+
+  // producer side: the returned buffer contains stale data from an
+  // earlier publish and has to be overwritten completely.
+  T &
+  getWriteBuffer ()
+  {
+    return _buffers[_indexWrite];
+  }
+
+  void
+  publish ()
+  {
+    _indexWrite = _middle.exchange (_indexWrite | freshBit,
+                                    std::memory_order_acq_rel)
+                  & indexMask;
+  }
+
+  // consumer side: returns true if a new value was published since
+  // the last call.
+  bool
+  update ()
+  {
+    if (!(_middle.load (std::memory_order_relaxed) & freshBit))
+      return false;
+
+    _indexRead = _middle.exchange (_indexRead, std::memory_order_acq_rel)
+                 & indexMask;
+    return true;
+  }
+
+  T const &
+  getReadBuffer () const
+  {
+    return _buffers[_indexRead];
+  }
+
+private:
+  static constexpr std::uint8_t indexMask = 0x3;
+  static constexpr std::uint8_t freshBit = 0x4;
+
+  std::array<T, 3> _buffers;
+
+  static_assert (std::atomic<std::uint8_t>::is_always_lock_free);
+  std::atomic<std::uint8_t> _middle{ 1 };
+  std::uint8_t _indexWrite = 0;
+  std::uint8_t _indexRead = 2;
+};
+
+}
@@ -0,0 +1,140 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ControllerSimulator.hh"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace a3
+{
+
+ControllerSimulator::ControllerSimulator ()
+{
+  _fdMaster = posix_openpt (O_RDWR | O_NOCTTY);
+  if (_fdMaster < 0 || grantpt (_fdMaster) != 0 || unlockpt (_fdMaster) != 0)
+    return;
+
+  _devicePath = ptsname (_fdMaster);
+  _fdSlave = open (_devicePath.c_str (), O_RDWR | O_NOCTTY);
+  if (_fdSlave < 0)
+    return;
+
+  // like a USB CDC device, no line discipline in between
+  termios attributes;
+  if (tcgetattr (_fdSlave, &attributes) == 0)
+    {
+      cfmakeraw (&attributes);
+      tcsetattr (_fdSlave, TCSANOW, &attributes);
+    }
+}
+
+ControllerSimulator::~ControllerSimulator ()
+{
+  if (_fdSlave >= 0)
+    close (_fdSlave);
+  if (_fdMaster >= 0)
+    close (_fdMaster);
+}
+
+bool
+ControllerSimulator::isOpen () const
+{
+  return _fdMaster >= 0 && _fdSlave >= 0;
+}
+
+std::string const &
+ControllerSimulator::getDevicePath () const
+{
+  return _devicePath;
+}
+
+bool
+ControllerSimulator::send (ControllerProtocol::Packet const &packet)
+{
+  ControllerProtocol::Frame frame;
+  auto const size = ControllerProtocol::encodeFrame (packet, frame);
+  return sendBytes (frame.data (), size);
+}
+
+bool
+ControllerSimulator::sendBytes (std::uint8_t const *data, std::size_t size)
+{
+  while (size > 0)
+    {
+      auto const written = write (_fdMaster, data, size);
+      if (written <= 0)
+        return false;
+      data += written;
+      size -= static_cast<std::size_t> (written);
+    }
+  return true;
+}
+
+int
+ControllerSimulator::receive (int timeoutMillis)
+{
+  pollfd fd{ _fdMaster, POLLIN, 0 };
+  if (poll (&fd, 1, timeoutMillis) <= 0)
+    return 0;
+
+  auto numPackets = 0;
+  _protocol.readFrom (_fdMaster, [this, &numPackets] (auto const &packet) {
+    using PacketType = ControllerProtocol::PacketType;
+    if (packet.type == PacketType::PadLEDFrame)
+      {
+        std::copy_n (packet.payload.begin (), _padColours.size (),
+                     _padColours.begin ());
+        ++_numPadLEDFrames;
+        ++numPackets;
+      }
+    else if (packet.type == PacketType::ButtonLEDs)
+      {
+        _buttonLEDs = packet.payload[0];
+        ++numPackets;
+      }
+  });
+  return numPackets;
+}
+
+ControllerSimulator::PadColours const &
+ControllerSimulator::getPadColours () const
+{
+  return _padColours;
+}
+
+std::uint8_t
+ControllerSimulator::getButtonLEDs () const
+{
+  return _buttonLEDs;
+}
+
+int
+ControllerSimulator::getNumPadLEDFrames () const
+{
+  return _numPadLEDFrames;
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <a3-motion-ui/io/ControllerProtocol.hh>
+
+namespace a3
+{
+
+/* Stands in for the V3 controller on a pseudo terminal, so the host
+ * side of the protocol can be exercised without hardware. The host
+ * opens getDevicePath () where it would open /dev/ttyACM0, input
+ * packets are sent with send () and LED packets from the host are
+ * picked up by receive ().
+ */
+class ControllerSimulator
+{
+public:
+  ControllerSimulator ();
+  ~ControllerSimulator ();
+
+  bool isOpen () const;
+  std::string const &getDevicePath () const;
+
+  bool send (ControllerProtocol::Packet const &packet);
+  // unframed bytes, e.g. to simulate line noise
+  bool sendBytes (std::uint8_t const *data, std::size_t size);
+
+  // Waits up to timeoutMillis for data from the host and applies the
+  // received LED packets, returns their number.
+  int receive (int timeoutMillis);
+
+  using PadColours
+      = std::array<std::uint8_t, ControllerProtocol::maxPayloadSize>;
+  PadColours const &getPadColours () const;
+  std::uint8_t getButtonLEDs () const;
+  int getNumPadLEDFrames () const;
+
+private:
+  int _fdMaster = -1;
+  // kept open so the master stays readable when the host closes
+  int _fdSlave = -1;
+  std::string _devicePath;
+
+  ControllerProtocol _protocol;
+  PadColours _padColours{};
+  std::uint8_t _buttonLEDs = 0;
+  int _numPadLEDFrames = 0;
+};
+
+}
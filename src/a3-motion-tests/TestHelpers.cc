@@ -0,0 +1,55 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "TestHelpers.hh"
+
+#include <cstdlib>
+#include <utility>
+
+namespace a3
+{
+
+TemporaryDirectoryTest::TemporaryDirectoryTest (std::string fileName)
+    : _fileName (std::move (fileName))
+{
+}
+
+void
+TemporaryDirectoryTest::SetUp ()
+{
+  char pathTemplate[] = "/tmp/a3-motion-tests-XXXXXX";
+  ASSERT_NE (::mkdtemp (pathTemplate), nullptr);
+  _directory = pathTemplate;
+  _path = (_directory / _fileName).string ();
+}
+
+void
+TemporaryDirectoryTest::TearDown ()
+{
+  if (!_directory.empty ())
+    std::filesystem::remove_all (_directory);
+}
+
+Pos
+positionForTick (index_t tick)
+{
+  return Pos::fromCartesian (float (tick), 0.5f, -1.f);
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Fixture for tests that write files. Each test gets a fresh
+ * directory below /tmp, which is removed with everything in it when
+ * the test ends. _path names the file given to the constructor
+ * inside of it.
+ */
+class TemporaryDirectoryTest : public ::testing::Test
+{
+protected:
+  explicit TemporaryDirectoryTest (std::string fileName);
+
+  void SetUp () override;
+  void TearDown () override;
+
+  std::filesystem::path _directory;
+  std::string _path;
+
+private:
+  std::string _fileName;
+};
+
+// distinct valid position for each tick, to check that recorded ticks
+// end up where they belong
+Pos positionForTick (index_t tick);
+
+}
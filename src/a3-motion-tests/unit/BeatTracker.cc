@@ -0,0 +1,150 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <gtest/gtest.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/tempo/BeatTracker.hh>
+
+using namespace a3;
+
+namespace
+{
+
+// Renders a stereo click track of decaying noise bursts, one per
+// beat, using a fixed-seed generator for reproducibility.
+std::vector<std::vector<float> >
+createClickTrack (double sampleRate, float tempoBPM, double seconds)
+{
+  auto const numSamples = static_cast<std::size_t> (sampleRate * seconds);
+  auto const samplesPerBeat = sampleRate * 60. / tempoBPM;
+  auto const samplesClick = static_cast<std::size_t> (sampleRate * 0.02);
+
+  std::vector<float> mono (numSamples, 0.f);
+  juce::Random random (42);
+  for (auto beatStart = 0.; beatStart < numSamples;
+       beatStart += samplesPerBeat)
+    {
+      auto const start = static_cast<std::size_t> (beatStart);
+      for (auto offset = 0u; offset < samplesClick; ++offset)
+        {
+          if (start + offset >= numSamples)
+            break;
+          auto const envelope
+              = std::exp (-5.f * float (offset) / float (samplesClick));
+          mono[start + offset] = envelope * (2.f * random.nextFloat () - 1.f);
+        }
+    }
+
+  return { mono, mono };
+}
+
+void
+processInBlocks (BeatTracker &beatTracker,
+                 std::vector<std::vector<float> > const &signal, int blockSize)
+{
+  auto const numSamples = static_cast<int> (signal[0].size ());
+  for (auto start = 0; start < numSamples; start += blockSize)
+    {
+      auto const numSamplesBlock = std::min (blockSize, numSamples - start);
+      float const *channels[]
+          = { signal[0].data () + start, signal[1].data () + start };
+      beatTracker.process (channels, 2, numSamplesBlock);
+    }
+}
+
+}
+
+TEST (BeatTracker, SilenceIsNotTracked)
+{
+  BeatTracker beatTracker;
+  beatTracker.prepare (48000.);
+
+  auto const silence = std::vector<std::vector<float> > (
+      2, std::vector<float> (48000 * 10, 0.f));
+  processInBlocks (beatTracker, silence, 512);
+
+  BeatTracker::Beat beat;
+  ASSERT_FALSE (beatTracker.isTracking ());
+  ASSERT_FALSE (beatTracker.popBeat (beat));
+}
+
+TEST (BeatTracker, FollowsClickTrack)
+{
+  for (auto sampleRate : { 44100., 48000., 96000. })
+    for (auto tempoBPM : { 90.f, 120.f, 128.f, 140.f })
+      {
+        BeatTracker beatTracker;
+        beatTracker.prepare (sampleRate);
+
+        auto const signal = createClickTrack (sampleRate, tempoBPM, 15.);
+        processInBlocks (beatTracker, signal, 256);
+
+        ASSERT_TRUE (beatTracker.isTracking ());
+        EXPECT_NEAR (beatTracker.getTempoBPM (), tempoBPM, 1.f)
+            << "sample rate: " << sampleRate;
+
+        // beats are emitted at the estimated period
+        auto const microsPerBeat = 60.e6 / tempoBPM;
+        std::vector<juce::int64> beatTimes;
+        BeatTracker::Beat beat;
+        while (beatTracker.popBeat (beat))
+          beatTimes.push_back (beat.timeMicros);
+
+        ASSERT_GE (beatTimes.size (), 4u);
+        auto const numDeltas = beatTimes.size () - 1;
+        auto const meanDelta
+            = double (beatTimes.back () - beatTimes.front ()) / numDeltas;
+        EXPECT_NEAR (meanDelta, microsPerBeat, 0.01 * microsPerBeat);
+      }
+}
+
+TEST (BeatTracker, FlagsClockRestart)
+{
+  BeatTracker beatTracker;
+  beatTracker.prepare (48000.);
+  auto const signal = createClickTrack (48000., 120.f, 10.);
+
+  juce::int64 timeMicrosLast = 0;
+  for (auto run = 0; run < 2; ++run)
+    {
+      // preparing again restarts the clock of the beat times
+      if (run > 0)
+        beatTracker.prepare (48000.);
+      processInBlocks (beatTracker, signal, 256);
+
+      std::vector<BeatTracker::Beat> beats;
+      BeatTracker::Beat beat;
+      while (beatTracker.popBeat (beat))
+        beats.push_back (beat);
+
+      ASSERT_GE (beats.size (), 2u);
+      EXPECT_TRUE (beats.front ().isFirstSinceReset);
+      for (auto index = 1u; index < beats.size (); ++index)
+        EXPECT_FALSE (beats[index].isFirstSinceReset);
+
+      if (run > 0)
+        {
+          EXPECT_LT (beats.front ().timeMicros, timeMicrosLast);
+        }
+      timeMicrosLast = beats.back ().timeMicros;
+    }
+}
@@ -0,0 +1,209 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <a3-motion-tests/ControllerSimulator.hh>
+#include <a3-motion-ui/io/ControllerProtocol.hh>
+
+using namespace a3;
+
+namespace
+{
+
+using Packet = ControllerProtocol::Packet;
+using PacketType = ControllerProtocol::PacketType;
+
+bool
+operator== (Packet const &lhs, Packet const &rhs)
+{
+  return lhs.type == rhs.type && lhs.payloadSize == rhs.payloadSize
+         && std::equal (lhs.payload.begin (),
+                        lhs.payload.begin () + lhs.payloadSize,
+                        rhs.payload.begin ());
+}
+
+std::vector<std::uint8_t>
+encode (Packet const &packet)
+{
+  ControllerProtocol::Frame frame;
+  auto const size = ControllerProtocol::encodeFrame (packet, frame);
+  return { frame.begin (), frame.begin () + size };
+}
+
+}
+
+TEST (ControllerProtocol, Crc16)
+{
+  auto const check = "123456789";
+  EXPECT_EQ (ControllerProtocol::crc16 (
+                 reinterpret_cast<std::uint8_t const *> (check), 9),
+             0x29b1);
+}
+
+TEST (ControllerProtocol, CobsRoundTrip)
+{
+  std::mt19937 random (7);
+  for (auto size : { 0, 1, 2, 253, 254, 255, 600 })
+    {
+      std::vector<std::uint8_t> data (std::size_t (size), 0);
+      for (auto &byte : data)
+        byte = random () % 4 == 0 ? 0 : std::uint8_t (random () % 255 + 1);
+      if (size == 600)
+        std::fill (data.begin (), data.begin () + 300, 0x55);
+
+      std::vector<std::uint8_t> encoded (data.size () + data.size () / 254
+                                         + 1);
+      encoded.resize (ControllerProtocol::cobsEncode (
+          data.data (), data.size (), encoded.data ()));
+      EXPECT_EQ (std::count (encoded.begin (), encoded.end (), 0), 0);
+
+      std::vector<std::uint8_t> decoded (encoded.size ());
+      auto const decodedSize = ControllerProtocol::cobsDecode (
+          encoded.data (), encoded.size (), decoded.data ());
+      ASSERT_TRUE (decodedSize.has_value ()) << size;
+      decoded.resize (*decodedSize);
+      EXPECT_EQ (decoded, data) << size;
+    }
+}
+
+TEST (ControllerProtocol, DropsCorruptedPackets)
+{
+  std::vector<std::uint8_t> stream;
+  auto const append = [&] (std::vector<std::uint8_t> const &bytes) {
+    stream.insert (stream.end (), bytes.begin (), bytes.end ());
+  };
+
+  append (encode (ControllerProtocol::makeButton (3, true)));
+  // flipped payload bit
+  auto corrupted = encode (ControllerProtocol::makePot (2, 512));
+  corrupted[3] ^= 0x10;
+  append (corrupted);
+  // noise without delimiter corrupts the following tap frame
+  append ({ 0x17, 0x42, 0x99 });
+  append (encode (ControllerProtocol::makeTap (1)));
+  // out of range index
+  append (encode (ControllerProtocol::makeEncoderPress (4, true)));
+  append (encode (ControllerProtocol::makeEncoderIncrement (1, -1)));
+  // other protocol version, valid CRC
+  std::array<std::uint8_t, 6> raw{ ControllerProtocol::version + 1,
+                                   std::uint8_t (PacketType::Button), 0, 1 };
+  auto const crc = ControllerProtocol::crc16 (raw.data (), 4);
+  raw[4] = std::uint8_t (crc);
+  raw[5] = std::uint8_t (crc >> 8);
+  std::vector<std::uint8_t> frame (8);
+  frame.resize (ControllerProtocol::cobsEncode (raw.data (), raw.size (),
+                                                frame.data ()));
+  frame.push_back (0);
+  append (frame);
+  // overlong frame
+  append (std::vector<std::uint8_t> (200, 0x01));
+  append ({ 0 });
+  append (encode (ControllerProtocol::makePot (7, 1023)));
+
+  ControllerProtocol protocol;
+  std::vector<Packet> packets;
+  protocol.feed (stream.data (), stream.size (),
+                 [&] (Packet const &packet) { packets.push_back (packet); });
+
+  ASSERT_EQ (packets.size (), 3u);
+  EXPECT_TRUE (packets[0] == ControllerProtocol::makeButton (3, true));
+  EXPECT_TRUE (packets[1] == ControllerProtocol::makeEncoderIncrement (1, -1));
+  EXPECT_TRUE (packets[2] == ControllerProtocol::makePot (7, 1023));
+  EXPECT_EQ (static_cast<std::int8_t> (packets[1].payload[1]), -1);
+  EXPECT_EQ (ControllerProtocol::readUint16 (&packets[2].payload[1]), 1023);
+  EXPECT_EQ (protocol.getNumPacketsDropped (), 5);
+}
+
+// Host and simulated controller exchange packets over a pseudo
+// terminal, the way the V3 adapter talks to the hardware.
+TEST (ControllerProtocol, SimulatorRoundTrip)
+{
+  ControllerSimulator simulator;
+  ASSERT_TRUE (simulator.isOpen ());
+
+  auto const host
+      = open (simulator.getDevicePath ().c_str (), O_RDWR | O_NOCTTY);
+  ASSERT_GE (host, 0);
+
+  std::vector<Packet> const sent = {
+    ControllerProtocol::makeButton (18, true),
+    ControllerProtocol::makeTap (0x0123456789abcdefull),
+    ControllerProtocol::makePot (5, 0),
+    ControllerProtocol::makeEncoderIncrement (3, 2),
+  };
+  for (auto const &packet : sent)
+    ASSERT_TRUE (simulator.send (packet));
+
+  ControllerProtocol protocol;
+  std::vector<Packet> received;
+  while (received.size () < sent.size ())
+    {
+      pollfd fd{ host, POLLIN, 0 };
+      if (poll (&fd, 1, 2000) <= 0)
+        break;
+      protocol.readFrom (host, [&] (Packet const &packet) {
+        received.push_back (packet);
+      });
+    }
+  ASSERT_EQ (received.size (), sent.size ());
+  for (auto index = 0u; index < sent.size (); ++index)
+    EXPECT_TRUE (received[index] == sent[index]) << index;
+  EXPECT_EQ (ControllerProtocol::readUint64 (received[1].payload.data ()),
+             0x0123456789abcdefull);
+
+  ControllerSimulator::PadColours colours;
+  for (auto index = 0u; index < colours.size (); ++index)
+    colours[index] = std::uint8_t (index * 5);
+
+  std::vector<std::uint8_t> output;
+  for (auto const &packet : { ControllerProtocol::makePadLEDFrame (
+                                  colours.data ()),
+                              ControllerProtocol::makeButtonLEDs (0x5) })
+    {
+      auto const frame = encode (packet);
+      output.insert (output.end (), frame.begin (), frame.end ());
+    }
+  ASSERT_EQ (write (host, output.data (), output.size ()),
+             ssize_t (output.size ()));
+
+  auto numReceived = 0;
+  while (numReceived < 2)
+    {
+      auto const numPackets = simulator.receive (2000);
+      if (numPackets == 0)
+        break;
+      numReceived += numPackets;
+    }
+  EXPECT_EQ (numReceived, 2);
+  EXPECT_EQ (simulator.getNumPadLEDFrames (), 1);
+  EXPECT_EQ (simulator.getPadColours (), colours);
+  EXPECT_EQ (simulator.getButtonLEDs (), 0x5);
+
+  close (host);
+}
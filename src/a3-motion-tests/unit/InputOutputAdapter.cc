@@ -0,0 +1,241 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-ui/io/InputOutputAdapter.hh>
+
+using namespace a3;
+
+namespace
+{
+
+using Event = InputOutputAdapter::Event;
+
+/* Reads the input events from a pipe on the I/O thread, the way the
+ * derived adapters read the hardware.
+ */
+class InputOutputAdapterPipe : public InputOutputAdapter
+{
+public:
+  InputOutputAdapterPipe ()
+  {
+    std::array<int, 2> fds;
+    if (pipe (fds.data ()) == 0)
+      {
+        fcntl (fds[0], F_SETFL, fcntl (fds[0], F_GETFL) | O_NONBLOCK);
+        _fdRead = fds[0];
+        _fdWrite = fds[1];
+      }
+  }
+
+  ~InputOutputAdapterPipe ()
+  {
+    stopThread (1000);
+    close (_fdRead);
+    close (_fdWrite);
+  }
+
+  bool
+  send (Event const &event)
+  {
+    return write (_fdWrite, &event, sizeof (event)) == sizeof (event);
+  }
+
+  int
+  getNumEventsRead () const
+  {
+    return _numEventsRead;
+  }
+
+protected:
+  void
+  processInput () override
+  {
+    Event event;
+    while (read (_fdRead, &event, sizeof (event)) == sizeof (event))
+      {
+        auto const value = event.value > 0.f;
+        switch (event.kind)
+          {
+          case Event::Kind::Pad:
+            inputPadValue ({ event.channel, event.index }, value);
+            break;
+          case Event::Kind::Button:
+            inputButtonValue (static_cast<Button> (event.index), value);
+            break;
+          case Event::Kind::EncoderPress:
+            inputEncoderPress (event.channel, value);
+            break;
+          case Event::Kind::EncoderIncrement:
+            inputEncoderIncrement (event.channel, int (event.value));
+            break;
+          case Event::Kind::Pot:
+            inputPotValue (event.channel, event.index, event.value);
+            break;
+          case Event::Kind::Tap:
+            inputTapTime (event.timeMicros);
+            break;
+          }
+        ++_numEventsRead;
+      }
+  }
+
+  int
+  getInputFileDescriptor () override
+  {
+    return _fdRead;
+  }
+
+  void
+  outputButtonLED (Button, bool) override
+  {
+  }
+
+  void
+  outputPadLED (PadIndex, juce::Colour) override
+  {
+  }
+
+private:
+  int _fdRead = -1;
+  int _fdWrite = -1;
+  std::atomic<int> _numEventsRead{ 0 };
+};
+
+Event
+makeEvent (Event::Kind kind, index_t channel, index_t index, float value)
+{
+  Event event;
+  event.kind = kind;
+  event.channel = channel;
+  event.index = index;
+  event.value = value;
+  return event;
+}
+
+}
+
+// The message thread is blocked while pot movements fill the FIFO,
+// the presses and releases behind them must still arrive in order.
+TEST (InputOutputAdapter, FloodedFIFOKeepsPresses)
+{
+  InputOutputAdapterPipe adapter;
+
+  std::mutex mutex;
+  std::vector<Event> received;
+  auto numPotsReceived = 0;
+  for (auto kind : { Event::Kind::Pad, Event::Kind::Button,
+                     Event::Kind::EncoderPress, Event::Kind::Pot })
+    adapter.setEventHandler (kind,
+                             InputOutputAdapter::Execution::MessageThread,
+                             [&] (Event const &event) {
+                               std::lock_guard<std::mutex> lock (mutex);
+                               if (event.kind == Event::Kind::Pot)
+                                 ++numPotsReceived;
+                               else
+                                 received.push_back (event);
+                             });
+  adapter.startThread ();
+
+  auto const pad = [] (index_t index, float value) {
+    return makeEvent (Event::Kind::Pad, 0, index, value);
+  };
+  auto const tap = [] (float value) {
+    return makeEvent (Event::Kind::Button, 0,
+                      index_t (InputOutputAdapter::Button::Tap), value);
+  };
+
+  std::vector<Event> input;
+  // fits into the FIFO, the release, press, release of the same pad
+  // later on must not turn into a repeated press
+  input.push_back (pad (1, 1.f));
+  auto constexpr numPots = 100;
+  for (auto index = 0; index < numPots; ++index)
+    input.push_back (
+        makeEvent (Event::Kind::Pot, 0, 0, float (index % 2)));
+  for (auto value : { 0.f, 1.f, 0.f })
+    input.push_back (pad (1, value));
+  for (auto hit = 0; hit < 3; ++hit)
+    {
+      input.push_back (pad (0, 1.f));
+      input.push_back (pad (0, 0.f));
+    }
+  input.push_back (tap (1.f));
+  input.push_back (tap (0.f));
+  // a repeated encoder press is no change
+  for (auto value : { 1.f, 1.f, 0.f })
+    input.push_back (makeEvent (Event::Kind::EncoderPress, 2, 0, value));
+
+  {
+    juce::MessageManagerLock lock;
+    ASSERT_TRUE (lock.lockWasGained ());
+
+    for (auto const &event : input)
+      ASSERT_TRUE (adapter.send (event));
+    for (auto wait = 0;
+         wait < 1000 && adapter.getNumEventsRead () < int (input.size ());
+         ++wait)
+      juce::Thread::sleep (1);
+    ASSERT_EQ (adapter.getNumEventsRead (), int (input.size ()));
+  }
+
+  auto constexpr numExpected = 4u + 6u + 2u + 2u;
+  for (auto wait = 0; wait < 1000; ++wait)
+    {
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (received.size () >= numExpected)
+          break;
+      }
+      juce::Thread::sleep (1);
+    }
+  adapter.stopThread (1000);
+
+  auto const valuesOf = [&received] (Event const &source) {
+    std::vector<float> values;
+    for (auto const &event : received)
+      if (event.kind == source.kind && event.channel == source.channel
+          && event.index == source.index)
+        values.push_back (event.value);
+    return values;
+  };
+
+  std::lock_guard<std::mutex> lock (mutex);
+  EXPECT_EQ (received.size (), numExpected);
+  EXPECT_EQ (valuesOf (pad (1, 0.f)),
+             (std::vector<float>{ 1.f, 0.f, 1.f, 0.f }));
+  EXPECT_EQ (valuesOf (pad (0, 0.f)),
+             (std::vector<float>{ 1.f, 0.f, 1.f, 0.f, 1.f, 0.f }));
+  EXPECT_EQ (valuesOf (tap (0.f)), (std::vector<float>{ 1.f, 0.f }));
+  EXPECT_EQ (valuesOf (makeEvent (Event::Kind::EncoderPress, 2, 0, 0.f)),
+             (std::vector<float>{ 1.f, 0.f }));
+  // the pots fill the FIFO, the ones behind it are dropped
+  EXPECT_LT (numPotsReceived, numPots);
+}
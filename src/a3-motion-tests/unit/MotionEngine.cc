@@ -0,0 +1,435 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/MotionEngine.hh>
+#include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/PatternGenerator.hh>
+#include <a3-motion-engine/Session.hh>
+#include <a3-motion-engine/backends/SpatBackend.hh>
+#include <a3-motion-engine/elevation/HeightMapFlat.hh>
+#include <a3-motion-engine/elevation/HeightMapSphere.hh>
+#include <a3-motion-engine/tempo/TimeSource.hh>
+#include <a3-motion-engine/util/Timing.hh>
+
+using namespace a3;
+
+namespace
+{
+
+class SpatBackendCounting : public SpatBackend
+{
+public:
+  void
+  sendPosition (index_t channel, Pos const &position) override
+  {
+    ++numPositions;
+    std::lock_guard<std::mutex> guard (mutex);
+    positions[channel] = position;
+  }
+  void
+  sendWidth (index_t channel, float width) override
+  {
+    ++numWidths;
+    std::lock_guard<std::mutex> guard (mutex);
+    widths[channel] = width;
+  }
+  void
+  sendAmbisonicsOrder (index_t channel, int order) override
+  {
+    ++numOrders;
+    std::lock_guard<std::mutex> guard (mutex);
+    orders[channel] = order;
+  }
+
+  // whether the last values received for a channel match the engine
+  bool
+  isUpToDate (MotionEngine &engine, index_t channel)
+  {
+    std::lock_guard<std::mutex> guard (mutex);
+    return positions.count (channel) && widths.count (channel)
+           && orders.count (channel)
+           && positions[channel] == engine.getChannelPosition (channel)
+           && widths[channel] == engine.getChannelWidth (channel)
+           && orders[channel] == engine.getChannelAmbisonicsOrder (channel);
+  }
+
+  std::atomic<int> numPositions{ 0 };
+  std::atomic<int> numWidths{ 0 };
+  std::atomic<int> numOrders{ 0 };
+
+  std::mutex mutex;
+  std::map<index_t, Pos> positions;
+  std::map<index_t, float> widths;
+  std::map<index_t, int> orders;
+};
+
+class PatternStatusCounter : public juce::MessageListener
+{
+public:
+  using Status = MotionEngine::PatternStatusMessage::Status;
+
+  void
+  handleMessage (juce::Message const &message) override
+  {
+    auto const &statusMessage
+        = dynamic_cast<MotionEngine::PatternStatusMessage const &> (message);
+    switch (statusMessage.status)
+      {
+      case Status::Recording:
+        ++numRecording;
+        break;
+      case Status::Playing:
+        ++numPlaying;
+        break;
+      case Status::Stopped:
+        ++numStopped;
+        break;
+      }
+  }
+
+  std::atomic<int> numRecording{ 0 };
+  std::atomic<int> numPlaying{ 0 };
+  std::atomic<int> numStopped{ 0 };
+};
+
+}
+
+// The snapshot read by the UI follows pattern playback on the tick
+// thread.
+TEST (MotionEngine, SnapshotFollowsPlayback)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  HeightMapFlat heightMap;
+
+  auto backend = std::make_unique<SpatBackendCounting> ();
+  auto &backendCounting = *backend;
+  MotionEngine engine (2, heightMap, std::move (backend), timeSource);
+  auto &tempoClock = engine.getTempoClock ();
+  tempoClock.setTempoBPM (120.f);
+  tempoClock.reset ();
+  tempoClock.advance (std::chrono::milliseconds (1));
+
+  // the initial state of the resting channel reaches the backend
+  for (auto wait = 0; wait < 1000 && !backendCounting.isUpToDate (engine, 0);
+       ++wait)
+    juce::Thread::sleep (1);
+  EXPECT_TRUE (backendCounting.isUpToDate (engine, 0));
+
+  EngineSnapshot snapshot;
+  engine.getSnapshot (snapshot);
+  ASSERT_EQ (snapshot.channels.size (), 2u);
+  EXPECT_FALSE (snapshot.isRecording ());
+  EXPECT_EQ (snapshot.channels[1].patternPlaying, nullptr);
+
+  std::shared_ptr<Pattern> pattern
+      = PatternGenerator::createCircle (16, 0.8f, 360.f, heightMap);
+  pattern->setChannel (1);
+  pattern->setPlaybackLength (Measure (1, 0, 0));
+  engine.playPattern (pattern, Measure (1, 0, 0));
+  tempoClock.advance (std::chrono::seconds (3));
+
+  engine.getSnapshot (snapshot);
+  EXPECT_EQ (snapshot.channels[0].patternPlaying, nullptr);
+  EXPECT_EQ (snapshot.channels[1].patternPlaying, pattern);
+  EXPECT_EQ (snapshot.channels[1].statusPlaying, Pattern::Status::Playing);
+  EXPECT_GT (snapshot.channels[1].playPosition, 0.f);
+  EXPECT_EQ (snapshot.channels[1].position, engine.getChannelPosition (1));
+}
+
+// A channel transform rotates, mirrors, scales and reverses the
+// pattern it plays without touching the pattern itself.
+TEST (MotionEngine, ChannelTransform)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  HeightMapSphere heightMap;
+
+  MotionEngine engine (2, heightMap, std::make_unique<SpatBackendCounting> (),
+                       timeSource);
+  auto &tempoClock = engine.getTempoClock ();
+  tempoClock.setTempoBPM (120.f);
+  tempoClock.reset ();
+  tempoClock.advance (std::chrono::milliseconds (1));
+
+  std::shared_ptr<Pattern> pattern
+      = PatternGenerator::createCircle (16, 1.f, 360.f, heightMap);
+  pattern->setChannel (1);
+  pattern->setPlaybackLength (Measure (4, 0, 0));
+
+  auto const transform = PatternTransform (90.f, 0.5f, true, true, 0.25f);
+  engine.setChannelTransform (1, transform);
+  engine.playPattern (pattern, Measure (1, 0, 0));
+  tempoClock.advance (std::chrono::seconds (3));
+
+  EngineSnapshot snapshot;
+  engine.getSnapshot (snapshot);
+  ASSERT_EQ (snapshot.channels[1].statusPlaying, Pattern::Status::Playing);
+  EXPECT_EQ (snapshot.channels[1].transform.getScale (), 0.5f);
+
+  // mirrored azimuth of the reversed phase, rotated by 90 degrees
+  auto const phase = transform.mapPhase (snapshot.channels[1].playPosition);
+  EXPECT_NEAR (phase,
+               std::fmod (1.25f - snapshot.channels[1].playPosition, 1.f),
+               1e-6f);
+  auto const expected = Pos::fromSpherical (90.f - phase * 360.f, 0.f, 0.5f);
+  EXPECT_NEAR (snapshot.channels[1].position.x (), expected.x (), 1e-5f);
+  EXPECT_NEAR (snapshot.channels[1].position.y (), expected.y (), 1e-5f);
+  // the height follows the scaled position on the sphere
+  EXPECT_NEAR (snapshot.channels[1].position.z (), std::sqrt (0.75f), 1e-5f);
+
+  // the pattern itself is untransformed
+  EXPECT_NEAR (pattern->getTick (0).x (), 1.f, 1e-6f);
+}
+
+// A group pose moves all member channels at once, a pattern played
+// on the leader rotates the group by the leader's rotation since the
+// group was created.
+TEST (MotionEngine, ChannelGroup)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  HeightMapFlat heightMap;
+
+  MotionEngine engine (4, heightMap, std::make_unique<SpatBackendCounting> (),
+                       timeSource);
+  auto &tempoClock = engine.getTempoClock ();
+  tempoClock.setTempoBPM (120.f);
+  tempoClock.reset ();
+  tempoClock.advance (std::chrono::milliseconds (1));
+
+  engine.setChannel2DPosition (0, Pos::fromCartesian (1.f, 0.f, 0.f));
+  engine.setChannel2DPosition (1, Pos::fromCartesian (0.f, 1.f, 0.f));
+  engine.setChannelGroup (0, { 0, 1 });
+  tempoClock.advance (std::chrono::milliseconds (100));
+  EXPECT_EQ (engine.getChannelPosition (0), Pos::fromCartesian (1, 0, 0));
+
+  // rotate by 90 degrees around the origin, doubling the spread
+  engine.setChannelGroupPose (0, { 90.f, 2.f, 0.f, 0.f });
+  tempoClock.advance (std::chrono::milliseconds (100));
+  EXPECT_NEAR (engine.getChannelPosition (0).x (), 1.f, 1e-5f);
+  EXPECT_NEAR (engine.getChannelPosition (0).y (), 1.f, 1e-5f);
+  EXPECT_NEAR (engine.getChannelPosition (1).x (), -1.f, 1e-5f);
+  EXPECT_NEAR (engine.getChannelPosition (1).y (), -1.f, 1e-5f);
+
+  // the group does not jump to the leader's azimuth when created
+  engine.releaseChannelGroup (0);
+  engine.setChannel2DPosition (3, Pos::fromSpherical (30.f, 0.f, 1.f));
+  engine.setChannelGroup (1, { 0, 1 }, 3);
+  tempoClock.advance (std::chrono::milliseconds (100));
+  EXPECT_NEAR (engine.getChannelPosition (0).x (), 1.f, 1e-5f);
+  EXPECT_NEAR (engine.getChannelPosition (0).y (), 1.f, 1e-5f);
+
+  std::shared_ptr<Pattern> pattern
+      = PatternGenerator::createCircle (16, 1.f, 360.f, heightMap);
+  pattern->setChannel (3);
+  pattern->setPlaybackLength (Measure (4, 0, 0));
+  engine.playPattern (pattern, Measure (1, 0, 0));
+  tempoClock.advance (std::chrono::seconds (3));
+
+  auto const azimuthLeader = engine.getChannelPosition (3).azimuth ();
+  auto const expected = Pos::fromSpherical (azimuthLeader - 30.f + 45.f, 0.f,
+                                            std::sqrt (2.f));
+  EXPECT_NE (azimuthLeader, 30.f);
+  EXPECT_NEAR (engine.getChannelPosition (0).x (), expected.x (), 1e-5f);
+  EXPECT_NEAR (engine.getChannelPosition (0).y (), expected.y (), 1e-5f);
+
+  // a leader listed as a member is not placed by the group and keeps
+  // following its pattern
+  engine.setChannel2DPosition (2, Pos::fromCartesian (0.f, -1.f, 0.f));
+  engine.setChannelGroup (2, { 2, 3 }, 3);
+  tempoClock.advance (std::chrono::seconds (1));
+  EXPECT_EQ (engine.getChannelPosition (3),
+             pattern->getPosition (pattern->getPlayPosition ()));
+  EXPECT_NEAR (engine.getChannelPosition (2).x (), 0.f, 1e-5f);
+  EXPECT_NEAR (engine.getChannelPosition (2).y (), -1.f, 1e-5f);
+}
+
+// Restoring a session stops all patterns and applies the engine
+// parameters with the next tick.
+TEST (MotionEngine, RestoreSession)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  HeightMapFlat heightMap;
+
+  MotionEngine engine (2, heightMap, std::make_unique<SpatBackendCounting> (),
+                       timeSource);
+  auto &tempoClock = engine.getTempoClock ();
+  tempoClock.setTempoBPM (120.f);
+  tempoClock.reset ();
+  tempoClock.advance (std::chrono::milliseconds (1));
+
+  PatternStatusCounter counter;
+  engine.addPatternStatusListener (&counter);
+
+  std::shared_ptr<Pattern> pattern
+      = PatternGenerator::createCircle (16, 0.8f, 360.f, heightMap);
+  pattern->setChannel (1);
+  pattern->setPlaybackLength (Measure (1, 0, 0));
+  engine.playPattern (pattern, Measure (1, 0, 0));
+  tempoClock.advance (std::chrono::seconds (3));
+  ASSERT_EQ (pattern->getStatus (), Pattern::Status::Playing);
+
+  auto session = std::make_shared<Session> ();
+  session->tempoBPM = 90.f;
+  session->recordingMode = MotionEngine::RecordingMode::Loop;
+  session->channels = { { 20.f, 1, 0 }, { 30.f, 2, 0 } };
+  engine.restoreSession (session);
+  tempoClock.advance (std::chrono::milliseconds (100));
+
+  EngineSnapshot snapshot;
+  engine.getSnapshot (snapshot);
+  EXPECT_EQ (snapshot.channels[1].patternPlaying, nullptr);
+  EXPECT_EQ (pattern->getStatus (), Pattern::Status::Idle);
+  EXPECT_EQ (counter.numStopped, 1);
+  EXPECT_EQ (engine.getChannelWidth (1), 30.f);
+  EXPECT_EQ (engine.getChannelAmbisonicsOrder (0), 1);
+  EXPECT_EQ (engine.getRecordingMode (), MotionEngine::RecordingMode::Loop);
+  EXPECT_EQ (tempoClock.getTempoBPM (), 90.f);
+
+  engine.removePatternStatusListener (&counter);
+}
+
+// Simulates an hour long show on 64 channels in virtual time. The
+// first channels toggle between playing and stopped bar by bar, the
+// remaining ones record a one-shot pattern in turns.
+TEST (MotionEngine, SimulatedShow)
+{
+  auto constexpr numChannels = 64u;
+  auto constexpr numChannelsRecording = 8u;
+  auto constexpr numChannelsPlaying = numChannels - numChannelsRecording;
+  auto constexpr tempoBPM = 120.f;
+  auto constexpr numBars = 1800;
+  auto constexpr barsPerRecording = 4;
+  auto constexpr lengthBeats = 16u;
+
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  auto backend = std::make_unique<SpatBackendCounting> ();
+  auto &backendCounting = *backend;
+  HeightMapFlat heightMap;
+
+  MotionEngine engine (numChannels, heightMap, std::move (backend),
+                       timeSource);
+  auto &tempoClock = engine.getTempoClock ();
+  tempoClock.setTempoBPM (tempoBPM);
+  tempoClock.reset ();
+  tempoClock.advance (std::chrono::milliseconds (1));
+
+  PatternStatusCounter counter;
+  engine.addPatternStatusListener (&counter);
+
+  std::vector<std::shared_ptr<Pattern> > patterns;
+  for (auto channel = 0u; channel < numChannels; ++channel)
+    {
+      patterns.push_back (PatternGenerator::createCircle (
+          lengthBeats, 0.8f, 360.f, heightMap));
+      patterns.back ()->setChannel (channel);
+      patterns.back ()->setPlaybackLength (Measure (4, 0, 0));
+    }
+  std::vector<bool> playing (numChannelsPlaying, false);
+
+  auto numPlay = 0;
+  auto numStop = 0;
+  auto numRecord = 0;
+  auto const durationBeat = std::chrono::microseconds (
+      static_cast<int64_t> (60. * 1e6 / tempoBPM));
+
+  Timings timings;
+  {
+    ScopedTimer<> t{ timings, "simulation" };
+    for (auto bar = 0; bar < numBars; ++bar)
+      {
+        auto const nextBar = Measure (bar + 1, 0, 0);
+
+        auto const channel = static_cast<index_t> (bar) % numChannelsPlaying;
+        if (playing[channel])
+          {
+            engine.stopPattern (patterns[channel], nextBar);
+            ++numStop;
+          }
+        else
+          {
+            engine.playPattern (patterns[channel], nextBar);
+            ++numPlay;
+          }
+        playing[channel] = !playing[channel];
+
+        if (bar % barsPerRecording == 0)
+          {
+            auto const channelRecording
+                = numChannelsPlaying
+                  + static_cast<index_t> (bar / barsPerRecording)
+                        % numChannelsRecording;
+            engine.recordPattern (patterns[channelRecording], nextBar,
+                                  Measure (1, 0, 0));
+            ++numRecord;
+          }
+
+        for (auto beat = 0; beat < tempoClock.getBeatsPerBar (); ++beat)
+          {
+            auto const degrees = 90.f * beat;
+            engine.setRecording3DPosition (
+                Pos::fromSpherical (degrees, 0.f, 1.f));
+            tempoClock.advance (durationBeat);
+          }
+      }
+  }
+
+  // let the message thread deliver the remaining status messages
+  for (auto wait = 0; wait < 1000; ++wait)
+    {
+      if (counter.numRecording >= numRecord
+          && counter.numStopped >= numStop + numRecord)
+        break;
+      juce::Thread::sleep (1);
+    }
+
+  engine.removePatternStatusListener (&counter);
+
+  EXPECT_EQ (counter.numRecording, numRecord);
+  EXPECT_GE (counter.numPlaying, numPlay);
+  EXPECT_EQ (counter.numStopped, numStop + numRecord);
+
+  // no change is lost on the way to the backend, however far it falls
+  // behind the virtual time
+  auto const isBackendUpToDate = [&] {
+    for (auto channel = 0u; channel < numChannels; ++channel)
+      if (!backendCounting.isUpToDate (engine, channel))
+        return false;
+    return true;
+  };
+  for (auto wait = 0; wait < 1000 && !isBackendUpToDate (); ++wait)
+    juce::Thread::sleep (1);
+  EXPECT_TRUE (isBackendUpToDate ());
+
+  auto const seconds
+      = std::chrono::duration<double> (timings.get ()[0].duration).count ();
+  juce::Logger::writeToLog (
+      "simulated " + juce::String (numBars) + " bars on "
+      + juce::String (numChannels) + " channels in "
+      + juce::String (seconds, 2) + " s, positions sent: "
+      + juce::String (backendCounting.numPositions.load ()));
+}
@@ -0,0 +1,164 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <gtest/gtest.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/PatternGenerator.hh>
+#include <a3-motion-engine/elevation/HeightMapFlat.hh>
+#include <a3-motion-tests/TestHelpers.hh>
+
+using namespace a3;
+
+namespace
+{
+auto constexpr numTicks = 16;
+}
+
+TEST (Pattern, DirtyTicksWhileRecording)
+{
+  Pattern pattern;
+  pattern.resize (numTicks);
+
+  std::vector<Pos> positions;
+  auto dirty = pattern.getDirtyTicks (0, positions);
+  EXPECT_TRUE (dirty.complete);
+  EXPECT_EQ (dirty.numTicks, numTicks);
+  EXPECT_EQ (positions.size (), numTicks);
+
+  auto version = dirty.version;
+  for (auto tick = 0u; tick < 5; ++tick)
+    pattern.setTick (tick, positionForTick (tick));
+
+  dirty = pattern.getDirtyTicks (version, positions);
+  EXPECT_FALSE (dirty.complete);
+  EXPECT_EQ (dirty.firstTick, 0);
+  EXPECT_EQ (dirty.numTicks, 5);
+  ASSERT_EQ (positions.size (), 5);
+  EXPECT_EQ (positions[4], positionForTick (4));
+  version = dirty.version;
+
+  dirty = pattern.getDirtyTicks (version, positions);
+  EXPECT_FALSE (dirty.complete);
+  EXPECT_EQ (dirty.numTicks, 0);
+  EXPECT_TRUE (positions.empty ());
+
+  // recording wraps around at the end of the pattern
+  for (auto tick = 5u; tick < numTicks + 3; ++tick)
+    pattern.setTick (tick % numTicks, positionForTick (tick % numTicks));
+
+  dirty = pattern.getDirtyTicks (pattern.getVersion () - 6, positions);
+  EXPECT_FALSE (dirty.complete);
+  EXPECT_EQ (dirty.firstTick, numTicks - 3);
+  EXPECT_EQ (dirty.numTicks, 6);
+  ASSERT_EQ (positions.size (), 6);
+  EXPECT_EQ (positions[5], positionForTick (2));
+}
+
+TEST (Pattern, DirtyTicksCompleteAfterNonSequentialChanges)
+{
+  Pattern pattern;
+  pattern.resize (numTicks);
+
+  std::vector<Pos> positions;
+  auto const version = pattern.getVersion ();
+  pattern.setTick (0, positionForTick (0));
+  pattern.setTick (7, positionForTick (7));
+
+  auto dirty = pattern.getDirtyTicks (version, positions);
+  EXPECT_TRUE (dirty.complete);
+  EXPECT_EQ (dirty.firstTick, 8);
+  ASSERT_EQ (positions.size (), numTicks);
+  EXPECT_EQ (positions.back (), positionForTick (7));
+
+  // only the last tick is dirty for an observer that saw the first
+  dirty = pattern.getDirtyTicks (pattern.getVersion () - 1, positions);
+  EXPECT_FALSE (dirty.complete);
+  EXPECT_EQ (dirty.firstTick, 7);
+  EXPECT_EQ (dirty.numTicks, 1);
+
+  pattern.clear ();
+  dirty = pattern.getDirtyTicks (pattern.getVersion () - 1, positions);
+  EXPECT_TRUE (dirty.complete);
+  EXPECT_FALSE (positions.back ().isValid ());
+}
+
+TEST (Pattern, ProceduralEvaluatesAtAnyPhase)
+{
+  HeightMapFlat heightMap;
+  auto pattern = PatternGenerator::createCircle (1, 1.f, 360.f, heightMap);
+  auto const numTicksNominal = pattern->getNumTicks ();
+  EXPECT_TRUE (pattern->isProcedural ());
+  EXPECT_EQ (numTicksNominal, TempoClock::getTicksPerBeat ());
+
+  // phases between the nominal ticks are evaluated exactly
+  auto const phase = 0.3f / numTicksNominal;
+  auto const expected = Pos::fromSpherical (phase * 360.f, 0.f, 1.f);
+  EXPECT_NEAR (pattern->getPosition (phase).x (), expected.x (), 1e-6f);
+  EXPECT_NEAR (pattern->getPosition (phase).y (), expected.y (), 1e-6f);
+
+  auto const ticks = pattern->getTicks ().positions;
+  ASSERT_EQ (ticks.size (), numTicksNominal);
+  EXPECT_EQ (ticks[3], pattern->getTick (3));
+
+  // editing a tick materializes the shape into tick data
+  auto const version = pattern->getVersion ();
+  pattern->setTick (5, positionForTick (5));
+  EXPECT_FALSE (pattern->isProcedural ());
+  EXPECT_GT (pattern->getVersion (), version);
+  EXPECT_EQ (pattern->getTick (3), ticks[3]);
+  EXPECT_EQ (pattern->getTick (5), positionForTick (5));
+  EXPECT_EQ (pattern->getPosition (5.5f / numTicksNominal),
+             positionForTick (5));
+}
+
+TEST (Pattern, SharedTicksCopyOnWrite)
+{
+  Pattern source;
+  source.resize (numTicks);
+  for (auto tick = 0u; tick < numTicks; ++tick)
+    source.setTick (tick, positionForTick (tick));
+
+  Pattern shared;
+  shared.setChannel (1);
+  shared.shareTicks (source);
+  EXPECT_TRUE (source.isSharingTicks ());
+  EXPECT_EQ (shared.getChannel (), 1);
+  EXPECT_EQ (shared.getNumTicks (), numTicks);
+  EXPECT_EQ (shared.getTick (3), positionForTick (3));
+
+  // re-recording the source leaves the shared pattern untouched
+  source.clear ();
+  source.resize (numTicks / 2);
+  source.setTick (3, positionForTick (0));
+  EXPECT_FALSE (source.isSharingTicks ());
+  EXPECT_FALSE (shared.isSharingTicks ());
+  EXPECT_EQ (source.getNumTicks (), numTicks / 2);
+  EXPECT_EQ (shared.getNumTicks (), numTicks);
+  EXPECT_EQ (shared.getTick (3), positionForTick (3));
+
+  // modifying a single tick copies the shared data first
+  source.shareTicks (shared);
+  shared.setTick (5, positionForTick (0));
+  EXPECT_EQ (source.getTick (5), positionForTick (5));
+  EXPECT_EQ (shared.getTick (5), positionForTick (0));
+}
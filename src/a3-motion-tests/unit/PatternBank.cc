@@ -0,0 +1,183 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/PatternBank.hh>
+#include <a3-motion-tests/TestHelpers.hh>
+
+using namespace a3;
+
+namespace
+{
+
+class PatternBankTest : public TemporaryDirectoryTest
+{
+protected:
+  PatternBankTest () : TemporaryDirectoryTest ("patterns.a3bank") {}
+
+  static std::unique_ptr<Pattern>
+  createPattern (index_t numTicks, float offset)
+  {
+    auto pattern = std::make_unique<Pattern> ();
+    pattern->resize (numTicks);
+    // leave the last tick unrecorded
+    for (auto tick = 0u; tick + 1 < numTicks; ++tick)
+      pattern->setTick (tick, Pos::fromCartesian (float (tick), offset, -1.f));
+    pattern->setPlaybackLength (Measure (1, 2, 0));
+    return pattern;
+  }
+
+  static void
+  expectEqual (Pattern const &lhs, std::unique_ptr<Pattern> const &rhs)
+  {
+    auto const ticksLhs = lhs.getTicks ().positions;
+    auto const ticksRhs = rhs->getTicks ().positions;
+    ASSERT_EQ (ticksLhs.size (), ticksRhs.size ());
+    for (auto tick = 0u; tick < ticksLhs.size (); ++tick)
+      {
+        // unrecorded ticks are NaN and never compare equal
+        if (std::isnan (ticksLhs[tick].x ()))
+          EXPECT_TRUE (std::isnan (ticksRhs[tick].x ()));
+        else
+          EXPECT_EQ (ticksLhs[tick], ticksRhs[tick]);
+      }
+    EXPECT_EQ (lhs.getPlaybackLength (), rhs->getPlaybackLength ());
+  }
+};
+
+}
+
+TEST_F (PatternBankTest, StoreAndReopen)
+{
+  auto const first = createPattern (96, 0.5f);
+  auto const second = createPattern (37, -0.5f);
+  {
+    PatternBank bank;
+    ASSERT_TRUE (bank.open (_path));
+    EXPECT_TRUE (bank.getSlots ().empty ());
+    EXPECT_TRUE (bank.store (3, *first));
+    EXPECT_TRUE (bank.store (17, *second));
+    EXPECT_TRUE (bank.store (3, *second));
+    EXPECT_TRUE (bank.store (3, *first));
+  }
+
+  PatternBank bank;
+  ASSERT_TRUE (bank.open (_path));
+  EXPECT_EQ (bank.getSlots (), (std::vector<std::uint32_t>{ 3, 17 }));
+
+  Pattern loaded;
+  ASSERT_TRUE (bank.load (3, loaded));
+  expectEqual (loaded, first);
+  ASSERT_TRUE (bank.load (17, loaded));
+  expectEqual (loaded, second);
+  EXPECT_FALSE (bank.load (4, loaded));
+}
+
+TEST_F (PatternBankTest, CompactMergesLog)
+{
+  auto const first = createPattern (96, 0.5f);
+  auto const second = createPattern (5, 0.25f);
+  {
+    PatternBank bank;
+    ASSERT_TRUE (bank.open (_path));
+    EXPECT_TRUE (bank.store (0, *first));
+    EXPECT_TRUE (bank.store (1, *first));
+    EXPECT_GT (bank.getLogSize (), 0u);
+    ASSERT_TRUE (bank.compact ());
+    EXPECT_EQ (bank.getLogSize (), 0u);
+
+    // changes after compaction go to the log again
+    EXPECT_TRUE (bank.store (1, *second));
+    Pattern loaded;
+    ASSERT_TRUE (bank.load (0, loaded));
+    expectEqual (loaded, first);
+    ASSERT_TRUE (bank.load (1, loaded));
+    expectEqual (loaded, second);
+  }
+
+  PatternBank bank;
+  ASSERT_TRUE (bank.open (_path));
+  Pattern loaded;
+  ASSERT_TRUE (bank.load (0, loaded));
+  expectEqual (loaded, first);
+  ASSERT_TRUE (bank.load (1, loaded));
+  expectEqual (loaded, second);
+}
+
+TEST_F (PatternBankTest, DiscardsTornLogRecord)
+{
+  auto const first = createPattern (48, 0.5f);
+  auto const second = createPattern (48, -0.5f);
+  std::uintmax_t sizeLogIntact;
+  {
+    PatternBank bank;
+    ASSERT_TRUE (bank.open (_path));
+    EXPECT_TRUE (bank.store (2, *first));
+    sizeLogIntact = bank.getLogSize ();
+    EXPECT_TRUE (bank.store (2, *second));
+  }
+
+  // simulate a crash in the middle of writing the second record
+  auto const pathLog = _path + ".wal";
+  std::filesystem::resize_file (pathLog, sizeLogIntact + 40);
+
+  {
+    PatternBank bank;
+    ASSERT_TRUE (bank.open (_path));
+    EXPECT_EQ (bank.getLogSize (), sizeLogIntact);
+    Pattern loaded;
+    ASSERT_TRUE (bank.load (2, loaded));
+    expectEqual (loaded, first);
+
+    // appending after the truncated tail works as usual
+    EXPECT_TRUE (bank.store (2, *second));
+  }
+
+  PatternBank bank;
+  ASSERT_TRUE (bank.open (_path));
+  Pattern loaded;
+  ASSERT_TRUE (bank.load (2, loaded));
+  expectEqual (loaded, second);
+}
+
+TEST_F (PatternBankTest, RejectsCorruptedBank)
+{
+  {
+    PatternBank bank;
+    ASSERT_TRUE (bank.open (_path));
+    EXPECT_TRUE (bank.store (0, *createPattern (16, 0.f)));
+    ASSERT_TRUE (bank.compact ());
+  }
+
+  // the index claims more ticks than the file holds
+  std::filesystem::resize_file (
+      _path, std::filesystem::file_size (_path) - 16);
+
+  PatternBank bank;
+  EXPECT_FALSE (bank.open (_path));
+  EXPECT_FALSE (bank.isOpen ());
+}
@@ -18,7 +18,9 @@
 
 */
 
+#include <random>
 #include <type_traits>
+#include <vector>
 
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
@@ -257,3 +259,88 @@ TYPED_TEST (PositionTest, Subtraction)
   p -= p0;
   ASSERT_THAT (p, CartesianEq<TypeParam> ({ 0, -3, -7 }));
 }
+
+namespace
+{
+// odd, so that the scalar remainder of the batch functions is covered
+auto constexpr numPositionsBatch = 1001u;
+
+double
+angleDifference (double lhs, double rhs)
+{
+  return std::remainder (lhs - rhs, 360.);
+}
+}
+
+// The batch conversions agree with the scalar double path within the
+// documented error bounds.
+TEST (Position, BatchCartesianToSpherical)
+{
+  std::mt19937 generator (42);
+  std::uniform_real_distribution<float> coordinate (-2.f, 2.f);
+
+  std::vector<float> x, y, z;
+  for (auto const &equivalence : xyz_aed_equivalence_list)
+    {
+      x.push_back (float (std::get<0> (equivalence.first)));
+      y.push_back (float (std::get<1> (equivalence.first)));
+      z.push_back (float (std::get<2> (equivalence.first)));
+    }
+  while (x.size () < numPositionsBatch)
+    {
+      x.push_back (coordinate (generator));
+      y.push_back (coordinate (generator));
+      z.push_back (coordinate (generator));
+    }
+
+  std::vector<float> azimuth (x.size ()), elevation (x.size ()),
+      distance (x.size ());
+  convertCartesianToSpherical (x.data (), y.data (), z.data (),
+                               azimuth.data (), elevation.data (),
+                               distance.data (), x.size ());
+
+  for (auto index = 0u; index < x.size (); ++index)
+    {
+      auto const p = Position<double>::fromCartesian (x[index], y[index],
+                                                      z[index]);
+      EXPECT_NEAR (angleDifference (azimuth[index], p.azimuth ()), 0., 1e-4)
+          << "at " << p.x () << " " << p.y () << " " << p.z ();
+      EXPECT_NEAR (elevation[index], p.elevation (), 1e-4);
+      EXPECT_NEAR (distance[index], p.distance (), 1e-6 * p.distance ());
+    }
+}
+
+TEST (Position, BatchSphericalToCartesian)
+{
+  std::mt19937 generator (42);
+  std::uniform_real_distribution<float> azimuthDistribution (-360.f, 360.f);
+  std::uniform_real_distribution<float> elevationDistribution (-90.f, 90.f);
+  std::uniform_real_distribution<float> distanceDistribution (0.f, 2.f);
+
+  std::vector<float> azimuth, elevation, distance;
+  for (auto index = 0u; index < numPositionsBatch; ++index)
+    {
+      azimuth.push_back (azimuthDistribution (generator));
+      elevation.push_back (elevationDistribution (generator));
+      distance.push_back (distanceDistribution (generator));
+    }
+  auto const azimuthInput = azimuth;
+  auto const elevationInput = elevation;
+  auto const distanceInput = distance;
+
+  // converted in place
+  convertSphericalToCartesian (azimuth.data (), elevation.data (),
+                               distance.data (), azimuth.data (),
+                               elevation.data (), distance.data (),
+                               azimuth.size ());
+
+  for (auto index = 0u; index < azimuth.size (); ++index)
+    {
+      auto const p = Position<double>::fromSpherical (
+          azimuthInput[index], elevationInput[index], distanceInput[index]);
+      auto const bound = 1e-6 * distanceInput[index];
+      EXPECT_NEAR (azimuth[index], p.x (), bound);
+      EXPECT_NEAR (elevation[index], p.y (), bound);
+      EXPECT_NEAR (distance[index], p.z (), bound);
+    }
+}
@@ -0,0 +1,113 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/RecordingJournal.hh>
+#include <a3-motion-tests/TestHelpers.hh>
+
+using namespace a3;
+
+namespace
+{
+
+class RecordingJournalTest : public TemporaryDirectoryTest
+{
+protected:
+  RecordingJournalTest () : TemporaryDirectoryTest ("recordings.a3journal")
+  {
+  }
+};
+
+}
+
+TEST_F (RecordingJournalTest, ReplaysLatestRecordings)
+{
+  auto constexpr numTicks = 64u;
+  {
+    RecordingJournal journal;
+    ASSERT_TRUE (journal.open (_path, 10));
+
+    // pattern 3 is recorded twice, the second recording is cut short
+    for (auto tick = 0u; tick < numTicks; ++tick)
+      journal.appendTick (3, 1, tick, numTicks, Pos::invalid);
+    for (auto tick = 0u; tick < numTicks; ++tick)
+      journal.appendTick (7, 2, tick, numTicks, positionForTick (tick));
+    for (auto tick = 0u; tick < 10; ++tick)
+      journal.appendTick (3, 3, tick, numTicks, positionForTick (tick));
+    journal.close ();
+    EXPECT_EQ (journal.getNumTicksDropped (), 0);
+  }
+
+  auto const recordings = RecordingJournal::replay (_path);
+  ASSERT_EQ (recordings.size (), 2u);
+
+  auto const &complete = recordings.at (7);
+  ASSERT_EQ (complete.ticks.size (), numTicks);
+  for (auto tick = 0u; tick < numTicks; ++tick)
+    EXPECT_EQ (complete.ticks[tick], positionForTick (tick));
+
+  auto const &interrupted = recordings.at (3);
+  EXPECT_EQ (interrupted.recording, 3u);
+  ASSERT_EQ (interrupted.ticks.size (), numTicks);
+  EXPECT_EQ (interrupted.ticks[9], positionForTick (9));
+  EXPECT_FALSE (interrupted.ticks[10].isValid ());
+}
+
+TEST_F (RecordingJournalTest, IgnoresTornRecord)
+{
+  {
+    RecordingJournal journal;
+    ASSERT_TRUE (journal.open (_path, 10));
+    for (auto tick = 0u; tick < 8; ++tick)
+      journal.appendTick (0, 1, tick, 8, positionForTick (tick));
+  }
+
+  // cut the last record in half as in a crash during a write
+  std::filesystem::resize_file (_path,
+                                std::filesystem::file_size (_path) - 16);
+
+  auto const recordings = RecordingJournal::replay (_path);
+  ASSERT_EQ (recordings.size (), 1u);
+  auto const &ticks = recordings.at (0).ticks;
+  EXPECT_EQ (ticks[6], positionForTick (6));
+  EXPECT_FALSE (ticks[7].isValid ());
+}
+
+TEST_F (RecordingJournalTest, DropsTicksWhenWriterFallsBehind)
+{
+  RecordingJournal journal;
+  // the writer does not drain the FIFO before it is closed
+  ASSERT_TRUE (journal.open (_path, 60 * 1000));
+
+  auto constexpr numTicks = 4096u;
+  for (auto tick = 0u; tick < numTicks; ++tick)
+    journal.appendTick (0, 1, tick, numTicks, positionForTick (tick));
+  EXPECT_GT (journal.getNumTicksDropped (), 0);
+
+  journal.close ();
+  auto const recordings = RecordingJournal::replay (_path);
+  ASSERT_EQ (recordings.size (), 1u);
+  EXPECT_EQ (recordings.at (0).ticks[0], positionForTick (0));
+}
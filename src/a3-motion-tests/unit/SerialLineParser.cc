@@ -0,0 +1,292 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <a3-motion-ui/io/SerialLineParser.hh>
+
+using namespace a3;
+
+namespace
+{
+
+using Message = SerialLineParser::Message;
+using Type = Message::Type;
+
+bool
+operator== (Message const &lhs, Message const &rhs)
+{
+  return lhs.type == rhs.type && lhs.index == rhs.index
+         && lhs.value == rhs.value && lhs.timeMicros == rhs.timeMicros;
+}
+
+void
+expectWithinProtocolLimits (Message const &message)
+{
+  EXPECT_GE (message.index, 0);
+  switch (message.type)
+    {
+    case Type::Button:
+      EXPECT_LT (message.index, SerialLineParser::numButtons);
+      EXPECT_TRUE (message.value == 0 || message.value == 1);
+      break;
+    case Type::EncoderPress:
+      EXPECT_LT (message.index, SerialLineParser::numEncoders);
+      EXPECT_TRUE (message.value == 0 || message.value == 1);
+      break;
+    case Type::EncoderIncrement:
+      EXPECT_LT (message.index, SerialLineParser::numEncoders);
+      EXPECT_TRUE (message.value == 1 || message.value == -1);
+      break;
+    case Type::Pot:
+      EXPECT_LT (message.index, SerialLineParser::numPots);
+      EXPECT_GE (message.value, 0);
+      EXPECT_LE (message.value, SerialLineParser::potMaxValue);
+      break;
+    }
+}
+
+std::string
+randomValidLine (std::mt19937 &random)
+{
+  auto uniform = [&] (int min, int max) {
+    return std::uniform_int_distribution<int> (min, max) (random);
+  };
+
+  std::string line;
+  switch (uniform (0, 4))
+    {
+    case 0:
+      line = "B" + std::to_string (uniform (0, 17)) + ":"
+             + std::to_string (uniform (0, 1));
+      break;
+    case 1:
+      line = "B18:1:" + std::to_string (uniform (0, 1 << 30));
+      break;
+    case 2:
+      line = "EB" + std::to_string (uniform (0, 3)) + ":"
+             + std::to_string (uniform (0, 1));
+      break;
+    case 3:
+      line = "Enc" + std::to_string (uniform (0, 3)) + ":"
+             + (uniform (0, 1) ? "1" : "-1");
+      break;
+    case 4:
+      line = "P" + std::to_string (uniform (0, 7)) + ":"
+             + std::to_string (uniform (0, 1023));
+      break;
+    }
+
+  if (uniform (0, 3) == 0)
+    line += '\r';
+  return line;
+}
+
+char
+randomByte (std::mt19937 &random)
+{
+  auto c = '\n';
+  while (c == '\n')
+    c = static_cast<char> (
+        std::uniform_int_distribution<int> (0, 255) (random));
+  return c;
+}
+
+// Valid lines, mutated valid lines, binary noise and overlong lines.
+std::string
+randomLine (std::mt19937 &random)
+{
+  auto uniform = [&] (int min, int max) {
+    return std::uniform_int_distribution<int> (min, max) (random);
+  };
+
+  auto line = randomValidLine (random);
+  switch (uniform (0, 3))
+    {
+    case 0:
+      break;
+    case 1:
+      for (auto mutation = uniform (1, 3); mutation > 0; --mutation)
+        {
+          auto const position = std::size_t (uniform (0, int (line.size ())));
+          switch (uniform (0, 2))
+            {
+            case 0:
+              line.insert (position, 1, randomByte (random));
+              break;
+            case 1:
+              if (position < line.size ())
+                line.erase (position, 1);
+              break;
+            case 2:
+              if (position < line.size ())
+                line[position] = randomByte (random);
+              break;
+            }
+        }
+      break;
+    case 2:
+      line.clear ();
+      for (auto length = uniform (0, 80); length > 0; --length)
+        line += randomByte (random);
+      break;
+    case 3:
+      line.insert (line.find (':') + 1,
+                   std::size_t (SerialLineParser::maxLineLength), '0');
+      break;
+    }
+
+  return line + '\n';
+}
+
+}
+
+TEST (SerialLineParser, ParsesProtocolLines)
+{
+  auto const expectMessage = [] (std::string_view line, Message expected) {
+    auto const message = SerialLineParser::parseLine (line);
+    ASSERT_TRUE (message.has_value ()) << line;
+    EXPECT_TRUE (*message == expected) << line;
+  };
+
+  expectMessage ("B0:1", { Type::Button, 0, 1 });
+  expectMessage ("B17:0\r", { Type::Button, 17, 0 });
+  expectMessage ("B18:1:123456789", { Type::Button, 18, 1, 123456789 });
+  expectMessage ("B18:0", { Type::Button, 18, 0 });
+  expectMessage ("EB3:1", { Type::EncoderPress, 3, 1 });
+  expectMessage ("Enc2:-1", { Type::EncoderIncrement, 2, -1 });
+  expectMessage ("Enc0:1", { Type::EncoderIncrement, 0, 1 });
+  expectMessage ("P7:1023", { Type::Pot, 7, 1023 });
+}
+
+TEST (SerialLineParser, RejectsMalformedLines)
+{
+  for (auto const line :
+       { "", "\r", "B", "B:1", "B1", "B1:", "B1:2", "B19:1", "B-1:1",
+         "B1:1x", "B1:1:5", "B18:1:", "B18:1:-5", "EB4:1", "Enc1:2",
+         "Enc1:0", "E1:1", "P8:0", "P0:1024", "P0:-1", "P0:+1", "X0:1",
+         "b0:1", " B0:1", "B0:1 ", "P0:99999999999999999999" })
+    EXPECT_FALSE (SerialLineParser::parseLine (line).has_value ()) << line;
+}
+
+TEST (SerialLineParser, SplitsLinesAcrossChunks)
+{
+  SerialLineParser parser;
+  std::vector<Message> messages;
+  auto const handler = [&] (Message const &m) { messages.push_back (m); };
+
+  parser.feed ("P1:5", handler);
+  EXPECT_TRUE (messages.empty ());
+  parser.feed ("12\nEnc0:1\n\nB3", handler);
+  parser.feed (std::string (100, 'x') + "\nB3:0\n", handler);
+  parser.feed (":1\n", handler);
+
+  ASSERT_EQ (messages.size (), 3u);
+  EXPECT_TRUE (messages[0] == (Message{ Type::Pot, 1, 512 }));
+  EXPECT_TRUE (messages[1] == (Message{ Type::EncoderIncrement, 0, 1 }));
+  EXPECT_TRUE (messages[2] == (Message{ Type::Button, 3, 0 }));
+  // the overlong line starting with "B3" and the lone ":1"
+  EXPECT_EQ (parser.getNumLinesDropped (), 2);
+}
+
+// Streams random valid and malformed lines through a pseudo terminal
+// in raw mode, standing in for the controller's /dev/ttyACM0, and
+// checks that exactly the valid lines come out on the other end.
+TEST (SerialLineParser, FuzzOverPseudoTerminal)
+{
+  auto constexpr numLines = 20000;
+
+  auto const master = posix_openpt (O_RDWR | O_NOCTTY);
+  ASSERT_GE (master, 0);
+  ASSERT_EQ (grantpt (master), 0);
+  ASSERT_EQ (unlockpt (master), 0);
+  auto const slave = open (ptsname (master), O_RDWR | O_NOCTTY);
+  ASSERT_GE (slave, 0);
+
+  termios attributes;
+  ASSERT_EQ (tcgetattr (slave, &attributes), 0);
+  cfmakeraw (&attributes);
+  ASSERT_EQ (tcsetattr (slave, TCSANOW, &attributes), 0);
+
+  std::mt19937 random (42);
+  std::string stream;
+  std::vector<Message> expected;
+  for (auto index = 0; index < numLines; ++index)
+    {
+      auto const line = randomLine (random);
+      stream += line;
+
+      auto content = std::string_view (line);
+      content.remove_suffix (1);
+      if (content.size () <= SerialLineParser::maxLineLength)
+        if (auto const message = SerialLineParser::parseLine (content))
+          expected.push_back (*message);
+    }
+  ASSERT_GT (expected.size (), std::size_t (numLines / 4));
+
+  std::thread writer ([&, seed = random ()] {
+    std::mt19937 chunkRandom (seed);
+    std::uniform_int_distribution<std::size_t> chunkSize (1, 300);
+    for (std::size_t offset = 0; offset < stream.size ();)
+      {
+        auto const size = std::min (chunkSize (chunkRandom),
+                                    stream.size () - offset);
+        auto const written = write (master, stream.data () + offset, size);
+        if (written <= 0)
+          break;
+        offset += std::size_t (written);
+      }
+  });
+
+  SerialLineParser parser;
+  std::vector<Message> received;
+  auto const handler = [&] (Message const &m) { received.push_back (m); };
+  while (received.size () < expected.size ())
+    {
+      pollfd fd{ slave, POLLIN, 0 };
+      if (poll (&fd, 1, 2000) <= 0)
+        break;
+      if (parser.readFrom (slave, handler) <= 0)
+        break;
+    }
+
+  writer.join ();
+  close (slave);
+  close (master);
+
+  ASSERT_EQ (received.size (), expected.size ());
+  for (auto index = 0u; index < expected.size (); ++index)
+    {
+      expectWithinProtocolLimits (received[index]);
+      EXPECT_TRUE (received[index] == expected[index]) << index;
+    }
+}
@@ -0,0 +1,153 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/Session.hh>
+#include <a3-motion-engine/tempo/TempoClock.hh>
+
+using namespace a3;
+
+namespace
+{
+
+auto constexpr numChannels = 4u;
+auto constexpr numPatternsPerChannel = 16u;
+auto constexpr lengthBeats = 16;
+
+Session
+createFullSession ()
+{
+  Session session;
+  session.tempoBPM = 123.5f;
+  session.recordingMode = MotionEngine::RecordingMode::Loop;
+  for (auto channel = 0u; channel < numChannels; ++channel)
+    session.channels.push_back (
+        { 10.f * channel, int (channel), int (channel) - 2 });
+
+  auto const numTicks = lengthBeats * TempoClock::getTicksPerBeat ();
+  for (auto channel = 0u; channel < numChannels; ++channel)
+    for (auto index = 0u; index < numPatternsPerChannel; ++index)
+      {
+        Session::PatternData pattern;
+        pattern.channel = channel;
+        pattern.index = index;
+        pattern.playbackLength = Measure (0, lengthBeats, 0);
+        for (auto tick = 0; tick < numTicks; ++tick)
+          pattern.ticks.push_back (
+              Pos::fromCartesian (float (tick), float (index), -1.f));
+        session.patterns.push_back (std::move (pattern));
+      }
+  return session;
+}
+
+}
+
+// The timing of a full bank is measured by a3-motion-session-benchmark.
+TEST (Session, RoundTripFullBank)
+{
+  auto const session = createFullSession ();
+
+  juce::MemoryBlock data;
+  session.serialize (data);
+  auto const restored
+      = Session::deserialize (data.getData (), data.getSize ());
+
+  ASSERT_NE (restored, nullptr);
+  EXPECT_EQ (restored->tempoBPM, session.tempoBPM);
+  EXPECT_EQ (restored->recordingMode, session.recordingMode);
+  ASSERT_EQ (restored->channels.size (), numChannels);
+  EXPECT_EQ (restored->channels[3].width, 30.f);
+  EXPECT_EQ (restored->channels[3].ambisonicsOrder, 3);
+  EXPECT_EQ (restored->channels[0].lengthBarLog2, -2);
+
+  ASSERT_EQ (restored->patterns.size (), session.patterns.size ());
+  auto const &pattern = restored->patterns.back ();
+  EXPECT_EQ (pattern.channel, numChannels - 1);
+  EXPECT_EQ (pattern.index, numPatternsPerChannel - 1);
+  EXPECT_EQ (pattern.playbackLength, Measure (0, lengthBeats, 0));
+  EXPECT_EQ (pattern.ticks, session.patterns.back ().ticks);
+}
+
+TEST (Session, RejectsInvalidData)
+{
+  auto session = createFullSession ();
+  session.patterns.resize (2);
+
+  juce::MemoryBlock data;
+  session.serialize (data);
+  ASSERT_NE (Session::deserialize (data.getData (), data.getSize ()),
+             nullptr);
+
+  for (auto size : { std::size_t (0), std::size_t (16), data.getSize () - 1 })
+    EXPECT_EQ (Session::deserialize (data.getData (), size), nullptr);
+
+  auto corrupted = data;
+  static_cast<char *> (corrupted.getData ())[0] = 'X';
+  EXPECT_EQ (Session::deserialize (corrupted.getData (), corrupted.getSize ()),
+             nullptr);
+
+  session.patterns[1].channel = numChannels;
+  session.serialize (data);
+  EXPECT_EQ (Session::deserialize (data.getData (), data.getSize ()),
+             nullptr);
+}
+
+TEST (Session, ValidatesParameters)
+{
+  auto session = createFullSession ();
+  session.patterns.clear ();
+
+  // the clock cannot run at these tempos
+  juce::MemoryBlock data;
+  for (auto tempoBPM :
+       { 0.f, -120.f, 1.e6f, std::numeric_limits<float>::infinity (),
+         std::numeric_limits<float>::quiet_NaN () })
+    {
+      session.tempoBPM = tempoBPM;
+      session.serialize (data);
+      EXPECT_EQ (Session::deserialize (data.getData (), data.getSize ()),
+                 nullptr)
+          << "tempo: " << tempoBPM;
+    }
+
+  session.tempoBPM = 120.f;
+  session.channels[1].width = std::numeric_limits<float>::quiet_NaN ();
+  session.serialize (data);
+  EXPECT_EQ (Session::deserialize (data.getData (), data.getSize ()),
+             nullptr);
+
+  // widths and orders out of range are clamped
+  session.channels[0] = { -10.f, -1, 0 };
+  session.channels[1] = { 1000.f, 7, 0 };
+  session.serialize (data);
+  auto const restored
+      = Session::deserialize (data.getData (), data.getSize ());
+  ASSERT_NE (restored, nullptr);
+  EXPECT_EQ (restored->channels[0].width, 0.f);
+  EXPECT_EQ (restored->channels[0].ambisonicsOrder, 0);
+  EXPECT_EQ (restored->channels[1].width, Session::widthMax);
+  EXPECT_EQ (restored->channels[1].ambisonicsOrder,
+             Session::ambisonicsOrderMax);
+}
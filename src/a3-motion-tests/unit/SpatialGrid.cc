@@ -0,0 +1,152 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-ui/components/SpatialGrid.hh>
+
+using namespace a3;
+
+namespace
+{
+
+using PointT = juce::Point<float>;
+
+std::vector<index_t>
+findWithinRadius (SpatialGrid const &grid, PointT position, float radius)
+{
+  std::vector<index_t> indices;
+  grid.forEachWithinRadius (position, radius,
+                            [&] (index_t index, float distance) {
+                              EXPECT_LT (distance, radius);
+                              indices.push_back (index);
+                            });
+  std::sort (indices.begin (), indices.end ());
+  return indices;
+}
+
+std::vector<index_t>
+findWithinRadiusBruteForce (std::vector<PointT> const &points,
+                            PointT position, float radius)
+{
+  std::vector<index_t> indices;
+  for (auto index = 0u; index < points.size (); ++index)
+    if (points[index].isFinite ()
+        && points[index].getDistanceFrom (position) < radius)
+      indices.push_back (index);
+  return indices;
+}
+
+float
+getClosestDistanceBruteForce (std::vector<PointT> const &points,
+                              PointT position, float radius)
+{
+  auto minDistance = std::numeric_limits<float>::infinity ();
+  for (auto index : findWithinRadiusBruteForce (points, position, radius))
+    minDistance
+        = std::min (minDistance, points[index].getDistanceFrom (position));
+  return minDistance;
+}
+
+}
+
+// Queries inside and outside of the grid bounds have to agree with a
+// scan over all points, independent of the cell size.
+TEST (SpatialGrid, MatchesBruteForce)
+{
+  auto constexpr infinity = std::numeric_limits<float>::infinity ();
+  auto constexpr nan = std::numeric_limits<float>::quiet_NaN ();
+
+  juce::Random random (42);
+  std::vector<PointT> points;
+  for (auto index = 0; index < 200; ++index)
+    points.emplace_back (2.f * random.nextFloat () - 1.f,
+                         2.f * random.nextFloat () - 1.f);
+  // non-finite points are never reported
+  points.insert (points.begin () + 50,
+                 { PointT (nan, 0.f), PointT (0.f, infinity),
+                   PointT (-infinity, nan) });
+
+  SpatialGrid grid;
+  for (auto cellSize : { 0.01f, 0.1f, 0.5f, 10.f })
+    {
+      grid.build (points, cellSize);
+      for (auto query = 0; query < 200; ++query)
+        {
+          // reaches beyond the bounds to cover the clamping at the edges
+          auto const position = PointT (4.f * random.nextFloat () - 2.f,
+                                        4.f * random.nextFloat () - 2.f);
+          for (auto radius : { 0.02f, 0.1f, 0.5f, 4.f })
+            {
+              ASSERT_EQ (findWithinRadius (grid, position, radius),
+                         findWithinRadiusBruteForce (points, position, radius))
+                  << "cell size " << cellSize << ", radius " << radius;
+
+              auto const closest = grid.findClosest (position, radius);
+              auto const minDistance
+                  = getClosestDistanceBruteForce (points, position, radius);
+              if (std::isinf (minDistance))
+                {
+                  EXPECT_FALSE (closest.has_value ());
+                }
+              else
+                {
+                  ASSERT_TRUE (closest.has_value ());
+                  EXPECT_EQ (points[*closest].getDistanceFrom (position),
+                             minDistance);
+                }
+            }
+        }
+    }
+}
+
+TEST (SpatialGrid, SinglePoint)
+{
+  SpatialGrid grid;
+  grid.build ({ PointT (0.5f, 0.f) }, 0.1f);
+
+  EXPECT_EQ (grid.findClosest ({ 0.5f, 0.f }, 0.01f), index_t (0));
+  EXPECT_EQ (grid.findClosest ({ 0.f, 0.f }, 0.6f), index_t (0));
+  // the radius is exclusive
+  EXPECT_FALSE (grid.findClosest ({ 0.f, 0.f }, 0.5f).has_value ());
+
+  // queries far outside the grid are clamped to its edge cells
+  EXPECT_EQ (grid.findClosest ({ -100.f, 50.f }, 200.f), index_t (0));
+  EXPECT_FALSE (grid.findClosest ({ 100.f, 100.f }, 1.f).has_value ());
+}
+
+TEST (SpatialGrid, NoFinitePoints)
+{
+  auto constexpr nan = std::numeric_limits<float>::quiet_NaN ();
+
+  SpatialGrid grid;
+  grid.build ({}, 0.1f);
+  EXPECT_FALSE (grid.findClosest ({ 0.f, 0.f }, 100.f).has_value ());
+
+  grid.build ({ PointT (nan, nan), PointT (0.f, nan) }, 0.1f);
+  EXPECT_FALSE (grid.findClosest ({ 0.f, 0.f }, 100.f).has_value ());
+  EXPECT_TRUE (findWithinRadius (grid, { 0.f, 0.f }, 100.f).empty ());
+}
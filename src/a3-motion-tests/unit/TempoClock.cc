@@ -18,6 +18,11 @@
 
 */
 
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <JuceHeader.h>
@@ -45,3 +50,163 @@ TEST (TempoClock, TimingSyncAsync)
 
   tempoClock.stop ();
 }
+
+namespace
+{
+
+using MillisT = std::chrono::duration<double, std::milli>;
+
+// records the virtual time of all events of one type
+struct EventRecorder
+{
+  EventRecorder (TempoClock &tempoClock, TimeSource const &timeSource,
+                 TempoClock::Event event)
+  {
+    handle = tempoClock.scheduleEventHandlerAddition (
+        [this, &timeSource] (auto) {
+          times.push_back (timeSource.now ().time_since_epoch ());
+        },
+        event, TempoClock::Execution::TimerThread);
+  }
+
+  double
+  getMillis (std::size_t index) const
+  {
+    return MillisT (times[index]).count ();
+  }
+
+  std::vector<TimeSource::ClockT::duration> times;
+  TempoClock::PointerT handle;
+};
+
+}
+
+TEST (TempoClock, VirtualTimeHour)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  TempoClock tempoClock (timeSource);
+  tempoClock.setTempoBPM (120.f);
+
+  auto numTicks = 0;
+  auto tickHandle = tempoClock.scheduleEventHandlerAddition (
+      [&numTicks] (auto) { ++numTicks; }, TempoClock::Event::Tick,
+      TempoClock::Execution::TimerThread);
+  EventRecorder bars (tempoClock, *timeSource, TempoClock::Event::Bar);
+
+  tempoClock.start ();
+
+  Timings timings;
+  {
+    ScopedTimer<> t{ timings, "one hour" };
+    tempoClock.advance (std::chrono::hours (1));
+  }
+  tempoClock.stop ();
+
+  // the clock emits all events once when it starts at time zero
+  auto const beats = 120 * 60;
+  EXPECT_EQ (numTicks, 1 + beats * TempoClock::getTicksPerBeat ());
+  ASSERT_EQ (bars.times.size (), 1u + beats / 4);
+  EXPECT_DOUBLE_EQ (bars.getMillis (1), 2000.);
+  EXPECT_DOUBLE_EQ (bars.getMillis (bars.times.size () - 1), 3600. * 1000.);
+
+  // an hour should be simulated in well under a minute
+  EXPECT_LT (timings.get ()[0].duration, std::chrono::seconds (60));
+}
+
+TEST (TempoClock, TempoChangeKeepsPhase)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  TempoClock tempoClock (timeSource);
+  tempoClock.setTempoBPM (120.f);
+
+  EventRecorder beats (tempoClock, *timeSource, TempoClock::Event::Beat);
+  tempoClock.start ();
+
+  // halfway into the second beat, the remaining half beat takes
+  // 500 ms at the new tempo.
+  tempoClock.advance (std::chrono::milliseconds (750));
+  tempoClock.setTempoBPM (60.f);
+  tempoClock.advance (std::chrono::milliseconds (2000));
+  tempoClock.stop ();
+
+  EXPECT_FLOAT_EQ (tempoClock.getCurrentTempoBPM (), 60.f);
+  ASSERT_EQ (beats.times.size (), 4u);
+  EXPECT_DOUBLE_EQ (beats.getMillis (1), 500.);
+  EXPECT_NEAR (beats.getMillis (2), 1250., 1.);
+  EXPECT_NEAR (beats.getMillis (3), 2250., 1.);
+}
+
+TEST (TempoClock, RampReachesTarget)
+{
+  for (auto shape :
+       { TempoClock::RampShape::Linear, TempoClock::RampShape::Exponential })
+    {
+      auto timeSource = std::make_shared<TimeSourceVirtual> ();
+      TempoClock tempoClock (timeSource);
+      tempoClock.setTempoBPM (120.f);
+
+      EventRecorder beats (tempoClock, *timeSource, TempoClock::Event::Beat);
+      tempoClock.start ();
+      tempoClock.advance (std::chrono::milliseconds (1));
+
+      tempoClock.rampTempoBPM (60.f, 4.f, shape);
+      EXPECT_FLOAT_EQ (tempoClock.getTempoBPM (), 60.f);
+      EXPECT_FLOAT_EQ (tempoClock.getCurrentTempoBPM (), 120.f);
+
+      tempoClock.advance (std::chrono::seconds (8));
+      tempoClock.stop ();
+
+      EXPECT_FLOAT_EQ (tempoClock.getCurrentTempoBPM (), 60.f);
+
+      // beats slow down during the ramp and run at the target tempo
+      // afterwards.
+      ASSERT_GE (beats.times.size (), 7u);
+      for (auto index = 2u; index <= 4u; ++index)
+        EXPECT_GT (beats.getMillis (index) - beats.getMillis (index - 1),
+                   beats.getMillis (index - 1) - beats.getMillis (index - 2));
+      auto const last = beats.times.size () - 1;
+      EXPECT_NEAR (beats.getMillis (last) - beats.getMillis (last - 1), 1000.,
+                   1.);
+    }
+}
+
+TEST (TempoClock, RejectsInvalidTempo)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  TempoClock tempoClock (timeSource);
+  tempoClock.setTempoBPM (120.f);
+
+  for (auto tempoBPM : { 0.f, -60.f, std::numeric_limits<float>::infinity (),
+                         std::numeric_limits<float>::quiet_NaN () })
+    {
+      EXPECT_FALSE (tempoClock.rampTempoBPM (tempoBPM, 1.f));
+      EXPECT_FALSE (tempoClock.setTempoBPM (tempoBPM));
+    }
+  EXPECT_FLOAT_EQ (tempoClock.getTempoBPM (), 120.f);
+}
+
+TEST (TempoClock, TapSourcesAreSeparate)
+{
+  auto timeSource = std::make_shared<TimeSourceVirtual> ();
+  TempoClock tempoClock (timeSource);
+
+  // the controller's clock runs far ahead of the beat tracker's
+  auto constexpr controllerMicros = juce::int64 (3600000000);
+  EXPECT_EQ (tempoClock.tap (controllerMicros),
+             TempoClock::TapResult::TempoNotAvailable);
+  EXPECT_EQ (tempoClock.tap (1000000, TempoClock::TapSource::BeatTracker),
+             TempoClock::TapResult::TempoNotAvailable);
+  EXPECT_EQ (tempoClock.tap (controllerMicros + 500000),
+             TempoClock::TapResult::TempoAvailable);
+  EXPECT_FLOAT_EQ (tempoClock.getTempoBPM (), 120.f);
+  EXPECT_EQ (tempoClock.tap (1400000, TempoClock::TapSource::BeatTracker),
+             TempoClock::TapResult::TempoAvailable);
+  EXPECT_FLOAT_EQ (tempoClock.getTempoBPM (), 150.f);
+
+  // after a restart of the tracker's clock, earlier beats are
+  // forgotten instead of yielding a negative interval
+  tempoClock.resetTaps (TempoClock::TapSource::BeatTracker);
+  EXPECT_EQ (tempoClock.tap (200000, TempoClock::TapSource::BeatTracker),
+             TempoClock::TapResult::TempoNotAvailable);
+  EXPECT_FLOAT_EQ (tempoClock.getTempoBPM (), 150.f);
+}
@@ -0,0 +1,125 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <gtest/gtest.h>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/tempo/TempoEstimator.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorIRLS.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorLast.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorMean.hh>
+#include <a3-motion-engine/tempo/TempoEstimatorMeanSelective.hh>
+
+using namespace a3;
+
+template <typename EstimatorT>
+std::unique_ptr<TempoEstimator>
+createEstimator ()
+{
+  if constexpr (std::is_same_v<EstimatorT, TempoEstimatorMeanSelective>)
+    return std::make_unique<EstimatorT> (4);
+  else
+    return std::make_unique<EstimatorT> ();
+}
+
+template <typename EstimatorT>
+class TempoEstimatorTest : public testing::Test
+{
+};
+using EstimatorTypes
+    = ::testing::Types<TempoEstimatorLast, TempoEstimatorMean,
+                       TempoEstimatorMeanSelective, TempoEstimatorIRLS>;
+TYPED_TEST_SUITE (TempoEstimatorTest, EstimatorTypes);
+
+TYPED_TEST (TempoEstimatorTest, NeedsTwoTaps)
+{
+  auto estimator = createEstimator<TypeParam> ();
+  ASSERT_EQ (estimator->tap (1000000),
+             TempoEstimator::TapResult::TempoNotAvailable);
+  ASSERT_EQ (estimator->tap (1500000),
+             TempoEstimator::TapResult::TempoAvailable);
+  ASSERT_NEAR (estimator->getTempoBPM (), 120.f, 1e-3f);
+}
+
+TYPED_TEST (TempoEstimatorTest, SteadyTempoBeyondRingCapacity)
+{
+  auto estimator = createEstimator<TypeParam> ();
+
+  auto constexpr microsPerBeat = juce::int64 (60000000 / 128);
+  auto timeMicros = juce::int64 (1000000);
+  for (auto tap = 0; tap < 100; ++tap)
+    {
+      estimator->tap (timeMicros);
+      timeMicros += microsPerBeat;
+    }
+  ASSERT_NEAR (estimator->getTempoBPM (), 128.f, 1e-2f);
+}
+
+TYPED_TEST (TempoEstimatorTest, FlushAfterPause)
+{
+  auto estimator = createEstimator<TypeParam> ();
+
+  auto timeMicros = juce::int64 (1000000);
+  for (auto tap = 0; tap < 8; ++tap)
+    {
+      estimator->tap (timeMicros);
+      timeMicros += 1000000; // 60 BPM
+    }
+
+  // a pause longer than the maximum time between taps starts over
+  timeMicros += 5000000;
+  ASSERT_EQ (estimator->tap (timeMicros),
+             TempoEstimator::TapResult::TempoNotAvailable);
+  ASSERT_EQ (estimator->tap (timeMicros + 400000),
+             TempoEstimator::TapResult::TempoAvailable);
+  ASSERT_NEAR (estimator->getTempoBPM (), 150.f, 1e-2f);
+}
+
+TYPED_TEST (TempoEstimatorTest, FlushWhenClockGoesBack)
+{
+  auto estimator = createEstimator<TypeParam> ();
+  estimator->tap (5000000);
+  estimator->tap (6000000);
+
+  // taps from a restarted clock never yield a negative tempo
+  ASSERT_EQ (estimator->tap (1000000),
+             TempoEstimator::TapResult::TempoNotAvailable);
+  ASSERT_EQ (estimator->tap (1500000),
+             TempoEstimator::TapResult::TempoAvailable);
+  ASSERT_NEAR (estimator->getTempoBPM (), 120.f, 1e-3f);
+}
+
+TEST (TempoEstimatorMeanSelective, RejectsOutlier)
+{
+  TempoEstimatorMeanSelective estimator (4);
+
+  auto const deltasMicros
+      = std::array<juce::int64, 6>{ 500000, 500000, 500000,
+                                    350000, 500000, 500000 };
+  auto timeMicros = juce::int64 (1000000);
+  estimator.tap (timeMicros);
+  for (auto delta : deltasMicros)
+    {
+      timeMicros += delta;
+      estimator.tap (timeMicros);
+    }
+  ASSERT_NEAR (estimator.getTempoBPM (), 120.f, 1e-3f);
+}
@@ -0,0 +1,85 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <a3-motion-engine/util/TripleBuffer.hh>
+
+using namespace a3;
+
+TEST (TripleBuffer, ConsumerSeesLatestValue)
+{
+  TripleBuffer<int> buffer (0);
+  EXPECT_FALSE (buffer.update ());
+  EXPECT_EQ (buffer.getReadBuffer (), 0);
+
+  for (auto value = 1; value <= 3; ++value)
+    {
+      buffer.getWriteBuffer () = value;
+      buffer.publish ();
+    }
+
+  EXPECT_TRUE (buffer.update ());
+  EXPECT_EQ (buffer.getReadBuffer (), 3);
+  EXPECT_FALSE (buffer.update ());
+  EXPECT_EQ (buffer.getReadBuffer (), 3);
+}
+
+// The producer writes arrays holding the same value in all elements,
+// a torn read would show up as mixed values.
+TEST (TripleBuffer, ConcurrentReadsAreConsistent)
+{
+  auto constexpr numValues = 200000;
+  using ValueT = std::array<int, 64>;
+
+  TripleBuffer<ValueT> buffer (ValueT{});
+  std::atomic<bool> done{ false };
+
+  std::thread producer ([&] {
+    for (auto value = 1; value <= numValues; ++value)
+      {
+        buffer.getWriteBuffer ().fill (value);
+        buffer.publish ();
+      }
+    done = true;
+  });
+
+  auto last = 0;
+  auto consistent = true;
+  auto monotonic = true;
+  while (!done || buffer.update ())
+    {
+      buffer.update ();
+      auto const &value = buffer.getReadBuffer ();
+      for (auto element : value)
+        consistent &= element == value[0];
+      monotonic &= value[0] >= last;
+      last = value[0];
+    }
+  producer.join ();
+
+  EXPECT_TRUE (consistent);
+  EXPECT_TRUE (monotonic);
+  EXPECT_EQ (last, numValues);
+}
@@ -21,6 +21,10 @@
 #include "A3MotionAudioProcessor.hh"
 #include "A3MotionEditor.hh"
 
+#include <utility>
+
+#include <a3-motion-engine/Session.hh>
+
 namespace
 {
 }
@@ -49,6 +53,7 @@ A3MotionAudioProcessor::A3MotionAudioProcessor ()
 A3MotionAudioProcessor::~A3MotionAudioProcessor ()
 {
   // Logger::writeToLog ("~A3MotionAudioProcessor");
+  _threadPoolRestore.removeAllJobs (true, -1);
   juce::Logger::setCurrentLogger (nullptr);
 }
 
@@ -131,9 +136,10 @@ A3MotionAudioProcessor::changeProgramName (int index,
 void
 A3MotionAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-  juce::ignoreUnused (sampleRate);
   juce::ignoreUnused (samplesPerBlock);
 
+  _beatTracker.prepare (sampleRate);
+
   // Logger::writeToLog("prepareToPlay");
 }
 
@@ -161,6 +167,10 @@ A3MotionAudioProcessor::processBlock (juce::AudioBuffer<float> &buffer,
 
   auto mainInputOutput = getBusBuffer (buffer, true, 0);
 
+  _beatTracker.process (mainInputOutput.getArrayOfReadPointers (),
+                        mainInputOutput.getNumChannels (),
+                        mainInputOutput.getNumSamples ());
+
   // add a hopefully inaudible float epsilon here to circumvent VST3
   // plugin auto-suspend (tested in Bitwig). This is ugly, let's
   // hope we can switch to CLAP soon or find a saner solution by
@@ -190,18 +200,69 @@ A3MotionAudioProcessor::createEditor ()
 void
 A3MotionAudioProcessor::getStateInformation (juce::MemoryBlock &destData)
 {
-  juce::ignoreUnused (destData);
-
   // Logger::writeToLog("getStateInformation");
+
+  std::shared_ptr<Session const> session;
+  {
+    std::lock_guard<std::mutex> lock (_mutexSession);
+    // the editor's state may only be read on the message thread,
+    // otherwise the session captured last is saved.
+    if (_sessionCapture && juce::MessageManager::existsAndIsCurrentThread ())
+      _session = _sessionCapture ();
+    session = _session;
+  }
+
+  if (session)
+    session->serialize (destData);
 }
 
 void
 A3MotionAudioProcessor::setStateInformation (const void *data, int sizeInBytes)
 {
-  juce::ignoreUnused (data);
-  juce::ignoreUnused (sizeInBytes);
-
   // Logger::writeToLog("setStateInformation");
+
+  // decoding allocates all patterns, hosts usually call this on the
+  // message thread.
+  auto block = std::make_shared<juce::MemoryBlock> (
+      data, static_cast<std::size_t> (sizeInBytes));
+  _threadPoolRestore.addJob ([this, block] {
+    std::shared_ptr<Session const> session
+        = Session::deserialize (block->getData (), block->getSize ());
+    if (!session)
+      {
+        juce::Logger::writeToLog ("ignoring invalid plugin state");
+        return;
+      }
+
+    std::lock_guard<std::mutex> lock (_mutexSession);
+    _session = session;
+    _sessionRestored = session;
+  });
+}
+
+void
+A3MotionAudioProcessor::setSessionCapture (SessionCapture capture)
+{
+  std::lock_guard<std::mutex> lock (_mutexSession);
+  if (!capture && _sessionCapture)
+    {
+      _session = _sessionCapture ();
+      _sessionRestored = _session;
+    }
+  _sessionCapture = std::move (capture);
+}
+
+std::shared_ptr<Session const>
+A3MotionAudioProcessor::takeRestoredSession ()
+{
+  std::lock_guard<std::mutex> lock (_mutexSession);
+  return std::exchange (_sessionRestored, nullptr);
+}
+
+BeatTracker &
+A3MotionAudioProcessor::getBeatTracker ()
+{
+  return _beatTracker;
 }
 
 } // namespace a3 end
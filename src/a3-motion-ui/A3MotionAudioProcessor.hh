@@ -20,11 +20,19 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <mutex>
+
 #include <JuceHeader.h>
 
+#include <a3-motion-engine/tempo/BeatTracker.hh>
+
 namespace a3
 {
 
+class Session;
+
 class A3MotionAudioProcessor : public juce::AudioProcessor
 {
 public:
@@ -58,11 +66,32 @@ public:
   void getStateInformation (juce::MemoryBlock &destData) override;
   void setStateInformation (const void *data, int sizeInBytes) override;
 
+  BeatTracker &getBeatTracker ();
+
+  /* The engine runs in the editor, so the session is handed over to
+   * it. Restored sessions are decoded on a background thread and
+   * taken by the editor on the message thread. While an editor is
+   * attached, its capture function provides the session to save.
+   * Detaching it with nullptr keeps the last session for saving and
+   * for the next editor to restore.
+   */
+  using SessionCapture = std::function<std::shared_ptr<Session const> ()>;
+  void setSessionCapture (SessionCapture capture);
+  std::shared_ptr<Session const> takeRestoredSession ();
+
 private:
   juce::String const _namePlugin;
 
   std::unique_ptr<juce::FileLogger> _fileLogger;
 
+  BeatTracker _beatTracker;
+
+  std::mutex _mutexSession;
+  std::shared_ptr<Session const> _session;
+  std::shared_ptr<Session const> _sessionRestored;
+  SessionCapture _sessionCapture;
+  juce::ThreadPool _threadPoolRestore{ 1 };
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (A3MotionAudioProcessor)
 };
 
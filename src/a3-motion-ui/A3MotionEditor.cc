@@ -26,14 +26,26 @@ namespace a3
 {
 
 A3MotionEditor::A3MotionEditor (A3MotionAudioProcessor &p)
-    : AudioProcessorEditor (&p), _motionController (numChannelsInitial)
+    : AudioProcessorEditor (&p), _processor (p),
+      _motionController (numChannelsInitial)
 {
+  _motionController.setBeatTracker (&p.getBeatTracker ());
+
+  _processor.setSessionCapture (
+      [this] { return _motionController.captureSession (); });
+  auto constexpr frequencyPollSessionHz = 10;
+  startTimerHz (frequencyPollSessionHz);
+
   // auto scaleFactor = SystemStats::getEnvironmentVariable
   //     ("OSCCONTROL_SCALE_FACTOR", "1").getFloatValue();
   // setScaleFactor (scaleFactor);
 }
 
-A3MotionEditor::~A3MotionEditor () {}
+A3MotionEditor::~A3MotionEditor ()
+{
+  stopTimer ();
+  _processor.setSessionCapture (nullptr);
+}
 
 void
 A3MotionEditor::paint (juce::Graphics &g)
@@ -47,4 +59,11 @@ A3MotionEditor::resized ()
 {
 }
 
+void
+A3MotionEditor::timerCallback ()
+{
+  if (auto session = _processor.takeRestoredSession ())
+    _motionController.restoreSession (std::move (session));
+}
+
 }
@@ -29,7 +29,8 @@
 namespace a3
 {
 
-class A3MotionEditor : public juce::AudioProcessorEditor
+class A3MotionEditor : public juce::AudioProcessorEditor,
+                       public juce::Timer
 {
 public:
   A3MotionEditor (A3MotionAudioProcessor &);
@@ -38,7 +39,11 @@ public:
   void paint (juce::Graphics &g) override;
   void resized () override;
 
+  // picks up sessions restored by the host
+  void timerCallback () override;
+
 private:
+  A3MotionAudioProcessor &_processor;
   A3MotionUIComponent _motionController;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (A3MotionEditor)
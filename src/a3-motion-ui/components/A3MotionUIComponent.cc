@@ -26,9 +26,13 @@
 #include <a3-motion-engine/Config.hh>
 #include <a3-motion-engine/Pattern.hh>
 #include <a3-motion-engine/PatternGenerator.hh>
+#include <a3-motion-engine/RecordingJournal.hh>
+#include <a3-motion-engine/Session.hh>
+#include <a3-motion-engine/UserConfig.hh>
 #include <a3-motion-engine/elevation/HeightMap.hh>
 #include <a3-motion-engine/elevation/HeightMapFlat.hh>
 #include <a3-motion-engine/elevation/HeightMapSphere.hh>
+#include <a3-motion-engine/tempo/BeatTracker.hh>
 
 #include <a3-motion-ui/Config.hh>
 #include <a3-motion-ui/Helpers.hh>
@@ -46,6 +50,9 @@
 #ifdef HARDWARE_INTERFACE_V2
 #include <a3-motion-ui/io/InputOutputAdapterV2.hh>
 #endif
+#ifdef HARDWARE_INTERFACE_V3
+#include <a3-motion-ui/io/InputOutputAdapterV3.hh>
+#endif
 
 namespace a3
 {
@@ -57,6 +64,7 @@ A3MotionUIComponent::A3MotionUIComponent (unsigned int const numChannels)
   setLookAndFeel (&_lookAndFeel);
 
   initializePatterns ();
+  restorePatterns ();
 
   if (runsOnHardware ())
     {
@@ -74,8 +82,8 @@ A3MotionUIComponent::A3MotionUIComponent (unsigned int const numChannels)
   auto constexpr testTempoEstimation = false;
   if (testTempoEstimation)
     {
+      // taps are forwarded in handleTap
       _tempoEstimatorTest = std::make_unique<TempoEstimatorTest> ();
-      _ioAdapter->getTapTimeMicros ().addListener (_tempoEstimatorTest.get ());
     }
 }
 
@@ -88,6 +96,9 @@ A3MotionUIComponent::~A3MotionUIComponent ()
 
   _engine.removePatternStatusListener (this);
   setLookAndFeel (nullptr);
+
+  if (_patternBank.isOpen () && _patternBank.getLogSize () > 0)
+    _patternBank.compact ();
 }
 
 void
@@ -123,14 +134,23 @@ A3MotionUIComponent::createChannelsUI ()
     }
 
   _lengthsBarLog2 = std::vector<int> (numChannels, 0);
+
+  _engine.getSnapshot (_engineSnapshot);
+  for (auto const &channelState : _engineSnapshot.channels)
+    {
+      _widthsShown.push_back (channelState.width);
+      _ordersShown.push_back (channelState.ambisonicsOrder);
+    }
 }
 
 void
 A3MotionUIComponent::handleLengthIncrement (index_t channel, int increment)
 {
   jassert (increment == -1 || increment == 1);
-  if (!_engine.isRecording ()
-      || _engine.getRecordingPattern ()->getChannel () != channel)
+
+  _engine.getSnapshot (_engineSnapshot);
+  if (!_engineSnapshot.isRecording ()
+      || _engineSnapshot.patternRecording->getChannel () != channel)
     {
       if (increment == 1)
         {
@@ -145,19 +165,10 @@ A3MotionUIComponent::handleLengthIncrement (index_t channel, int increment)
               _lengthsBarLog2[channel], lengthBarMinLog2, lengthBarMaxLog2);
         }
 
-      auto const lengthBars = std::exp2 (_lengthsBarLog2[channel]);
-      if (_lengthsBarLog2[channel] >= 0)
-        {
-          _channelStrips[channel]->setTextBarsLabel (
-              juce::String (lengthBars));
-        }
-      else
-        {
-          _channelStrips[channel]->setTextBarsLabel (
-              "1/" + juce::String (int (1.f / lengthBars)));
-        }
+      updateBarsLabel (channel);
 
-      auto playingPattern = _engine.getPlayingPattern (channel);
+      auto const &playingPattern
+          = _engineSnapshot.channels[channel].patternPlaying;
       if (playingPattern)
         {
           auto playbackLength
@@ -170,6 +181,21 @@ A3MotionUIComponent::handleLengthIncrement (index_t channel, int increment)
     }
 }
 
+void
+A3MotionUIComponent::updateBarsLabel (index_t channel)
+{
+  auto const lengthBars = std::exp2 (_lengthsBarLog2[channel]);
+  if (_lengthsBarLog2[channel] >= 0)
+    {
+      _channelStrips[channel]->setTextBarsLabel (juce::String (lengthBars));
+    }
+  else
+    {
+      _channelStrips[channel]->setTextBarsLabel (
+          "1/" + juce::String (int (1.f / lengthBars)));
+    }
+}
+
 int
 A3MotionUIComponent::getLengthBeats (index_t channel) const
 {
@@ -212,27 +238,32 @@ A3MotionUIComponent::createHardwareInterface ()
 #if HARDWARE_INTERFACE_ENABLED
 #ifdef HARDWARE_INTERFACE_V2
   _ioAdapter = std::make_unique<InputOutputAdapterV2> ();
+#elif defined(HARDWARE_INTERFACE_V3)
+  _ioAdapter = std::make_unique<InputOutputAdapterV3> ();
 #else
 #error hardware interface enabled but no implementation selected!
 #endif
-  _ioAdapter->getButton (Button::Shift).addListener (this);
-  _ioAdapter->getButton (Button::Record).addListener (this);
-  _ioAdapter->getButton (Button::Tap).addListener (this);
-  _ioAdapter->getTapTimeMicros ().addListener (this);
-  for (auto channel = 0u; channel < _ioAdapter->getNumChannels (); ++channel)
-    {
-      for (auto pad = 0u; pad < _ioAdapter->getNumPadsPerChannel (); ++pad)
-        {
-          _ioAdapter->getPad (channel, pad).addListener (this);
-        }
-
-      _ioAdapter->getPot (channel, 0).addListener (this);
-      _ioAdapter->getPot (channel, 1).addListener (this);
-      _ioAdapter->getEncoderIncrement (channel).addListener (this);
-    }
+  using Execution = InputOutputAdapter::Execution;
+  _ioAdapter->setEventHandler (
+      Event::Kind::Button, Execution::MessageThread,
+      [this] (auto const &event) { handleButtonEvent (event); });
+  _ioAdapter->setEventHandler (
+      Event::Kind::Pad, Execution::MessageThread,
+      [this] (auto const &event) { handlePadEvent (event); });
+  _ioAdapter->setEventHandler (
+      Event::Kind::EncoderIncrement, Execution::MessageThread,
+      [this] (auto const &event) {
+        handleLengthIncrement (event.channel, static_cast<int> (event.value));
+      });
+  _ioAdapter->setEventHandler (
+      Event::Kind::Tap, Execution::MessageThread,
+      [this] (auto const &event) { handleTap (event.timeMicros); });
+  // pots only change atomic engine parameters, the UI picks them up
+  // from the engine snapshot in tickCallback
+  _ioAdapter->setEventHandler (
+      Event::Kind::Pot, Execution::IOThread,
+      [this] (auto const &event) { handlePotEvent (event); });
   _ioAdapter->startThread ();
-
-  blankLEDs ();
 #endif
 }
 
@@ -247,40 +278,205 @@ A3MotionUIComponent::initializePatterns ()
     channelPatterns.resize (numPatternsPerChannel);
 
   auto constexpr lengthBeatsPreMadePatterns = 16;
+  auto constexpr radius = .8f;
+  auto constexpr degrees = 360.f;
+  std::vector<std::unique_ptr<Pattern> > preMadePatterns;
+  preMadePatterns.push_back (PatternGenerator::createCircle (
+      lengthBeatsPreMadePatterns, radius, degrees, *_heightMap));
+  preMadePatterns.push_back (PatternGenerator::createFigureOfEight (
+      lengthBeatsPreMadePatterns, radius, *_heightMap));
+  preMadePatterns.push_back (PatternGenerator::createCornerStep (
+      lengthBeatsPreMadePatterns, radius, *_heightMap));
+
+  // all channels play the same pre-made tick data
   for (auto channel = 0u; channel < numChannels; ++channel)
+    for (auto index = 0u; index < preMadePatterns.size (); ++index)
+      {
+        auto pattern = std::make_shared<Pattern> ();
+        pattern->shareTicks (*preMadePatterns[index]);
+        pattern->setStatus (Pattern::Status::Idle);
+        placePattern (channel, index, std::move (pattern));
+      }
+}
+
+void
+A3MotionUIComponent::placePattern (index_t channel, index_t index,
+                                   std::shared_ptr<Pattern> pattern)
+{
+  pattern->setChannel (channel);
+  pattern->setId (getSlot (channel, index));
+  _patterns[channel][index] = std::move (pattern);
+}
+
+std::uint32_t
+A3MotionUIComponent::getSlot (index_t channel, index_t index) const
+{
+  return std::uint32_t (channel * _patterns[channel].size () + index);
+}
+
+void
+A3MotionUIComponent::restorePatterns ()
+{
+  auto const pathConfig = userConfig["patternBank"].toString ();
+  if (pathConfig.isNotEmpty ())
+    {
+      auto const path = juce::File::getCurrentWorkingDirectory ()
+                            .getChildFile (pathConfig)
+                            .getFullPathName ();
+      if (!_patternBank.open (path.toStdString ()))
+        juce::Logger::writeToLog ("could not open pattern bank: " + path);
+    }
+
+  for (auto const slot : _patternBank.getSlots ())
     {
-      auto constexpr radius = .8f;
-      auto constexpr degrees = 360.f;
-      _patterns[channel][0] = PatternGenerator::createCircle (
-          lengthBeatsPreMadePatterns, radius, degrees, *_heightMap);
-      _patterns[channel][0]->setChannel (channel);
+      auto const numPatternsPerChannel = _patterns[0].size ();
+      auto const channel = slot / numPatternsPerChannel;
+      if (channel >= _patterns.size ())
+        continue;
+
+      auto pattern = std::make_shared<Pattern> ();
+      _patternBank.load (slot, *pattern);
+      pattern->setStatus (Pattern::Status::Idle);
+      placePattern (channel, slot % numPatternsPerChannel, pattern);
+    }
 
-      _patterns[channel][1] = PatternGenerator::createFigureOfEight (
-          lengthBeatsPreMadePatterns, radius, *_heightMap);
-      _patterns[channel][1]->setChannel (channel);
+  recoverRecordings ();
 
-      _patterns[channel][2] = PatternGenerator::createCornerStep (
-          lengthBeatsPreMadePatterns, radius, *_heightMap);
-      _patterns[channel][2]->setChannel (channel);
+  // only patterns that are recorded from here on have to be stored
+  for (auto const &channelPatterns : _patterns)
+    for (auto const &pattern : channelPatterns)
+      if (pattern)
+        _versionsStored[pattern->getId ()] = pattern->getVersion ();
+}
+
+void
+A3MotionUIComponent::recoverRecordings ()
+{
+  auto const pathConfig = userConfig["recordingJournal"].toString ();
+  if (pathConfig.isEmpty ())
+    return;
+
+  auto const path = juce::File::getCurrentWorkingDirectory ()
+                        .getChildFile (pathConfig)
+                        .getFullPathName ()
+                        .toStdString ();
+
+  // The journal holds everything recorded since the last start. That
+  // includes recordings interrupted by a crash, which never made it
+  // into the pattern bank.
+  auto recordings = RecordingJournal::replay (path);
+  for (auto &[slot, recording] : recordings)
+    {
+      auto const numPatternsPerChannel = _patterns[0].size ();
+      auto const channel = slot / numPatternsPerChannel;
+      if (channel >= _patterns.size ())
+        continue;
+
+      auto pattern = std::make_shared<Pattern> ();
+      pattern->setTicks (std::move (recording.ticks));
+      pattern->setStatus (Pattern::Status::Idle);
+      placePattern (channel, slot % numPatternsPerChannel, pattern);
+      if (_patternBank.isOpen ())
+        _patternBank.store (slot, *pattern);
     }
+  if (!recordings.empty ())
+    juce::Logger::writeToLog ("recovered " + juce::String (recordings.size ())
+                              + " recordings from " + path);
+
+  auto syncIntervalMillis = int (userConfig["journalSyncIntervalMillis"]);
+  if (syncIntervalMillis <= 0)
+    syncIntervalMillis = journalSyncIntervalMillisDefault;
+  _engine.getRecordingJournal ().open (path, syncIntervalMillis);
 }
 
 void
-A3MotionUIComponent::blankLEDs ()
+A3MotionUIComponent::storePattern (std::shared_ptr<Pattern> const &pattern)
 {
-  _ioAdapter->getButtonLED (Button::Shift) = false;
-  _ioAdapter->getButtonLED (Button::Record) = false;
-  _ioAdapter->getButtonLED (Button::Tap) = false;
+  if (!_patternBank.isOpen ())
+    return;
+
+  // patterns replaced by a restored session are not stored anymore
+  auto const &channelPatterns = _patterns[pattern->getChannel ()];
+  if (std::find (channelPatterns.begin (), channelPatterns.end (), pattern)
+      == channelPatterns.end ())
+    return;
+
+  auto const slot = pattern->getId ();
+  auto const version = pattern->getVersion ();
+  auto const stored = _versionsStored.find (slot);
+  if (stored != _versionsStored.end () && stored->second == version)
+    return;
+
+  if (_patternBank.store (slot, *pattern))
+    _versionsStored[slot] = version;
+}
 
-  for (auto channel = 0u; channel < _ioAdapter->getNumChannels (); ++channel)
+std::shared_ptr<Session const>
+A3MotionUIComponent::captureSession ()
+{
+  auto session = std::make_shared<Session> ();
+  session->tempoBPM = _engine.getTempoClock ().getTempoBPM ();
+  session->recordingMode = _engine.getRecordingMode ();
+
+  for (auto channel = 0u; channel < _engine.getNumChannels (); ++channel)
+    session->channels.push_back ({ _engine.getChannelWidth (channel),
+                                   _engine.getChannelAmbisonicsOrder (channel),
+                                   _lengthsBarLog2[channel] });
+
+  for (auto channel = 0u; channel < _patterns.size (); ++channel)
+    for (auto index = 0u; index < _patterns[channel].size (); ++index)
+      {
+        auto const &pattern = _patterns[channel][index];
+        if (!pattern || pattern->getStatus () == Pattern::Status::Empty)
+          continue;
+
+        session->patterns.push_back ({ channel, index,
+                                       pattern->getTicks ().positions,
+                                       pattern->getPlaybackLength () });
+      }
+
+  return session;
+}
+
+void
+A3MotionUIComponent::restoreSession (std::shared_ptr<Session const> session)
+{
+  _engine.restoreSession (session);
+
+  for (auto channel = 0u;
+       channel < std::min (session->channels.size (), _lengthsBarLog2.size ());
+       ++channel)
     {
-      for (auto pad = 0u; pad < _ioAdapter->getNumPadsPerChannel (); ++pad)
-        {
-          _ioAdapter->getPadLED (channel, pad)
-              = juce::VariantConverter<juce::Colour>::toVar (
-                  juce::Colours::black);
-        }
+      _lengthsBarLog2[channel]
+          = std::clamp (session->channels[channel].lengthBarLog2,
+                        lengthBarMinLog2, lengthBarMaxLog2);
+      updateBarsLabel (channel);
+    }
+
+  // the engine releases the previous patterns with the next tick
+  for (auto &channelPatterns : _patterns)
+    for (auto &pattern : channelPatterns)
+      {
+        if (pattern)
+          _motionComponent->unsetPreviewPattern (pattern);
+        pattern = nullptr;
+      }
+
+  for (auto const &data : session->patterns)
+    {
+      if (data.channel >= _patterns.size ()
+          || data.index >= _patterns[data.channel].size ())
+        continue;
+
+      auto pattern = std::make_shared<Pattern> ();
+      pattern->setTicks (data.ticks);
+      pattern->setPlaybackLength (data.playbackLength);
+      pattern->setStatus (Pattern::Status::Idle);
+      placePattern (data.channel, data.index, pattern);
     }
+
+  // restored patterns are not in the pattern bank yet
+  _versionsStored.clear ();
 }
 
 void
@@ -338,103 +534,64 @@ A3MotionUIComponent::getMinimumHeight () const
   return minimumHeight;
 }
 
-// TODO: factor this into separate listeners so not all sources have to
-// be tested exhaustively.
 void
-A3MotionUIComponent::valueChanged (juce::Value &value)
+A3MotionUIComponent::handleButtonEvent (Event const &event)
 {
-  if (value.refersToSameSourceAs (_ioAdapter->getButton (Button::Shift)))
+  auto const button = static_cast<Button> (event.index);
+  auto const pressed = event.value > 0.f;
+  _ioAdapter->setButtonLED (button, pressed);
+
+  if (button == Button::Tap && pressed && isButtonPressed (Button::Shift))
     {
-      _ioAdapter->getButtonLED (Button::Shift) = value.getValue ();
+      _engine.getTempoClock ().reset ();
     }
-  else if (value.refersToSameSourceAs (_ioAdapter->getButton (Button::Record)))
+}
+
+void
+A3MotionUIComponent::handlePadEvent (Event const &event)
+{
+  auto const channel = event.channel;
+  auto const pad = event.index;
+  if (event.value > 0.f)
     {
-      _ioAdapter->getButtonLED (Button::Record) = value.getValue ();
+      handlePadPress (channel, pad);
     }
-  else if (value.refersToSameSourceAs (_ioAdapter->getButton (Button::Tap)))
+  else if (_patterns[channel][pad])
     {
-      _ioAdapter->getButtonLED (Button::Tap) = value.getValue ();
-      if (_ioAdapter->getButton (Button::Shift).getValue ()
-          && _ioAdapter->getButton (Button::Tap).getValue ())
-        {
-          _engine.getTempoClock ().reset ();
-        }
+      _motionComponent->unsetPreviewPattern (_patterns[channel][pad]);
     }
-  else if (value.refersToSameSourceAs (_ioAdapter->getTapTimeMicros ()))
+}
+
+void
+A3MotionUIComponent::handlePotEvent (Event const &event)
+{
+  // called from the I/O thread
+  if (event.index == 0)
     {
-      if (!_ioAdapter->getButton (Button::Shift).getValue ())
-        {
-          auto const tapTime = juce::int64 (value.getValue ());
-          auto const result = _engine.getTempoClock ().tap (tapTime);
-          if (result == TempoClock::TapResult::TempoAvailable)
-            {
-              auto const bpm = _engine.getTempoClock ().getTempoBPM ();
-              _valueBPM = bpm;
-            }
-        }
+      auto const width = event.value * 180.f;
+      _engine.setChannelWidth (event.channel, width);
     }
-  else
+  else if (event.index == 1)
     {
-      for (auto channel = 0u; channel < _ioAdapter->getNumChannels ();
-           ++channel)
-        {
-          if (value.refersToSameSourceAs (
-                  _ioAdapter->getEncoderIncrement (channel)))
-            {
-              auto const increment = static_cast<int> (
-                  _ioAdapter->getEncoderIncrement (channel).getValue ());
-              handleLengthIncrement (channel, increment);
-            }
-          else if (value.refersToSameSourceAs (
-                       _ioAdapter->getPot (channel, 0)))
-            {
-              jassert (value.getValue ().isDouble ());
-              auto const width
-                  = static_cast<float> (value.getValue ()) * 180.f;
-              juce::Logger::writeToLog ("channel " + juce::String (channel)
-                                        + " width: " + juce::String (width));
-              _engine.setChannelWidth (channel, width);
-              _channelStrips[channel]->getDirectivityComponent ().setWidth (
-                  width);
-              _channelStrips[channel]->getDirectivityComponent ().repaint ();
-              return;
-            }
-          else if (value.refersToSameSourceAs (
-                       _ioAdapter->getPot (channel, 1)))
-            {
-              jassert (value.getValue ().isDouble ());
-              auto order = static_cast<int> (
-                  static_cast<float> (value.getValue ()) * 4.f);
-              order = std::clamp (order, 0, 3);
-              juce::Logger::writeToLog ("channel " + juce::String (channel)
-                                        + " order: " + juce::String (order));
-              _engine.setChannelAmbisonicsOrder (channel, order);
-              _channelStrips[channel]->getDirectivityComponent ().setOrder (
-                  order);
-              _channelStrips[channel]->getDirectivityComponent ().repaint ();
-              return;
-            }
+      auto order = static_cast<int> (event.value * 4.f);
+      order = std::clamp (order, 0, 3);
+      _engine.setChannelAmbisonicsOrder (event.channel, order);
+    }
+}
 
-          for (auto pad = 0u; pad < _ioAdapter->getNumPadsPerChannel (); ++pad)
-            {
-              if (value.refersToSameSourceAs (
-                      _ioAdapter->getPad (channel, pad)))
-                {
-                  if (value.getValue ())
-                    {
-                      handlePadPress (channel, pad);
-                    }
-                  else
-                    {
-                      if (_patterns[channel][pad])
-                        {
-                          _motionComponent->unsetPreviewPattern (
-                              _patterns[channel][pad]);
-                        }
-                    }
-                  return;
-                }
-            }
+void
+A3MotionUIComponent::handleTap (juce::int64 timeMicros)
+{
+  if (_tempoEstimatorTest)
+    _tempoEstimatorTest->tap (timeMicros);
+
+  if (!isButtonPressed (Button::Shift))
+    {
+      auto const result = _engine.getTempoClock ().tap (timeMicros);
+      if (result == TempoClock::TapResult::TempoAvailable)
+        {
+          auto const bpm = _engine.getTempoClock ().getTempoBPM ();
+          _valueBPM = bpm;
         }
     }
 }
@@ -446,8 +603,7 @@ A3MotionUIComponent::handlePadPress (index_t channel, index_t pad)
     {
       if (!_patterns[channel][pad])
         {
-          _patterns[channel][pad] = std::make_shared<Pattern> ();
-          _patterns[channel][pad]->setChannel (channel);
+          placePattern (channel, pad, std::make_shared<Pattern> ());
         }
 
       auto recordLength = Measure{ 0, getLengthBeats (channel), 0 };
@@ -536,6 +692,7 @@ A3MotionUIComponent::handleMessage (juce::Message const &message)
       {
         _motionComponent->unsetPreviewPattern (messagePatternStatus.pattern);
         _channelStrips[channel]->setTextColour (juce::Colours::white);
+        storePattern (messagePatternStatus.pattern);
         break;
       }
     }
@@ -544,47 +701,74 @@ A3MotionUIComponent::handleMessage (juce::Message const &message)
 bool
 A3MotionUIComponent::isButtonPressed (Button button)
 {
-  return _ioAdapter->getButton (button).getValue ();
+  return _ioAdapter->isButtonPressed (button);
 }
 
 void
-A3MotionUIComponent::tickCallback (Measure measure)
+A3MotionUIComponent::setBeatTracker (BeatTracker *beatTracker)
 {
-  _now = measure;
+  _beatTracker = beatTracker;
+}
 
-  if (runsOnHardware ())
+void
+A3MotionUIComponent::pollBeatTracker ()
+{
+  if (!_beatTracker)
+    return;
+
+  // Beats are only emitted while the tracker follows the beat, so
+  // manual taps take over when it lost the beat. Beat times count the
+  // audio since the tracker was prepared, they are estimated apart
+  // from the controller's taps.
+  auto &tempoClock = _engine.getTempoClock ();
+  BeatTracker::Beat beat;
+  while (_beatTracker->popBeat (beat))
     {
-      if (measure.beat () == 0 && measure.tick () == 0)
-        {
-          _stepsLED = 0;
-        }
+      if (beat.isFirstSinceReset)
+        tempoClock.resetTaps (TempoClock::TapSource::BeatTracker);
 
-      using T =
-          typename std::remove_reference<decltype (measure.tick ())>::type;
-      jassert (ticksPerStepPadLEDs <= std::numeric_limits<T>::max ());
-      auto const divisor = static_cast<T> (ticksPerStepPadLEDs);
-      if (measure.tick () % divisor == 0)
+      auto const result = tempoClock.tap (
+          beat.timeMicros, TempoClock::TapSource::BeatTracker);
+      if (result == TempoClock::TapResult::TempoAvailable)
         {
-          padLEDCallback (_stepsLED++);
+          _valueBPM = tempoClock.getTempoBPM ();
         }
+    }
+}
 
-      if (!_ioAdapter->getButton (Button::Record).getValue ())
+void
+A3MotionUIComponent::tickCallback (Measure measure)
+{
+  _now = measure;
+  _engine.getSnapshot (_engineSnapshot);
+
+  pollBeatTracker ();
+
+  if (runsOnHardware ())
+    {
+      auto const beats
+          = static_cast<float> (measure.beat ())
+            + static_cast<float> (measure.tick ())
+                  / static_cast<float> (TempoClock::getTicksPerBeat ());
+      _ioAdapter->setAnimationPhase (beats * blinksPerBeatPadLEDs);
+      updatePadLEDs ();
+
+      if (!isButtonPressed (Button::Record))
         {
-          _ioAdapter->getButtonLED (Button::Record) = _engine.isRecording ();
+          _ioAdapter->setButtonLED (Button::Record,
+                                    _engineSnapshot.isRecording ());
         }
     }
 
-  auto recordingPattern = _engine.getRecordingPattern ();
+  auto const &recordingPattern = _engineSnapshot.patternRecording;
   if (recordingPattern)
     {
       auto const channel = recordingPattern->getChannel ();
       _motionComponent->setBackgroundColour (
           _channelUIStates[channel]->colour.withAlpha (0.2f));
 
-      auto const progress
-          = recordingPattern->getLastUpdatedTick ()
-            / static_cast<float> (recordingPattern->getNumTicks ());
-      _channelUIStates[channel]->progress = progress;
+      _channelUIStates[channel]->progress
+          = _engineSnapshot.recordingProgress;
       _channelStrips[channel]->repaint ();
     }
   else
@@ -593,13 +777,13 @@ A3MotionUIComponent::tickCallback (Measure measure)
           juce::Colours::black.withAlpha (0.f));
     }
 
-  for (auto channel = 0u; channel < _engine.getNumChannels (); ++channel)
+  for (auto channel = 0u; channel < _engineSnapshot.channels.size ();
+       ++channel)
     {
-      auto playingPattern = _engine.getPlayingPattern (channel);
-      if (playingPattern)
+      auto const &channelState = _engineSnapshot.channels[channel];
+      if (channelState.patternPlaying)
         {
-          auto const playPosition = playingPattern->getPlayPosition ();
-          _channelUIStates[channel]->progress = playPosition;
+          _channelUIStates[channel]->progress = channelState.playPosition;
           _channelStrips[channel]->repaint ();
         }
       else if (!recordingPattern || recordingPattern->getChannel () != channel)
@@ -611,107 +795,103 @@ A3MotionUIComponent::tickCallback (Measure measure)
             }
         }
     }
+
+  updateDirectivities ();
 }
 
 void
-A3MotionUIComponent::padLEDCallback (int step)
+A3MotionUIComponent::updateDirectivities ()
 {
+  for (auto channel = 0u; channel < _engineSnapshot.channels.size ();
+       ++channel)
+    {
+      auto const &channelState = _engineSnapshot.channels[channel];
+      if (juce::exactlyEqual (channelState.width, _widthsShown[channel])
+          && channelState.ambisonicsOrder == _ordersShown[channel])
+        continue;
+
+      _widthsShown[channel] = channelState.width;
+      _ordersShown[channel] = channelState.ambisonicsOrder;
+
+      auto &directivity = _channelStrips[channel]->getDirectivityComponent ();
+      directivity.setWidth (channelState.width);
+      directivity.setOrder (channelState.ambisonicsOrder);
+      directivity.repaint ();
+    }
+}
+
+void
+A3MotionUIComponent::updatePadLEDs ()
+{
+  using PadLED = InputOutputAdapter::PadLED;
+  auto const blink = [] (juce::Colour colour, juce::Colour colourAlternate) {
+    return PadLED{ colour, colourAlternate, PadLED::Animation::Blink };
+  };
+
   for (auto channel = 0u; channel < _ioAdapter->getNumChannels (); ++channel)
     {
       for (auto pad = 0u; pad < _ioAdapter->getNumPadsPerChannel (); ++pad)
         {
-          auto colour = LEDColours::empty;
-          if (_patterns[channel][pad])
+          if (!_patterns[channel][pad])
+            continue;
+
+          auto const status = _patterns[channel][pad]->getStatus ();
+          auto const statusLast = _patterns[channel][pad]->getLastStatus ();
+
+          PadLED led;
+          switch (status)
             {
-              auto const status = _patterns[channel][pad]->getStatus ();
-              auto const statusLast
-                  = _patterns[channel][pad]->getLastStatus ();
-              // juce::Logger::writeToLog (
-              //     juce::String ("(") + juce::String (channel)
-              //     + juce::String (".") + juce::String (pad)
-              //     + juce::String (") : ")
-              //     + juce::String (static_cast<int> (status)));
-
-              switch (status)
-                {
-                case Pattern::Status::Empty:
-                  {
-                    colour = LEDColours::empty;
-                    break;
-                  }
-                case Pattern::Status::Idle:
-                  {
-                    colour = LEDColours::idle;
-                    break;
-                  }
-                case Pattern::Status::ScheduledForRecording:
-                  {
-                    if (step % 2 == 0)
-                      colour = LEDColours::recording;
-                    else
-                      colour = LEDColours::scheduledForRecording;
-                    break;
-                  }
-                case Pattern::Status::Recording:
-                  {
-                    colour = LEDColours::recording;
-                    break;
-                  }
-                case Pattern::Status::ScheduledForPlaying:
-                  {
-                    if (step % 2 == 0)
-                      colour = LEDColours::playing;
-                    else
-                      colour = LEDColours::scheduledForPlaying;
-                    break;
-                  }
-                case Pattern::Status::Playing:
-                  {
-                    colour = LEDColours::playing;
-                    break;
-                  }
-                case Pattern::Status::ScheduledForIdle:
-                  {
-                    jassert (statusLast
-                                 != Pattern::Status::ScheduledForRecording
-                             && statusLast != Pattern::Status::Idle);
-                    colour = scheduledForIdleLEDColour (step, statusLast);
-                  }
-                }
-              _ioAdapter->getPadLED (channel, pad)
-                  = juce::VariantConverter<juce::Colour>::toVar (colour);
+            case Pattern::Status::Empty:
+              led.colour = LEDColours::empty;
+              break;
+            case Pattern::Status::Idle:
+              led.colour = LEDColours::idle;
+              break;
+            case Pattern::Status::ScheduledForRecording:
+              led = blink (LEDColours::recording,
+                           LEDColours::scheduledForRecording);
+              break;
+            case Pattern::Status::Recording:
+              led.colour = LEDColours::recording;
+              break;
+            case Pattern::Status::ScheduledForPlaying:
+              led = blink (LEDColours::playing,
+                           LEDColours::scheduledForPlaying);
+              break;
+            case Pattern::Status::Playing:
+              led.colour = LEDColours::playing;
+              break;
+            case Pattern::Status::ScheduledForIdle:
+              jassert (statusLast != Pattern::Status::ScheduledForRecording
+                       && statusLast != Pattern::Status::Idle);
+              led = scheduledForIdlePadLED (statusLast);
+              break;
             }
+          _ioAdapter->setPadLED (channel, pad, led);
         }
     }
 }
 
-juce::Colour
-A3MotionUIComponent::scheduledForIdleLEDColour (int step,
-                                                Pattern::Status statusLast)
+InputOutputAdapter::PadLED
+A3MotionUIComponent::scheduledForIdlePadLED (Pattern::Status statusLast)
 {
+  using PadLED = InputOutputAdapter::PadLED;
+
   // one-shot recording: don't blink when scheduled for idle
   if (_engine.getRecordingMode () == MotionEngine::RecordingMode::OneShot
       && statusLast == Pattern::Status::Recording)
     {
-      return LEDColours::recording;
+      return { LEDColours::recording, LEDColours::recording,
+               PadLED::Animation::None };
     }
 
-  if (step % 2 == 0)
-    {
-      return LEDColours::scheduledForIdle;
-    }
-  else
-    {
-      if (statusLast == Pattern::Status::Playing || //
-          statusLast == Pattern::Status::ScheduledForPlaying)
-        {
-          return LEDColours::scheduledForPlaying;
-        }
-      else
-        {
-          return LEDColours::scheduledForRecording;
-        }
-    }
+  auto const colourAlternate
+      = (statusLast == Pattern::Status::Playing
+         || statusLast == Pattern::Status::ScheduledForPlaying)
+            ? LEDColours::scheduledForPlaying
+            : LEDColours::scheduledForRecording;
+  return { LEDColours::scheduledForIdle, colourAlternate,
+           PadLED::Animation::Blink };
 }
 
 }
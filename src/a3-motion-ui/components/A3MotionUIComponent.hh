@@ -23,16 +23,19 @@
 #include "a3-motion-engine/tempo/TempoClock.hh"
 #include <JuceHeader.h>
 
+#include <map>
 #include <vector>
 
 #include <a3-motion-engine/MotionEngine.hh>
 #include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/PatternBank.hh>
 
 #include <a3-motion-ui/components/LookAndFeel.hh>
 #include <a3-motion-ui/io/InputOutputAdapter.hh>
 
 namespace a3
 {
+class BeatTracker;
 class TempoEstimator;
 class TempoEstimatorTest;
 
@@ -42,9 +45,9 @@ class StatusBar;
 class ChannelStrip;
 class ChannelUIState;
 class Pattern;
+class Session;
 
 class A3MotionUIComponent : public juce::Component,
-                            public juce::Value::Listener,
                             public juce::MessageListener
 
 {
@@ -58,30 +61,42 @@ public:
   float getMinimumWidth () const;
   float getMinimumHeight () const;
 
-  void valueChanged (juce::Value &value) override;
   void handleMessage (juce::Message const &message) override;
 
+  // Plugin state: the session returned by captureSession can be
+  // serialized on any thread, restoreSession replaces all patterns
+  // and engine parameters.
+  std::shared_ptr<Session const> captureSession ();
+  void restoreSession (std::shared_ptr<Session const> session);
+
+  // Beats detected in the plugin's audio input drive the tempo clock
+  // while the tracker is locked. The tracker must outlive this
+  // component, pass nullptr to detach.
+  void setBeatTracker (BeatTracker *beatTracker);
+
 private:
   static auto constexpr numPages = 4u;
 
   std::unique_ptr<HeightMap> _heightMap;
   MotionEngine _engine;
+  // engine state of the current message thread callback
+  EngineSnapshot _engineSnapshot;
 
   void tickCallback (Measure measure);
-  void padLEDCallback (int step);
-  juce::Colour scheduledForIdleLEDColour (int step,
-                                          Pattern::Status statusLast);
+  void pollBeatTracker ();
+  void updatePadLEDs ();
+  InputOutputAdapter::PadLED
+  scheduledForIdlePadLED (Pattern::Status statusLast);
 
   Measure _now;
   juce::Value _valueBPM;
   TempoClock::PointerT _tickCallbackHandle;
   TempoClock::PointerT _padLEDCallbackHandle;
-  static auto constexpr stepsPerBeatPadLEDs = 4;
-  static auto constexpr ticksPerStepPadLEDs
-      = TempoClock::getTicksPerBeat () / stepsPerBeatPadLEDs;
-  int _stepsLED = 0;
+  // scheduled pads blink in 8th notes
+  static auto constexpr blinksPerBeatPadLEDs = 2;
 
   std::unique_ptr<TempoEstimatorTest> _tempoEstimatorTest;
+  BeatTracker *_beatTracker = nullptr;
 
   LookAndFeel_A3 _lookAndFeel;
 
@@ -90,8 +105,14 @@ private:
   std::vector<std::unique_ptr<ChannelUIState> > _channelUIStates;
 
   void handleLengthIncrement (index_t channel, int increment);
+  void updateBarsLabel (index_t channel);
   int getLengthBeats (index_t channel) const;
   std::vector<int> _lengthsBarLog2;
+
+  // directivity as last shown, follows the engine state
+  void updateDirectivities ();
+  std::vector<float> _widthsShown;
+  std::vector<int> _ordersShown;
   static constexpr auto lengthBarMinLog2 = -2;
   static constexpr auto lengthBarMaxLog2 = 4;
 
@@ -101,16 +122,37 @@ private:
   TempoClock::PointerT _statusBarCallbackHandle;
 
   using Button = InputOutputAdapter::Button;
+  using Event = InputOutputAdapter::Event;
   constexpr bool runsOnHardware ();
   void createHardwareInterface ();
-  void blankLEDs ();
+  void handleButtonEvent (Event const &event);
+  void handlePadEvent (Event const &event);
+  void handlePotEvent (Event const &event);
+  void handleTap (juce::int64 timeMicros);
   void handlePadPress (index_t channel, index_t pad);
   bool isButtonPressed (Button button);
   std::unique_ptr<InputOutputAdapter> _ioAdapter;
 
   void initializePatterns ();
+  // sets the pattern's channel and its id to the slot
+  void placePattern (index_t channel, index_t index,
+                     std::shared_ptr<Pattern> pattern);
+  std::uint32_t getSlot (index_t channel, index_t index) const;
   std::vector<std::vector<std::shared_ptr<Pattern> > > _patterns;
 
+  // Recorded patterns are kept in the bank file configured as
+  // "patternBank", slot numbers enumerate _patterns row by row and
+  // serve as pattern ids. A pattern is stored when it stopped with a
+  // changed version.
+  void restorePatterns ();
+  void storePattern (std::shared_ptr<Pattern> const &pattern);
+  // Replays the recording journal configured as "recordingJournal"
+  // and starts a new one, patterns are journaled by slot.
+  void recoverRecordings ();
+  static constexpr auto journalSyncIntervalMillisDefault = 250;
+  PatternBank _patternBank;
+  std::map<std::uint32_t, std::uint64_t> _versionsStored;
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (A3MotionUIComponent)
 };
 
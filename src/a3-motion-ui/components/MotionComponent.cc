@@ -20,6 +20,9 @@
 
 #include "MotionComponent.hh"
 
+#include <array>
+#include <cstddef>
+
 #include <a3-motion-engine/MotionEngine.hh>
 #include <a3-motion-engine/Pattern.hh>
 
@@ -29,68 +32,215 @@
 namespace
 {
 
-/* Convenience RAII object to make sure we always free the
- * OpenGLGraphicsContext after it was used in the rendering callback.
+/* All shaders map normalized coordinates to clip space via the
+ * 'transform' uniform (xy: scale, zw: offset), so vertex data never
+ * has to be touched when the component is resized. They are written
+ * against GLSL 1.20 and translated for core profiles by JUCE.
  */
-class GLContextGraphics
+char const *const vertexShaderTextured = R"(
+attribute vec2 corner;
+uniform vec4 transform;
+uniform float extent;
+varying vec2 texCoord;
+void main ()
 {
-public:
-  GLContextGraphics (juce::OpenGLContext &glContext, int width, int height)
-  {
-    _glRenderer = juce::createOpenGLGraphicsContext (glContext, width, height);
+  texCoord = vec2 (0.5 + 0.5 * corner.x, 0.5 - 0.5 * corner.y);
+  gl_Position = vec4 (corner * extent * transform.xy + transform.zw,
+                      0.0, 1.0);
+}
+)";
 
-    _graphics = std::make_unique<juce::Graphics> (*_glRenderer);
-    _graphics->addTransform (
-        juce::AffineTransform::scale (float (glContext.getRenderingScale ())));
-  }
+char const *const fragmentShaderTextured = R"(
+varying vec2 texCoord;
+uniform sampler2D image;
+uniform float opacity;
+void main ()
+{
+  gl_FragColor = texture2D (image, texCoord) * opacity;
+}
+)";
+
+char const *const vertexShaderBlobs = R"(
+attribute vec2 corner;
+attribute vec2 centre;
+attribute float radius;
+attribute vec4 colour;
+uniform vec4 transform;
+varying vec2 quadCoord;
+varying vec4 blobColour;
+void main ()
+{
+  quadCoord = corner;
+  blobColour = colour;
+  gl_Position = vec4 ((centre + corner * radius) * transform.xy
+                      + transform.zw, 0.0, 1.0);
+}
+)";
 
-  ~GLContextGraphics ()
-  {
-    _graphics = nullptr;
-    _glRenderer = nullptr;
-  }
+char const *const fragmentShaderBlobs = R"(
+varying vec2 quadCoord;
+varying vec4 blobColour;
+void main ()
+{
+  float radial = length (quadCoord);
+  float smoothing = fwidth (radial);
+  float alpha = blobColour.a
+                * (1.0 - smoothstep (1.0 - smoothing, 1.0, radial));
+  gl_FragColor = vec4 (blobColour.rgb * alpha, alpha);
+}
+)";
 
-  juce::Graphics &
-  get ()
-  {
-    return *_graphics;
-  }
+char const *const vertexShaderStroke = R"(
+attribute vec2 position;
+uniform vec4 transform;
+void main ()
+{
+  gl_Position = vec4 (position * transform.xy + transform.zw, 0.0, 1.0);
+}
+)";
+
+char const *const fragmentShaderStroke = R"(
+uniform vec4 colour;
+void main ()
+{
+  gl_FragColor = colour;
+}
+)";
 
-private:
-  std::unique_ptr<juce::LowLevelGraphicsContext> _glRenderer;
-  std::unique_ptr<juce::Graphics> _graphics;
+// fixed attribute locations, bound before linking the shaders
+enum AttributeLocation : juce::gl::GLuint
+{
+  attributeCorner = 0,
+  attributePosition = 0,
+  attributeCentre = 1,
+  attributeRadius = 2,
+  attributeColour = 3,
 };
 
-// struct VertexUV
-// {
-//   float position[3];
-//   float texCoord[2];
-// };
+std::unique_ptr<juce::OpenGLShaderProgram>
+createShader (
+    juce::OpenGLContext &glContext, char const *vertexShader,
+    char const *fragmentShader,
+    std::vector<std::pair<juce::gl::GLuint, char const *> > const &attributes)
+{
+  using namespace juce::gl;
+  using juce::OpenGLHelpers;
 
-// std::unique_ptr<juce::OpenGLShaderProgram::Attribute>
-// createAttribute (juce::OpenGLShaderProgram &shader, const char
-// *attributeName)
-// {
-//   using namespace ::juce::gl;
+  auto shader = std::make_unique<juce::OpenGLShaderProgram> (glContext);
+  if (!shader->addVertexShader (
+          OpenGLHelpers::translateVertexShaderToV3 (vertexShader))
+      || !shader->addFragmentShader (
+          OpenGLHelpers::translateFragmentShaderToV3 (fragmentShader)))
+    {
+      juce::Logger::writeToLog ("shader compilation failed: "
+                                + shader->getLastError ());
+      jassertfalse;
+      return nullptr;
+    }
 
-//   if (glGetAttribLocation (shader.getProgramID (), attributeName) < 0)
-//     return nullptr;
+  for (auto const &[location, name] : attributes)
+    glBindAttribLocation (shader->getProgramID (), location, name);
 
-//   return std::make_unique<juce::OpenGLShaderProgram::Attribute> (
-//       shader, attributeName);
-// }
+  if (!shader->link ())
+    {
+      juce::Logger::writeToLog ("shader linking failed: "
+                                + shader->getLastError ());
+      jassertfalse;
+      return nullptr;
+    }
 
-// std::unique_ptr<juce::OpenGLShaderProgram::Uniform>
-// createUniform (juce::OpenGLShaderProgram &shader, const char *uniformName)
-// {
-//   using namespace ::juce::gl;
+  return shader;
+}
 
-//   if (glGetUniformLocation (shader.getProgramID (), uniformName) < 0)
-//     return nullptr;
+juce::Point<float>
+normalOf (juce::Point<float> direction)
+{
+  return { -direction.y, direction.x };
+}
 
-//   return std::make_unique<juce::OpenGLShaderProgram::Uniform> (shader,
-//                                                                uniformName);
-// }
+juce::Point<float>
+normalized (juce::Point<float> vector)
+{
+  auto const length = vector.getDistanceFromOrigin ();
+  return length > 0.f ? vector / length : vector;
+}
+
+/* Appends a polygon approximating a circle as a single triangle strip
+ * by zig-zagging between both sides of the circumference.
+ */
+void
+appendDotStrip (juce::Point<float> centre, float radius,
+                std::vector<juce::Point<float> > &vertices)
+{
+  auto constexpr numSegments = 12;
+  auto const vertexAt = [&] (int index) {
+    auto const angle = juce::MathConstants<float>::twoPi * float (index)
+                       / float (numSegments);
+    return centre
+           + juce::Point<float> (std::cos (angle), std::sin (angle)) * radius;
+  };
+
+  vertices.push_back (vertexAt (0));
+  for (auto step = 1; step <= numSegments / 2; ++step)
+    {
+      vertices.push_back (vertexAt (step));
+      if (step != numSegments - step)
+        vertices.push_back (vertexAt (numSegments - step));
+    }
+}
+
+/* Extrudes a polyline point along the averaged normals of its
+ * adjacent segments, returning both sides of the stroke. Miters are
+ * limited to twice the half width to avoid spikes at sharp turns.
+ */
+std::pair<juce::Point<float>, juce::Point<float> >
+extrudeLinePoint (juce::Point<float> const *previous,
+                  juce::Point<float> point, juce::Point<float> const *next,
+                  float halfWidth)
+{
+  jassert (previous != nullptr || next != nullptr);
+
+  auto constexpr miterLimit = 2.f;
+
+  auto const directionPrevious = previous != nullptr
+                                     ? normalized (point - *previous)
+                                     : juce::Point<float> ();
+  auto const directionNext = next != nullptr ? normalized (*next - point)
+                                             : directionPrevious;
+
+  auto tangent = normalized (directionPrevious + directionNext);
+  if (tangent.isOrigin ())
+    tangent = directionNext;
+
+  auto const normal = normalOf (tangent);
+  auto const cosine = normal.getDotProduct (normalOf (directionNext));
+  auto const extent
+      = halfWidth
+        * juce::jmin (1.f / juce::jmax (cosine, 1e-3f), miterLimit);
+
+  return { point + normal * extent, point - normal * extent };
+}
+
+/* Appends a triangle strip for the whole polyline.
+ */
+void
+appendLineStrip (std::vector<juce::Point<float> > const &points,
+                 float halfWidth, std::vector<juce::Point<float> > &vertices)
+{
+  jassert (points.size () >= 2);
+
+  for (auto index = 0u; index < points.size (); ++index)
+    {
+      auto const *previous = index > 0 ? &points[index - 1] : nullptr;
+      auto const *next
+          = index + 1 < points.size () ? &points[index + 1] : nullptr;
+
+      auto const [left, right]
+          = extrudeLinePoint (previous, points[index], next, halfWidth);
+      vertices.push_back (left);
+      vertices.push_back (right);
+    }
+}
 
 // relative to the (square) component extents
 auto constexpr reduceFactorCircle = .8f;
@@ -100,6 +250,29 @@ auto constexpr reduceFactorBlobs = 0.05f;
 auto constexpr activeAreaAroundBlobFactor = 3.f;
 auto constexpr blobHighlightFactor = 1.1f;
 
+// in normalized coordinates
+auto constexpr previewLineThickness = 0.04f;
+
+// upper bound for the rate at which scene changes trigger repaints
+auto constexpr targetFramesPerSecond = 60;
+auto constexpr frameInterval
+    = std::chrono::microseconds (1000 * 1000 / targetFramesPerSecond);
+auto constexpr framePacingWindow = std::chrono::seconds (1);
+
+bool
+isSamePosition (a3::Pos const &lhs, a3::Pos const &rhs)
+{
+  if (!lhs.isValid () || !rhs.isValid ())
+    return lhs.isValid () == rhs.isValid ();
+  return lhs == rhs;
+}
+
+float
+toMilliseconds (std::chrono::steady_clock::duration duration)
+{
+  return std::chrono::duration<float, std::milli> (duration).count ();
+}
+
 }
 
 namespace a3
@@ -111,9 +284,10 @@ MotionComponent::MotionComponent (
     : _engine (engine), _uiStates (uiStates)
 {
   _glContext.setOpenGLVersionRequired (
-      juce::OpenGLContext::OpenGLVersion::defaultGLVersion);
+      juce::OpenGLContext::OpenGLVersion::openGL3_2);
   _glContext.setRenderer (this);
-  _glContext.setContinuousRepainting (true);
+  // frames are triggered from timerCallback when the scene changes
+  _glContext.setContinuousRepainting (false);
   _glContext.setComponentPaintingEnabled (false);
   _glContext.attachTo (*this);
 
@@ -125,8 +299,9 @@ MotionComponent::MotionComponent (
       juce::File::getCurrentWorkingDirectory ().getChildFile (
           "resources/head.svg"));
 
-  // start disocclusion / animation timer
-  startTimer (1 / 60.f);
+  // start disocclusion / animation timer, it checks the scene for
+  // changes once per frame
+  startTimerHz (targetFramesPerSecond);
 }
 
 MotionComponent::~MotionComponent ()
@@ -152,6 +327,7 @@ MotionComponent::resized ()
 void
 MotionComponent::mouseMove (const juce::MouseEvent &event)
 {
+  updateBlobSnapshot (false);
   updateChannelBlobHighlight (event.getPosition ().toFloat ());
 }
 
@@ -159,7 +335,83 @@ void
 MotionComponent::timerCallback ()
 {
   if (_grabbedIndex.has_value ())
-    disoccludeBlobs ();
+    {
+      updateBlobSnapshot (false);
+      disoccludeBlobs ();
+    }
+
+  repaintIfSceneChanged ();
+}
+
+void
+MotionComponent::repaintIfSceneChanged ()
+{
+  captureSceneState (_sceneState);
+  if (_repaintRequested.exchange (false)
+      || !(_sceneState == _sceneStateRendered))
+    {
+      std::swap (_sceneState, _sceneStateRendered);
+      _sceneStatesRender.getWriteBuffer () = _sceneStateRendered;
+      _sceneStatesRender.publish ();
+      _glContext.triggerRepaint ();
+    }
+}
+
+void
+MotionComponent::captureSceneState (SceneState &state)
+{
+  _engine.getSnapshot (_engineSnapshot);
+
+  state.channels.clear ();
+  for (auto channel = 0u; channel < _engineSnapshot.channels.size ();
+       ++channel)
+    {
+      auto const &uiState = *_uiStates[channel];
+      state.channels.push_back ({ _engineSnapshot.channels[channel].position,
+                                  uiState.colour, uiState.highlighted,
+                                  uiState.grabbed });
+    }
+
+  state.previews.clear ();
+  {
+    std::lock_guard<std::mutex> guard (_mutexPreview);
+    for (auto const &pattern : _patternsPreview)
+      state.previews.push_back (
+          { pattern.get (), pattern->getVersion (), pattern->getStatus () });
+  }
+
+  {
+    std::lock_guard<std::mutex> guard (_mutexBackgroundColour);
+    state.backgroundColour = _backgroundColour;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard (_mutexBounds);
+    state.bounds = _bounds;
+  }
+}
+
+bool
+MotionComponent::SceneState::operator== (SceneState const &other) const
+{
+  auto const sameChannel = [] (Channel const &lhs, Channel const &rhs) {
+    return isSamePosition (lhs.position, rhs.position)
+           && lhs.colour == rhs.colour && lhs.highlighted == rhs.highlighted
+           && lhs.grabbed == rhs.grabbed;
+  };
+  auto const samePreview = [] (Preview const &lhs, Preview const &rhs) {
+    return lhs.pattern == rhs.pattern && lhs.version == rhs.version
+           && lhs.status == rhs.status;
+  };
+
+  return std::equal (channels.begin (), channels.end (),
+                     other.channels.begin (), other.channels.end (),
+                     sameChannel)
+         && std::equal (previews.begin (), previews.end (),
+                        other.previews.begin (), other.previews.end (),
+                        samePreview)
+         && backgroundColour == other.backgroundColour
+         && bounds == other.bounds;
 }
 
 void
@@ -185,109 +437,144 @@ MotionComponent::setBackgroundColour (juce::Colour const &colour)
   _backgroundColour = colour;
 }
 
+void
+MotionComponent::updateBlobSnapshot (bool force)
+{
+  auto const now = ClockT::now ();
+  if (!force && now - _blobSnapshotTime < frameInterval)
+    return;
+  _blobSnapshotTime = now;
+
+  _engine.getSnapshot (_engineSnapshot);
+  auto const numChannels = _engineSnapshot.channels.size ();
+  _blobPixels.resize (numChannels);
+  for (auto channel = 0u; channel < numChannels; ++channel)
+    {
+      auto const position = _engineSnapshot.channels[channel].position;
+      _blobPixels[channel]
+          = position.isValid ()
+                ? normalizedToLocal2DPosition (position)
+                : juce::Point<float> (
+                    std::numeric_limits<float>::quiet_NaN (),
+                    std::numeric_limits<float>::quiet_NaN ());
+    }
+
+  _blobGrid.build (_blobPixels, getActiveDistanceInPixel ());
+}
+
 void
 MotionComponent::disoccludeBlobs ()
 {
   jassert (_grabbedIndex.has_value ());
 
-  auto const posGrabbed = _engine.getChannelPosition (_grabbedIndex.value ());
-  jassert (posGrabbed.isValid ());
-  auto const posGrabbedPixel = normalizedToLocal2DPosition (posGrabbed);
-
-  for (auto channel = 0u; channel < _engine.getNumChannels (); ++channel)
+  auto const grabbedIndex = _grabbedIndex.value ();
+  if (grabbedIndex >= _blobPixels.size ())
+    return;
+
+  auto const posGrabbedPixel = _blobPixels[grabbedIndex];
+  jassert (posGrabbedPixel.isFinite ());
+  if (!posGrabbedPixel.isFinite ())
+    return;
+
+  auto const R = getActiveDistanceInPixel ();
+
+  _blobsOccluded.clear ();
+  _blobGrid.forEachWithinRadius (posGrabbedPixel, R,
+                                 [this] (index_t channel, float) {
+                                   if (!_uiStates[channel]->grabbed)
+                                     _blobsOccluded.push_back (channel);
+                                 });
+
+  auto moved = false;
+  auto const setBlobPosition = [&] (index_t channel,
+                                    juce::Point<float> posPixel) {
+    _blobPixels[channel] = posPixel;
+    _engine.setChannel2DPosition (channel,
+                                  localToNormalized2DPosition (posPixel));
+    moved = true;
+  };
+
+  for (auto channel = 0u; channel < _blobPixels.size (); ++channel)
     {
-      if (!_uiStates[channel]->grabbed)
+      auto const P = _blobPixels[channel];
+      if (_uiStates[channel]->grabbed || !P.isFinite ()
+          || P.getDistanceFrom (posGrabbedPixel) < R
+          || P.getDistanceFrom (_uiStates[channel]->posAnchor) <= 1.f)
+        continue;
+
+      // snap back by projection onto circle
+      // borrowing math from:
+      // https://www.geometrictools.com/Documentation/IntersectionLine2Circle2.pdf
+      auto C = posGrabbedPixel;
+
+      jassert (_uiStates[channel]->posAnchor.isFinite ());
+      if (!_uiStates[channel]->posAnchor.isFinite ())
         {
-          auto position = _engine.getChannelPosition (channel);
-          if (!position.isValid ())
-            continue;
-
-          auto posPixel = normalizedToLocal2DPosition (position);
-          auto const distance = posPixel.getDistanceFrom (posGrabbedPixel);
-
-          if (distance < getActiveDistanceInPixel ())
-            { // push out onto circumference
-              // juce::Logger::writeToLog ("disoccluding point "
-              //                           + juce::String (channelIndex));
-              auto offset = posPixel - posGrabbedPixel;
-              offset *= (getActiveDistanceInPixel () + 1.f)
-                        / offset.getDistanceFromOrigin ();
-
-              posPixel = posGrabbedPixel + offset;
-            }
-          else if (posPixel.getDistanceFrom (_uiStates[channel]->posAnchor)
-                   > 1.f)
-            { // snap back by projection onto circle
-              // borrowing math from:
-              // https://www.geometrictools.com/Documentation/IntersectionLine2Circle2.pdf
-              auto R = getActiveDistanceInPixel ();
-
-              auto C = posGrabbedPixel;
-              auto P = posPixel;
-
-              jassert (_uiStates[channel]->posAnchor.isFinite ());
-              if (!_uiStates[channel]->posAnchor.isFinite ())
-                {
-                  _uiStates[channel]->posAnchor = posPixel;
-                }
-
-              auto Pa = _uiStates[channel]->posAnchor;
-
-              auto D = Pa - posPixel;
-
-              auto Delta = P - C;
-              auto D_dot_Delta = D.getDotProduct (Delta);
-
-              auto delta
-                  = D_dot_Delta * D_dot_Delta
-                    - D.getDistanceSquaredFromOrigin ()
-                          * (Delta.getDistanceSquaredFromOrigin () - R * R);
-
-              auto t = .01f; // default: snap back with exponential
-                             // smoothing
-              std::set<float> ts;
-              if (delta > 0.f)
-                {
-                  auto t0 = -(D_dot_Delta - std::sqrt (delta))
-                            / D.getDistanceSquaredFromOrigin ();
-                  auto t1 = -(D_dot_Delta + std::sqrt (delta))
-                            / D.getDistanceSquaredFromOrigin ();
-
-                  auto constexpr eps = 0.001f;
-                  if (t0 >= -eps && t0 <= 1.f + eps)
-                    ts.insert (t0);
-                  if (t1 >= -eps && t1 <= 1.f + eps)
-                    ts.insert (t1);
-
-                  auto tIt = std::min_element (
-                      ts.begin (), ts.end (),
-                      [&] (auto const &lhs, auto const &rhs) {
-                        return P.getDistanceSquaredFrom (P + lhs * D)
-                               < P.getDistanceSquaredFrom (P + rhs * D);
-                        ;
-                      });
-
-                  if (tIt != ts.end ())
-                    t = *tIt;
-                }
-
-              posPixel = P + t * D;
-
-              if (!ts.empty ())
-                {
-                  // after projecting shift outwards to induce slipping
-                  auto Drot = juce::Point<float> (-D.y, D.x);
-                  Drot /= Drot.getDistanceFromOrigin ();
-                  if ((P - C).getDotProduct (Drot) < 0.f)
-                    Drot *= -1.f;
-                  posPixel += .25f * Drot;
-                }
-            }
+          _uiStates[channel]->posAnchor = P;
+        }
+
+      auto Pa = _uiStates[channel]->posAnchor;
+
+      auto D = Pa - P;
+
+      auto Delta = P - C;
+      auto D_dot_Delta = D.getDotProduct (Delta);
+
+      auto delta = D_dot_Delta * D_dot_Delta
+                   - D.getDistanceSquaredFromOrigin ()
+                         * (Delta.getDistanceSquaredFromOrigin () - R * R);
+
+      auto t = .01f; // default: snap back with exponential
+                     // smoothing
+      std::array<float, 2> ts;
+      auto numTs = 0;
+      if (delta > 0.f)
+        {
+          auto t0 = -(D_dot_Delta - std::sqrt (delta))
+                    / D.getDistanceSquaredFromOrigin ();
+          auto t1 = -(D_dot_Delta + std::sqrt (delta))
+                    / D.getDistanceSquaredFromOrigin ();
+
+          auto constexpr eps = 0.001f;
+          if (t0 >= -eps && t0 <= 1.f + eps)
+            ts[numTs++] = t0;
+          if (t1 >= -eps && t1 <= 1.f + eps)
+            ts[numTs++] = t1;
+
+          // the intersection closest to the current position
+          for (auto index = 0; index < numTs; ++index)
+            if (index == 0 || std::abs (ts[index]) < std::abs (t))
+              t = ts[index];
+        }
+
+      auto posPixel = P + t * D;
 
-          _engine.setChannel2DPosition (
-              channel, localToNormalized2DPosition (posPixel));
+      if (numTs > 0)
+        {
+          // after projecting shift outwards to induce slipping
+          auto Drot = juce::Point<float> (-D.y, D.x);
+          Drot /= Drot.getDistanceFromOrigin ();
+          if ((P - C).getDotProduct (Drot) < 0.f)
+            Drot *= -1.f;
+          posPixel += .25f * Drot;
         }
+
+      setBlobPosition (channel, posPixel);
+    }
+
+  // push occluded blobs out onto the circumference
+  for (auto channel : _blobsOccluded)
+    {
+      // juce::Logger::writeToLog ("disoccluding point "
+      //                           + juce::String (channelIndex));
+      auto offset = _blobPixels[channel] - posGrabbedPixel;
+      offset *= (R + 1.f) / offset.getDistanceFromOrigin ();
+
+      setBlobPosition (channel, posGrabbedPixel + offset);
     }
+
+  if (moved)
+    _blobGrid.build (_blobPixels, R);
 }
 
 void
@@ -296,7 +583,8 @@ MotionComponent::mouseDown (const juce::MouseEvent &event)
   for (auto channel = 0u; channel < _engine.getNumChannels (); ++channel)
     _uiStates[channel]->grabbed = false;
 
-  if (_engine.isRecording ())
+  _engine.getSnapshot (_engineSnapshot);
+  if (_engineSnapshot.isRecording ())
     {
       auto const posPixel = event.getPosition ().toFloat ();
       auto const posHOA = localToNormalized2DPosition (posPixel);
@@ -304,6 +592,8 @@ MotionComponent::mouseDown (const juce::MouseEvent &event)
     }
   else
     {
+      updateBlobSnapshot (true);
+
       auto closestIndex = getClosestBlobIndexWithinRadius (
           event.getPosition ().toFloat (), getActiveDistanceInPixel ());
       if (closestIndex.has_value ())
@@ -311,19 +601,12 @@ MotionComponent::mouseDown (const juce::MouseEvent &event)
           auto const index = closestIndex.value ();
           _uiStates[index]->grabbed = true;
           _uiStates[index]->grabOffset
-              = normalizedToLocal2DPosition (
-                    _engine.getChannelPosition (index))
-                - event.getPosition ().toFloat ();
+              = _blobPixels[index] - event.getPosition ().toFloat ();
           _grabbedIndex = index;
 
           // disocclusion: save anchor position for all channels
-          for (auto channel = 0u; channel < _engine.getNumChannels ();
-               ++channel)
-            {
-              auto const posChannel = _engine.getChannelPosition (channel);
-              _uiStates[channel]->posAnchor
-                  = normalizedToLocal2DPosition (posChannel);
-            }
+          for (auto channel = 0u; channel < _blobPixels.size (); ++channel)
+            _uiStates[channel]->posAnchor = _blobPixels[channel];
         }
     }
 }
@@ -346,7 +629,8 @@ MotionComponent::mouseDrag (const juce::MouseEvent &event)
 {
   auto const posPixel = event.getPosition ().toFloat ();
 
-  if (_engine.isRecording ())
+  _engine.getSnapshot (_engineSnapshot);
+  if (_engineSnapshot.isRecording ())
     {
       auto const posHOA = localToNormalized2DPosition (posPixel);
       _engine.setRecording2DPosition (posHOA);
@@ -362,6 +646,10 @@ MotionComponent::mouseDrag (const juce::MouseEvent &event)
               auto const posHOA
                   = localToNormalized2DPosition (posPixelOffsetted);
               _engine.setChannel2DPosition (channel, posHOA);
+
+              // keep the snapshot current for disocclusion
+              if (channel < _blobPixels.size ())
+                _blobPixels[channel] = posPixelOffsetted;
             }
         }
     }
@@ -386,28 +674,7 @@ std::optional<index_t>
 MotionComponent::getClosestBlobIndexWithinRadius (juce::Point<float> posPixel,
                                                   float radiusPixel) const
 {
-  auto minDistance = std::numeric_limits<float>::infinity ();
-  auto minIndex = 0u;
-  for (auto channel = 0u; channel < _engine.getNumChannels (); ++channel)
-    {
-      auto const blobPos = _engine.getChannelPosition (channel);
-      if (!blobPos.isValid ())
-        continue;
-
-      auto const blobPosPixel = normalizedToLocal2DPosition (blobPos);
-      auto const distance = blobPosPixel.getDistanceFrom (posPixel);
-
-      if (distance < radiusPixel && distance < minDistance)
-        {
-          minDistance = distance;
-          minIndex = channel;
-        }
-    }
-
-  if (std::isfinite (minDistance))
-    return { minIndex };
-
-  return {};
+  return _blobGrid.findClosest (posPixel, radiusPixel);
 }
 
 float
@@ -423,6 +690,46 @@ MotionComponent::newOpenGLContextCreated ()
   using namespace juce::gl;
   glDebugMessageControl (GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER,
                          GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+
+  createShaders ();
+  createBuffers ();
+
+  _repaintRequested = true;
+}
+
+void
+MotionComponent::createShaders ()
+{
+  _shaderTextured = createShader (_glContext, vertexShaderTextured,
+                                  fragmentShaderTextured,
+                                  { { attributeCorner, "corner" } });
+  _shaderBlobs = createShader (_glContext, vertexShaderBlobs,
+                               fragmentShaderBlobs,
+                               { { attributeCorner, "corner" },
+                                 { attributeCentre, "centre" },
+                                 { attributeRadius, "radius" },
+                                 { attributeColour, "colour" } });
+  _shaderStroke = createShader (_glContext, vertexShaderStroke,
+                                fragmentShaderStroke,
+                                { { attributePosition, "position" } });
+}
+
+void
+MotionComponent::createBuffers ()
+{
+  using namespace juce::gl;
+
+  glGenVertexArrays (1, &_vertexArray);
+
+  // unit quad as triangle strip, shared by the textured and blob
+  // shaders which scale it to the required extents.
+  GLfloat const quad[] = { -1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f };
+  glGenBuffers (1, &_bufferQuad);
+  glBindBuffer (GL_ARRAY_BUFFER, _bufferQuad);
+  glBufferData (GL_ARRAY_BUFFER, sizeof (quad), quad, GL_STATIC_DRAW);
+
+  glGenBuffers (1, &_bufferBlobs);
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
 }
 
 void
@@ -434,57 +741,116 @@ MotionComponent::renderOpenGL ()
   jassert (OpenGLHelpers::isContextActive ());
   _glContext.setSwapInterval (1);
 
-  // printFrameTime ();
+  auto const frameStart = ClockT::now ();
 
   updateBoundsAndTransform ();
 
-  {
-    GLContextGraphics graphics (_glContext, //
-                                _boundsRender.getWidth (),
-                                _boundsRender.getHeight ());
+  _mutexBackgroundColour.lock ();
+  auto const backgroundColour{ _backgroundColour };
+  _mutexBackgroundColour.unlock ();
+  if (!_imageBackground.isValid ()
+      || backgroundColour != _backgroundColourRendered)
+    renderBackground (backgroundColour);
 
-    graphics.get ().addTransform (_transformNormalizedToLocal);
+  if (_shaderTextured == nullptr || _shaderBlobs == nullptr
+      || _shaderStroke == nullptr || !_imageBackground.isValid ())
+    {
+      OpenGLHelpers::clear (
+          Colours::background.overlaidWith (backgroundColour));
+      return;
+    }
 
-    _mutexBackgroundColour.lock ();
-    auto const backgroundColour{ _backgroundColour };
-    _mutexBackgroundColour.unlock ();
-    OpenGLHelpers::clear (Colours::background);
-    graphics.get ().setColour (backgroundColour);
-    graphics.get ().fillAll ();
+  glDisable (GL_DEPTH_TEST);
+  glDisable (GL_SCISSOR_TEST);
+  glEnable (GL_BLEND);
+  // all shaders output premultiplied alpha, like JUCE images do
+  glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  glBindVertexArray (_vertexArray);
 
-    drawCircle (graphics.get ());
-    drawChannelBlobs (graphics.get ());
+  // the opaque background covers the whole viewport, so there is no
+  // need to clear the frame before.
+  drawBackground ();
 
-    // create a copy of the shared_ptrs to hold the lock only briefly
-    _mutexPreview.lock ();
-    auto const patternsPreview{ _patternsPreview };
-    _mutexPreview.unlock ();
+  _sceneStatesRender.update ();
+  drawChannelBlobs (_sceneStatesRender.getReadBuffer ().channels);
 
-    for (auto &pattern : patternsPreview)
-      {
-        drawPatternPreview (*pattern, graphics.get ());
-      }
+  // create a copy of the shared_ptrs to hold the lock only briefly
+  _mutexPreview.lock ();
+  auto const patternsPreview{ _patternsPreview };
+  _mutexPreview.unlock ();
 
-    // auto constexpr blobSize = 2;
-    // auto blob = juce::Rectangle<float> (blobSize, blobSize);
-    // graphics.get ().fillEllipse (
-    //     blob.withCentre (juce::Point<float> (0.f, 0.f)));
-  }
+  // release the strokes of patterns that are no longer previewed
+  for (auto it = _previewStrokes.begin (); it != _previewStrokes.end ();)
+    {
+      if (patternsPreview.count (it->first) == 0)
+        {
+          glDeleteBuffers (1, &it->second.vertexBuffer);
+          it = _previewStrokes.erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+
+  for (auto &pattern : patternsPreview)
+    {
+      drawPatternPreview (pattern);
+    }
+
+  glBindVertexArray (0);
+
+  updateFramePacing (frameStart, ClockT::now ());
 }
 
 void
-MotionComponent::printFrameTime ()
+MotionComponent::updateFramePacing (ClockT::time_point frameStart,
+                                    ClockT::time_point frameEnd)
 {
-  static auto lastT = std::chrono::high_resolution_clock::now ();
+  auto &window = _framePacingWindow;
+
+  // intervals spanning an idle period say nothing about pacing
+  auto const interval = frameStart - _lastFrameStart;
+  if (window.numFrames > 0 && interval < framePacingWindow)
+    {
+      auto const intervalMs = toMilliseconds (interval);
+      window.intervalMeanMs += intervalMs;
+      window.intervalMaxMs = juce::jmax (window.intervalMaxMs, intervalMs);
+    }
+  _lastFrameStart = frameStart;
+
+  if (window.numFrames == 0)
+    _framePacingWindowStart = frameStart;
+
+  auto const renderMs = toMilliseconds (frameEnd - frameStart);
+  window.renderMeanMs += renderMs;
+  window.renderMaxMs = juce::jmax (window.renderMaxMs, renderMs);
+  ++window.numFrames;
+
+  if (frameEnd - _framePacingWindowStart < framePacingWindow)
+    return;
+
+  if (window.numFrames > 1)
+    window.intervalMeanMs /= float (window.numFrames - 1);
+  window.renderMeanMs /= float (window.numFrames);
+
+  DBG ("frames: " << window.numFrames << ", interval mean / max: "
+                  << window.intervalMeanMs << " / " << window.intervalMaxMs
+                  << " ms, render mean / max: " << window.renderMeanMs
+                  << " / " << window.renderMaxMs << " ms");
 
-  auto now = std::chrono::high_resolution_clock::now ();
-  auto deltaT
-      = std::chrono::duration_cast<std::chrono::microseconds> (now - lastT)
-            .count ()
-        / 1000.f;
-  lastT = now;
+  {
+    std::lock_guard<std::mutex> guard (_mutexFramePacingStats);
+    _framePacingStats = window;
+  }
+  window = {};
+}
 
-  juce::Logger::writeToLog ("frametime: " + juce::String (deltaT));
+MotionComponent::FramePacingStats
+MotionComponent::getFramePacingStats () const
+{
+  std::lock_guard<std::mutex> guard (_mutexFramePacingStats);
+  return _framePacingStats;
 }
 
 void
@@ -521,10 +887,58 @@ MotionComponent::renderBoundsChanged ()
   //                           "
   //                           + juce::String (_boundsRender.getHeight ()));
 
-  _imageBlend = std::make_unique<juce::Image> (
-      juce::Image::PixelFormat::ARGB,                        //
-      _boundsRender.getWidth (), _boundsRender.getHeight (), //
-      false, juce::OpenGLImageType ());
+  // re-rasterized at the new size before drawing the next frame
+  _imageBackground = {};
+}
+
+void
+MotionComponent::renderBackground (juce::Colour const &backgroundColour)
+{
+  using namespace juce::gl;
+
+  _imageBackground = {};
+  _backgroundColourRendered = backgroundColour;
+
+  auto const scale = float (_glContext.getRenderingScale ());
+  auto const width = juce::roundToInt (scale * _boundsRender.getWidth ());
+  auto const height = juce::roundToInt (scale * _boundsRender.getHeight ());
+  if (width <= 0 || height <= 0)
+    return;
+
+  // the JUCE renderer targets the image's frame buffer, make sure to
+  // restore the viewport of the main frame buffer afterwards.
+  GLint viewport[4];
+  glGetIntegerv (GL_VIEWPORT, viewport);
+
+  _imageBackground = juce::Image (juce::Image::PixelFormat::ARGB, width,
+                                  height, false, juce::OpenGLImageType ());
+  {
+    juce::Graphics g (_imageBackground);
+    g.addTransform (juce::AffineTransform::scale (scale));
+    g.fillAll (Colours::background);
+    g.fillAll (backgroundColour);
+
+    g.addTransform (_transformNormalizedToLocal);
+    drawCircle (g);
+  }
+
+  glViewport (viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void
+MotionComponent::setTransformUniform (juce::OpenGLShaderProgram &shader) const
+{
+  // maps normalized coordinates via local pixels to clip space
+  auto const width = float (_boundsRender.getWidth ());
+  auto const height = float (_boundsRender.getHeight ());
+  if (width <= 0.f || height <= 0.f)
+    return;
+
+  shader.setUniform ("transform",
+                     float (_boundsCenterRegion.getWidth ()) / width,
+                     -float (_boundsCenterRegion.getHeight ()) / height,
+                     2.f * _boundsCenterRegion.getCentreX () / width - 1.f,
+                     1.f - 2.f * _boundsCenterRegion.getCentreY () / height);
 }
 
 void
@@ -537,8 +951,9 @@ MotionComponent::drawCircle (juce::Graphics &g)
   auto const diameterHead = 2.f * reduceFactorHead;
   auto const boundsHead = juce::Rectangle<float> ().withSizeKeepingCentre (
       diameterHead, diameterHead);
-  _drawableHead->drawWithin (g, boundsHead, juce::RectanglePlacement::centred,
-                             opacityHead);
+  if (_drawableHead != nullptr)
+    _drawableHead->drawWithin (g, boundsHead,
+                               juce::RectanglePlacement::centred, opacityHead);
 
   auto const diameterCircle = 2.f;
   auto const boundsCircle = juce::Rectangle<float> ().withSizeKeepingCentre (
@@ -552,149 +967,300 @@ MotionComponent::drawCircle (juce::Graphics &g)
 }
 
 void
-MotionComponent::drawChannelBlobs (juce::Graphics &g)
+MotionComponent::drawBackground ()
 {
   using namespace juce::gl;
 
-  _imageBlend->clear (_imageBlend->getBounds ());
+  auto const *frameBuffer
+      = juce::OpenGLImageType::getFrameBufferFrom (_imageBackground);
+  if (frameBuffer == nullptr)
+    return;
 
-  {
-    juce::Graphics gFBO{ *_imageBlend };
-    gFBO.addTransform (_transformNormalizedToLocal);
+  // the background fills the viewport, so the quad corners map to
+  // clip space directly.
+  _shaderTextured->use ();
+  _shaderTextured->setUniform ("transform", 1.f, -1.f, 0.f, 0.f);
+  _shaderTextured->setUniform ("extent", 1.f);
+  _shaderTextured->setUniform ("opacity", 1.f);
+  _shaderTextured->setUniform ("image", 0);
 
-    for (auto channel = 0u; channel < _engine.getNumChannels (); ++channel)
-      {
-        auto const position = _engine.getChannelPosition (channel);
-        if (!position.isValid ())
-          continue;
-
-        auto blobSize = 2 * reduceFactorBlobs;
-        blobSize *= (1.f + std::clamp (position.z (), 0.f, 1.f) * 0.7f);
-
-        auto const blob
-            = juce::Rectangle<float> (0.f, 0.f, blobSize, blobSize);
-        auto const blobGrabbed
-            = juce::Rectangle<float> (0.f, 0.f, //
-                                      blobSize * activeAreaAroundBlobFactor,
-                                      blobSize * activeAreaAroundBlobFactor);
-        auto const blobHighlight = juce::Rectangle<float> (
-            0.f, 0.f, //
-            blobSize * blobHighlightFactor, blobSize * blobHighlightFactor);
-
-        auto posScreenNormalized = cartesian2DHOA2JUCE (position);
-
-        auto colour = _uiStates[channel]->colour;
-
-        // DBG (juce::String ("drawing at position: ")
-        //      + juce::String (pos.getX ()) + " " + juce::String (pos.getY
-        //      ()));
-
-        if (_uiStates[channel]->grabbed)
-          {
-            gFBO.setColour (colour.withAlpha (0.4f));
-            gFBO.fillEllipse (blobGrabbed.withCentre (posScreenNormalized));
-          }
-
-        if (_uiStates[channel]->highlighted)
-          {
-            gFBO.setColour (
-                colour.withLightness (colour.getLightness () + 0.2f));
-            gFBO.fillEllipse (blobHighlight.withCentre (posScreenNormalized));
-          }
-
-        // debug: draw anchor
-        // gFBO.setColour (colour.withAlpha (0.4f));
-        // gFBO.fillEllipse (
-        //     blob.withCentre (_uiStates[channelIndex]->posAnchor));
-        gFBO.setColour (colour);
-        gFBO.fillEllipse (blob.withCentre (posScreenNormalized));
-
-        // draw width indicator
-        // auto const width = _engine.getChannelWidth (channel);
-        // auto const posL
-        //     = Pos::fromSpherical (position.azimuth () - width,
-        //                           position.elevation (), position.distance
-        //                           ());
-        // auto const posR
-        //     = Pos::fromSpherical (position.azimuth () + width,
-        //                           position.elevation (), position.distance
-        //                           ());
-
-        // auto const posLNormalized = cartesian2DHOA2JUCE (posL);
-        // auto const posRNormalized = cartesian2DHOA2JUCE (posR);
-
-        // gFBO.setColour (juce::Colours::white);
-        // gFBO.fillEllipse (blob.withCentre (posLNormalized));
-        // gFBO.setColour (juce::Colours::red);
-        // gFBO.fillEllipse (blob.withCentre (posRNormalized));
-      }
-  }
+  glActiveTexture (GL_TEXTURE0);
+  glBindTexture (GL_TEXTURE_2D, frameBuffer->getTextureID ());
 
-  g.setOpacity (0.8f);
-  g.drawImage (*_imageBlend, _boundsRender.toFloat ().transformedBy (
-                                 _transformNormalizedToLocal.inverted ()));
-  g.setOpacity (1.f);
+  glBindBuffer (GL_ARRAY_BUFFER, _bufferQuad);
+  glVertexAttribPointer (attributeCorner, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glEnableVertexAttribArray (attributeCorner);
+
+  glDrawArrays (GL_TRIANGLE_STRIP, 0, 4);
+
+  glDisableVertexAttribArray (attributeCorner);
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
+  glBindTexture (GL_TEXTURE_2D, 0);
 }
 
 void
-MotionComponent::drawPatternPreview (Pattern const &pattern, juce::Graphics &g)
+MotionComponent::drawChannelBlobs (
+    std::vector<SceneState::Channel> const &channels)
 {
-  auto ticks = pattern.getTicks ();
+  using namespace juce::gl;
+
+  auto constexpr opacityBlobs = 0.8f;
+
+  _blobInstances.clear ();
+  auto const addBlob = [this] (juce::Point<float> centre, float diameter,
+                               juce::Colour colour) {
+    _blobInstances.push_back ({ { centre.x, centre.y },
+                                diameter / 2.f,
+                                { colour.getFloatRed (),
+                                  colour.getFloatGreen (),
+                                  colour.getFloatBlue (),
+                                  colour.getFloatAlpha () * opacityBlobs } });
+  };
 
-  auto constexpr lineThickness = 0.04f;
+  for (auto const &channel : channels)
+    {
+      auto const &position = channel.position;
+      if (!position.isValid ())
+        continue;
 
-  auto colour = _uiStates[pattern.getChannel ()]->colour;
-  g.setColour (colour.withAlpha (0.6f));
-  auto const strokeStyle = juce::PathStrokeType (
-      lineThickness, juce::PathStrokeType::JointStyle::curved,
-      juce::PathStrokeType::EndCapStyle::rounded);
-  auto path = juce::Path ();
+      auto blobSize = 2 * reduceFactorBlobs;
+      blobSize *= (1.f + std::clamp (position.z (), 0.f, 1.f) * 0.7f);
 
-  jassert (ticks.positions.size () <= std::numeric_limits<int>::max ());
-  path.preallocateSpace (static_cast<int> (ticks.positions.size ()));
+      auto posScreenNormalized = cartesian2DHOA2JUCE (position);
 
-  auto hasStarted = false;
-  for (auto offset = 0u; offset < ticks.positions.size (); ++offset)
+      auto const colour = channel.colour;
+
+      // instances are drawn in order, so the blob itself comes last
+      if (channel.grabbed)
+        addBlob (posScreenNormalized, blobSize * activeAreaAroundBlobFactor,
+                 colour.withAlpha (0.4f));
+
+      if (channel.highlighted)
+        addBlob (posScreenNormalized, blobSize * blobHighlightFactor,
+                 colour.withLightness (colour.getLightness () + 0.2f));
+
+      addBlob (posScreenNormalized, blobSize, colour);
+    }
+
+  if (_blobInstances.empty ())
+    return;
+
+  _shaderBlobs->use ();
+  setTransformUniform (*_shaderBlobs);
+
+  glBindBuffer (GL_ARRAY_BUFFER, _bufferQuad);
+  glVertexAttribPointer (attributeCorner, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glEnableVertexAttribArray (attributeCorner);
+
+  glBindBuffer (GL_ARRAY_BUFFER, _bufferBlobs);
+  glBufferData (GL_ARRAY_BUFFER,
+                GLsizeiptr (_blobInstances.size () * sizeof (BlobInstance)),
+                _blobInstances.data (), GL_STREAM_DRAW);
+
+  auto const setInstanceAttribute
+      = [] (GLuint location, GLint size, std::size_t offset) {
+          glVertexAttribPointer (location, size, GL_FLOAT, GL_FALSE,
+                                 GLsizei (sizeof (BlobInstance)),
+                                 reinterpret_cast<void const *> (offset));
+          glVertexAttribDivisor (location, 1);
+          glEnableVertexAttribArray (location);
+        };
+  setInstanceAttribute (attributeCentre, 2, offsetof (BlobInstance, centre));
+  setInstanceAttribute (attributeRadius, 1, offsetof (BlobInstance, radius));
+  setInstanceAttribute (attributeColour, 4, offsetof (BlobInstance, colour));
+
+  glDrawArraysInstanced (GL_TRIANGLE_STRIP, 0, 4,
+                         GLsizei (_blobInstances.size ()));
+
+  for (auto location : { attributeCentre, attributeRadius, attributeColour })
     {
-      auto const indexWrapped
-          = (ticks.lastUpdatedTick + 1 + offset) % ticks.positions.size ();
-      auto const tick = ticks.positions[indexWrapped];
+      glVertexAttribDivisor (location, 0);
+      glDisableVertexAttribArray (location);
+    }
+  glDisableVertexAttribArray (attributeCorner);
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
+}
 
-      if (tick.isValid ())
-        {
-          auto posNormalized = cartesian2DHOA2JUCE (tick);
-          if (!hasStarted)
-            {
-              path.startNewSubPath (posNormalized);
-              hasStarted = true;
-            }
-          path.lineTo (posNormalized);
-        }
-      else
-        {
-          if (hasStarted)
-            {
-              if (path.getLength () > lineThickness)
-                {
-                  g.strokePath (path, strokeStyle);
-                }
-              else
-                {
-                  auto ellipse = juce::Rectangle<float> ();
-                  auto constexpr sizeEllipse = lineThickness * 2.f;
-                  ellipse.setSize (sizeEllipse, sizeEllipse);
-                  g.fillEllipse (
-                      ellipse.withCentre (path.getCurrentPosition ()));
-                }
-              path.clear ();
-              hasStarted = false;
-            }
-        }
+void
+MotionComponent::drawPatternPreview (std::shared_ptr<Pattern> const &pattern)
+{
+  using namespace juce::gl;
+
+  auto &stroke = _previewStrokes[pattern];
+  if (stroke.version != pattern->getVersion ())
+    updatePreviewStroke (*pattern, stroke);
+
+  if (stroke.strips.empty ())
+    return;
+
+  auto const colour = _uiStates[pattern->getChannel ()]->colour.withAlpha (
+      0.6f);
+
+  _shaderStroke->use ();
+  setTransformUniform (*_shaderStroke);
+  auto const alpha = colour.getFloatAlpha ();
+  _shaderStroke->setUniform ("colour", colour.getFloatRed () * alpha,
+                             colour.getFloatGreen () * alpha,
+                             colour.getFloatBlue () * alpha, alpha);
+
+  glBindBuffer (GL_ARRAY_BUFFER, stroke.vertexBuffer);
+  glVertexAttribPointer (attributePosition, 2, GL_FLOAT, GL_FALSE, 0,
+                         nullptr);
+  glEnableVertexAttribArray (attributePosition);
+
+  for (auto const &[first, count] : stroke.strips)
+    glDrawArrays (GL_TRIANGLE_STRIP, first, count);
+
+  glDisableVertexAttribArray (attributePosition);
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+void
+MotionComponent::updatePreviewStroke (Pattern const &pattern,
+                                      PreviewStroke &stroke)
+{
+  using namespace juce::gl;
+
+  // only copies the ticks recorded since the last update
+  auto const dirty = pattern.getDirtyTicks (stroke.version, _ticksDirty);
+  stroke.version = dirty.version;
+
+  if (dirty.complete)
+    stroke.ticks.assign (dirty.numTicks, Pos::invalid);
+
+  // appending is only possible while no recorded ticks are
+  // overwritten, which would have to be removed from the stroke.
+  auto rebuild = dirty.complete;
+  auto const numTicksTotal = stroke.ticks.size ();
+  for (auto offset = 0u; offset < dirty.numTicks; ++offset)
+    {
+      auto &tick = stroke.ticks[(dirty.firstTick + offset) % numTicksTotal];
+      rebuild = rebuild || tick.isValid ();
+      tick = _ticksDirty[offset];
     }
-  if (hasStarted)
+
+  if (rebuild)
     {
-      g.strokePath (path, strokeStyle);
+      stroke.vertices.clear ();
+      stroke.strips.clear ();
+      stroke.pointsOpen.clear ();
+      stroke.firstVertexDirty = 0;
+
+      // start after the last updated tick so the stroke has its gap
+      // at the recording position.
+      auto const firstTick
+          = numTicksTotal > 0
+                ? (dirty.firstTick + dirty.numTicks) % numTicksTotal
+                : 0;
+      for (auto offset = 0u; offset < numTicksTotal; ++offset)
+        appendPreviewTick (
+            stroke, stroke.ticks[(firstTick + offset) % numTicksTotal]);
     }
+  else
+    {
+      for (auto const &tick : _ticksDirty)
+        appendPreviewTick (stroke, tick);
+    }
+
+  if (stroke.vertexBuffer == 0)
+    glGenBuffers (1, &stroke.vertexBuffer);
+  glBindBuffer (GL_ARRAY_BUFFER, stroke.vertexBuffer);
+
+  auto constexpr vertexSize = sizeof (juce::Point<float>);
+  if (stroke.vertices.size () > stroke.bufferCapacity)
+    {
+      // grow geometrically so recording reallocates only rarely
+      stroke.bufferCapacity = 2 * stroke.vertices.size ();
+      glBufferData (GL_ARRAY_BUFFER,
+                    GLsizeiptr (stroke.bufferCapacity * vertexSize), nullptr,
+                    GL_DYNAMIC_DRAW);
+      stroke.firstVertexDirty = 0;
+    }
+
+  if (stroke.firstVertexDirty < stroke.vertices.size ())
+    glBufferSubData (
+        GL_ARRAY_BUFFER, GLintptr (stroke.firstVertexDirty * vertexSize),
+        GLsizeiptr ((stroke.vertices.size () - stroke.firstVertexDirty)
+                    * vertexSize),
+        stroke.vertices.data () + stroke.firstVertexDirty);
+  stroke.firstVertexDirty = stroke.vertices.size ();
+
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+void
+MotionComponent::appendPreviewTick (PreviewStroke &stroke, Pos const &tick)
+{
+  using namespace juce::gl;
+
+  auto constexpr halfWidth = previewLineThickness / 2.f;
+  auto constexpr minimumDistance = 1e-5f;
+
+  auto &points = stroke.pointsOpen;
+  auto &vertices = stroke.vertices;
+
+  if (!tick.isValid ())
+    {
+      // the open strip ends here, its geometry is already complete
+      points.clear ();
+      return;
+    }
+
+  auto const position = cartesian2DHOA2JUCE (tick);
+  if (points.empty ())
+    {
+      stroke.strips.emplace_back (GLint (vertices.size ()), 0);
+      stroke.lengthOpen = 0.f;
+    }
+  else
+    {
+      auto const distance = points.back ().getDistanceFrom (position);
+      if (distance < minimumDistance)
+        return;
+      stroke.lengthOpen += distance;
+    }
+
+  auto const wasLine = points.size () >= 2
+                       && stroke.lengthOpen
+                              - points.back ().getDistanceFrom (position)
+                              > previewLineThickness;
+  points.push_back (position);
+
+  auto &[first, count] = stroke.strips.back ();
+  auto const firstVertex = std::size_t (first);
+
+  if (wasLine)
+    {
+      // re-extrude the former end point with the new segment and
+      // append the new end point
+      auto const last = points.size () - 1;
+      auto const [left, right] = extrudeLinePoint (
+          &points[last - 2], points[last - 1], &points[last], halfWidth);
+      vertices[vertices.size () - 2] = left;
+      vertices[vertices.size () - 1] = right;
+      stroke.firstVertexDirty
+          = std::min (stroke.firstVertexDirty, vertices.size () - 2);
+
+      auto const [leftEnd, rightEnd] = extrudeLinePoint (
+          &points[last - 1], points[last], nullptr, halfWidth);
+      vertices.push_back (leftEnd);
+      vertices.push_back (rightEnd);
+    }
+  else
+    {
+      // short strokes are drawn as a dot until they become long
+      // enough, re-tessellate the whole strip until then.
+      vertices.resize (firstVertex);
+      stroke.firstVertexDirty
+          = std::min (stroke.firstVertexDirty, firstVertex);
+
+      if (stroke.lengthOpen <= previewLineThickness)
+        appendDotStrip (points.back (), previewLineThickness, vertices);
+      else
+        appendLineStrip (points, halfWidth, vertices);
+    }
+
+  count = GLsizei (vertices.size () - firstVertex);
 }
 
 juce::Point<float>
@@ -715,7 +1281,24 @@ MotionComponent::localToNormalized2DPosition (
 void
 MotionComponent::openGLContextClosing ()
 {
+  using namespace juce::gl;
+
   DBG ("openGLContextClosing");
+
+  for (auto &[pattern, stroke] : _previewStrokes)
+    glDeleteBuffers (1, &stroke.vertexBuffer);
+  _previewStrokes.clear ();
+
+  glDeleteBuffers (1, &_bufferBlobs);
+  glDeleteBuffers (1, &_bufferQuad);
+  glDeleteVertexArrays (1, &_vertexArray);
+  _bufferBlobs = _bufferQuad = _vertexArray = 0;
+
+  _imageBackground = {};
+
+  _shaderTextured = nullptr;
+  _shaderBlobs = nullptr;
+  _shaderStroke = nullptr;
 }
 
 }
@@ -22,16 +22,19 @@
 
 #include <JuceHeader.h>
 
+#include <a3-motion-engine/EngineSnapshot.hh>
 #include <a3-motion-engine/Measure.hh>
+#include <a3-motion-engine/Pattern.hh>
+#include <a3-motion-engine/util/TripleBuffer.hh>
 #include <a3-motion-engine/util/Types.hh>
 
 #include <a3-motion-ui/Helpers.hh>
+#include <a3-motion-ui/components/SpatialGrid.hh>
 
 namespace a3
 {
 
 class MotionEngine;
-class Pattern;
 class ChannelUIState;
 
 class MotionComponent : public juce::Component,
@@ -62,16 +65,106 @@ public:
 
   void setBackgroundColour (juce::Colour const &colour);
 
+  /* Frame pacing of the GL renderer, aggregated over one second of
+   * rendering. Frames are only rendered when the scene changes, so
+   * the frame rate drops to zero while idle.
+   */
+  struct FramePacingStats
+  {
+    int numFrames = 0;
+    float intervalMeanMs = 0.f;
+    float intervalMaxMs = 0.f;
+    float renderMeanMs = 0.f;
+    float renderMaxMs = 0.f;
+  };
+  FramePacingStats getFramePacingStats () const;
+
 private:
-  void printFrameTime ();
+  /* Everything a rendered frame depends on. The timer compares the
+   * current state against the last rendered one and triggers a
+   * repaint of the GL context only on changes.
+   */
+  struct SceneState
+  {
+    struct Channel
+    {
+      Pos position;
+      juce::Colour colour;
+      bool highlighted;
+      bool grabbed;
+    };
+    struct Preview
+    {
+      Pattern const *pattern;
+      std::uint64_t version;
+      Pattern::Status status;
+    };
+
+    std::vector<Channel> channels;
+    std::vector<Preview> previews;
+    juce::Colour backgroundColour;
+    juce::Rectangle<int> bounds;
+
+    bool operator== (SceneState const &other) const;
+  };
+
+  void captureSceneState (SceneState &state);
+  void repaintIfSceneChanged ();
+
+  using ClockT = std::chrono::steady_clock;
+  void updateFramePacing (ClockT::time_point frameStart,
+                          ClockT::time_point frameEnd);
+
   void updateBoundsAndTransform ();
   void renderBoundsChanged ();
 
   void updateChannelBlobHighlight (juce::Point<float> posMousePixel);
 
+  /* Per-instance attributes of the blob shader, positions and radii
+   * are given in normalized coordinates.
+   */
+  struct BlobInstance
+  {
+    float centre[2];
+    float radius;
+    float colour[4];
+  };
+
+  /* Tessellated stroke of a previewed pattern. While recording, only
+   * the newly recorded ticks are tessellated and uploaded.
+   */
+  struct PreviewStroke
+  {
+    std::uint64_t version = std::numeric_limits<std::uint64_t>::max ();
+
+    // copy of the pattern ticks
+    std::vector<Pos> ticks;
+
+    std::vector<juce::Point<float> > vertices;
+    // first vertex and number of vertices of each triangle strip
+    std::vector<std::pair<juce::gl::GLint, juce::gl::GLsizei> > strips;
+
+    // points and length of the last strip while it can be extended
+    std::vector<juce::Point<float> > pointsOpen;
+    float lengthOpen = 0.f;
+
+    juce::gl::GLuint vertexBuffer = 0;
+    std::size_t bufferCapacity = 0;
+    std::size_t firstVertexDirty = 0;
+  };
+
+  void createShaders ();
+  void createBuffers ();
+  void setTransformUniform (juce::OpenGLShaderProgram &shader) const;
+
+  void renderBackground (juce::Colour const &backgroundColour);
   void drawCircle (juce::Graphics &g);
-  void drawChannelBlobs (juce::Graphics &g);
-  void drawPatternPreview (Pattern const &pattern, juce::Graphics &g);
+
+  void drawBackground ();
+  void drawChannelBlobs (std::vector<SceneState::Channel> const &channels);
+  void drawPatternPreview (std::shared_ptr<Pattern> const &pattern);
+  void updatePreviewStroke (Pattern const &pattern, PreviewStroke &stroke);
+  void appendPreviewTick (PreviewStroke &stroke, Pos const &tick);
 
   float getActiveDistanceInPixel () const;
 
@@ -82,6 +175,9 @@ private:
   getClosestBlobIndexWithinRadius (juce::Point<float> posPixel,
                                    float radiusPixel) const;
 
+  // snapshot of the blob pixel positions for hit-testing and
+  // disocclusion, refreshed at most once per frame unless forced
+  void updateBlobSnapshot (bool force);
   void disoccludeBlobs ();
 
   MotionEngine &_engine;
@@ -89,6 +185,15 @@ private:
   std::vector<std::unique_ptr<ChannelUIState> > &_uiStates;
   std::optional<index_t> _grabbedIndex;
 
+  // engine state of the current UI event, accessed by the UI thread
+  // only
+  EngineSnapshot _engineSnapshot;
+
+  // accessed by the UI thread only, invalid positions are NaN
+  std::vector<juce::Point<float> > _blobPixels;
+  SpatialGrid _blobGrid;
+  std::vector<index_t> _blobsOccluded;
+
   std::set<std::shared_ptr<Pattern> > _patternsPreview;
   std::mutex _mutexPreview;
 
@@ -106,12 +211,46 @@ private:
   juce::Rectangle<int> _boundsCenterRegion;
   juce::AffineTransform _transformNormalizedToLocal;
 
-  std::unique_ptr<juce::Image> _imageBlend;
   juce::Image _imageIsoSphere;
   std::unique_ptr<juce::Drawable> _drawableHead;
 
+  // GL resources, only accessed from the GL renderer thread
+  std::unique_ptr<juce::OpenGLShaderProgram> _shaderTextured;
+  std::unique_ptr<juce::OpenGLShaderProgram> _shaderBlobs;
+  std::unique_ptr<juce::OpenGLShaderProgram> _shaderStroke;
+  juce::gl::GLuint _vertexArray = 0;
+  juce::gl::GLuint _bufferQuad = 0;
+  juce::gl::GLuint _bufferBlobs = 0;
+
+  // head, iso-sphere and background colour, rasterized in the GL
+  // thread whenever the bounds or the background colour change
+  juce::Image _imageBackground;
+  juce::Colour _backgroundColourRendered;
+
+  std::vector<BlobInstance> _blobInstances;
+  std::map<std::shared_ptr<Pattern>, PreviewStroke> _previewStrokes;
+  std::vector<Pos> _ticksDirty;
+
   juce::Colour _backgroundColour;
   std::mutex _mutexBackgroundColour;
+
+  // accessed by the UI thread only
+  SceneState _sceneState;
+  SceneState _sceneStateRendered;
+  // the scene state that triggered the last repaint, handed over to
+  // the GL renderer thread so a frame never mixes engine states
+  TripleBuffer<SceneState> _sceneStatesRender;
+  ClockT::time_point _blobSnapshotTime;
+  // forces a repaint independent of the scene, e.g. for a new context
+  std::atomic<bool> _repaintRequested = true;
+
+  // accessed by the GL renderer thread only
+  ClockT::time_point _lastFrameStart;
+  ClockT::time_point _framePacingWindowStart;
+  FramePacingStats _framePacingWindow;
+
+  FramePacingStats _framePacingStats;
+  mutable std::mutex _mutexFramePacingStats;
 };
 
 }
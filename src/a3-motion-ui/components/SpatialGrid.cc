@@ -0,0 +1,119 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpatialGrid.hh"
+
+#include <cmath>
+#include <limits>
+
+namespace a3
+{
+
+void
+SpatialGrid::build (std::vector<juce::Point<float> > const &points,
+                    float cellSize)
+{
+  _points = points;
+  _entries.clear ();
+  _cellStart.clear ();
+
+  auto boundsMin = juce::Point<float> (std::numeric_limits<float>::max (),
+                                       std::numeric_limits<float>::max ());
+  auto boundsMax = juce::Point<float> (std::numeric_limits<float>::lowest (),
+                                       std::numeric_limits<float>::lowest ());
+  auto numPoints = 0u;
+  for (auto const &point : _points)
+    {
+      if (!point.isFinite ())
+        continue;
+      boundsMin = { juce::jmin (boundsMin.x, point.x),
+                    juce::jmin (boundsMin.y, point.y) };
+      boundsMax = { juce::jmax (boundsMax.x, point.x),
+                    juce::jmax (boundsMax.y, point.y) };
+      ++numPoints;
+    }
+
+  if (numPoints == 0)
+    return;
+
+  auto const extent = boundsMax - boundsMin;
+  _origin = boundsMin;
+  _cellSize = juce::jmax (cellSize, 1e-3f,
+                          juce::jmax (extent.x, extent.y) / maxCellsPerAxis);
+  _numCellsX = int (extent.x / _cellSize) + 1;
+  _numCellsY = int (extent.y / _cellSize) + 1;
+
+  // counting sort of the points into their cells
+  _cellStart.assign (std::size_t (_numCellsX * _numCellsY) + 1, 0);
+  _cellOfPoint.resize (_points.size ());
+  for (auto index = 0u; index < _points.size (); ++index)
+    {
+      if (!_points[index].isFinite ())
+        {
+          _cellOfPoint[index] = -1;
+          continue;
+        }
+      auto const cell = getCell (_points[index]);
+      _cellOfPoint[index] = cell.y * _numCellsX + cell.x;
+      ++_cellStart[std::size_t (_cellOfPoint[index]) + 1];
+    }
+
+  for (auto cell = 1u; cell < _cellStart.size (); ++cell)
+    _cellStart[cell] += _cellStart[cell - 1];
+
+  _entries.resize (numPoints);
+  auto cellFill = _cellStart;
+  for (auto index = 0u; index < _points.size (); ++index)
+    if (_cellOfPoint[index] >= 0)
+      _entries[cellFill[std::size_t (_cellOfPoint[index])]++] = index;
+}
+
+std::optional<index_t>
+SpatialGrid::findClosest (juce::Point<float> position, float radius) const
+{
+  std::optional<index_t> closest;
+  auto minDistance = std::numeric_limits<float>::infinity ();
+  forEachWithinRadius (position, radius,
+                       [&] (index_t index, float distance) {
+                         if (distance < minDistance)
+                           {
+                             minDistance = distance;
+                             closest = index;
+                           }
+                       });
+  return closest;
+}
+
+juce::Point<int>
+SpatialGrid::getCell (juce::Point<float> position) const
+{
+  auto const cell = (position - _origin) / _cellSize;
+  return { juce::jlimit (0, _numCellsX - 1, int (std::floor (cell.x))),
+           juce::jlimit (0, _numCellsY - 1, int (std::floor (cell.y))) };
+}
+
+std::pair<juce::Point<int>, juce::Point<int> >
+SpatialGrid::getCellRange (juce::Point<float> position, float radius) const
+{
+  return { getCell (position - juce::Point<float> (radius, radius)),
+           getCell (position + juce::Point<float> (radius, radius)) };
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <JuceHeader.h>
+
+#include <a3-motion-engine/util/Types.hh>
+
+namespace a3
+{
+
+/* Uniform grid over a set of 2D points for radius queries, e.g. for
+ * hit-testing the channel blobs. The grid is rebuilt from scratch
+ * whenever the points change, which is cheap for the point counts we
+ * deal with and does not allocate once the number of points settles.
+ * Points with non-finite coordinates are ignored. Queries are cheapest
+ * when the cell size matches the typical query radius.
+ */
+class SpatialGrid
+{
+public:
+  void build (std::vector<juce::Point<float> > const &points, float cellSize);
+
+  // closest point with a distance below the radius
+  std::optional<index_t> findClosest (juce::Point<float> position,
+                                      float radius) const;
+
+  // calls callback (index, distance) for all points with a distance
+  // below the radius
+  template <typename Callback>
+  void
+  forEachWithinRadius (juce::Point<float> position, float radius,
+                       Callback &&callback) const
+  {
+    if (_entries.empty ())
+      return;
+
+    auto const [cellMin, cellMax] = getCellRange (position, radius);
+    for (auto cellY = cellMin.y; cellY <= cellMax.y; ++cellY)
+      for (auto cellX = cellMin.x; cellX <= cellMax.x; ++cellX)
+        {
+          auto const cell = std::size_t (cellY * _numCellsX + cellX);
+          for (auto entry = _cellStart[cell]; entry < _cellStart[cell + 1];
+               ++entry)
+            {
+              auto const index = _entries[entry];
+              auto const distance = _points[index].getDistanceFrom (position);
+              if (distance < radius)
+                callback (index, distance);
+            }
+        }
+  }
+
+private:
+  juce::Point<int> getCell (juce::Point<float> position) const;
+  std::pair<juce::Point<int>, juce::Point<int> >
+  getCellRange (juce::Point<float> position, float radius) const;
+
+  // bounds the memory for sparse, widely spread point sets
+  static constexpr int maxCellsPerAxis = 64;
+
+  juce::Point<float> _origin;
+  float _cellSize = 1.f;
+  int _numCellsX = 0;
+  int _numCellsY = 0;
+
+  std::vector<juce::Point<float> > _points;
+  // point indices sorted by cell, the entries of a cell start at
+  // _cellStart[cell] and end before _cellStart[cell + 1]
+  std::vector<index_t> _entries;
+  std::vector<index_t> _cellStart;
+  std::vector<int> _cellOfPoint;
+};
+
+}
@@ -0,0 +1,298 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ControllerProtocol.hh"
+
+#include <algorithm>
+
+namespace a3
+{
+
+namespace
+{
+
+using Packet = ControllerProtocol::Packet;
+using PacketType = ControllerProtocol::PacketType;
+
+Packet
+makePacket (PacketType type, std::initializer_list<std::uint8_t> payload)
+{
+  Packet packet;
+  packet.type = type;
+  packet.payloadSize = payload.size ();
+  std::copy (payload.begin (), payload.end (), packet.payload.begin ());
+  return packet;
+}
+
+void
+writeUint16 (std::uint16_t value, std::uint8_t *data)
+{
+  data[0] = static_cast<std::uint8_t> (value);
+  data[1] = static_cast<std::uint8_t> (value >> 8);
+}
+
+std::size_t
+getPayloadSize (PacketType type)
+{
+  switch (type)
+    {
+    case PacketType::Button:
+    case PacketType::EncoderPress:
+    case PacketType::EncoderIncrement:
+      return 2;
+    case PacketType::Pot:
+      return 3;
+    case PacketType::Tap:
+      return 8;
+    case PacketType::PadLEDFrame:
+      return ControllerProtocol::maxPayloadSize;
+    case PacketType::ButtonLEDs:
+      return 1;
+    }
+  return 0;
+}
+
+bool
+isValidPayload (Packet const &packet)
+{
+  auto const &payload = packet.payload;
+  auto const isPressValue = payload[1] == 0 || payload[1] == 1;
+  switch (packet.type)
+    {
+    case PacketType::Button:
+      return payload[0] < ControllerProtocol::numButtons && isPressValue;
+    case PacketType::EncoderPress:
+      return payload[0] < ControllerProtocol::numEncoders && isPressValue;
+    case PacketType::EncoderIncrement:
+      return payload[0] < ControllerProtocol::numEncoders && payload[1] != 0;
+    case PacketType::Pot:
+      return payload[0] < ControllerProtocol::numPots
+             && ControllerProtocol::readUint16 (payload.data () + 1)
+                    <= ControllerProtocol::potMaxValue;
+    case PacketType::ButtonLEDs:
+      return payload[0] < (1 << ControllerProtocol::numButtonLEDs);
+    case PacketType::Tap:
+    case PacketType::PadLEDFrame:
+      return true;
+    }
+  return false;
+}
+
+}
+
+Packet
+ControllerProtocol::makeButton (int index, bool pressed)
+{
+  return makePacket (PacketType::Button,
+                     { static_cast<std::uint8_t> (index),
+                       static_cast<std::uint8_t> (pressed) });
+}
+
+Packet
+ControllerProtocol::makeEncoderPress (int index, bool pressed)
+{
+  return makePacket (PacketType::EncoderPress,
+                     { static_cast<std::uint8_t> (index),
+                       static_cast<std::uint8_t> (pressed) });
+}
+
+Packet
+ControllerProtocol::makeEncoderIncrement (int index, int increment)
+{
+  return makePacket (PacketType::EncoderIncrement,
+                     { static_cast<std::uint8_t> (index),
+                       static_cast<std::uint8_t> (increment) });
+}
+
+Packet
+ControllerProtocol::makePot (int index, int value)
+{
+  auto packet = makePacket (PacketType::Pot,
+                            { static_cast<std::uint8_t> (index), 0, 0 });
+  writeUint16 (static_cast<std::uint16_t> (value), &packet.payload[1]);
+  return packet;
+}
+
+Packet
+ControllerProtocol::makeTap (std::uint64_t timeMicros)
+{
+  Packet packet;
+  packet.type = PacketType::Tap;
+  packet.payloadSize = 8;
+  for (auto index = 0u; index < 8; ++index)
+    packet.payload[index]
+        = static_cast<std::uint8_t> (timeMicros >> (8 * index));
+  return packet;
+}
+
+Packet
+ControllerProtocol::makeButtonLEDs (std::uint8_t mask)
+{
+  return makePacket (PacketType::ButtonLEDs, { mask });
+}
+
+Packet
+ControllerProtocol::makePadLEDFrame (std::uint8_t const *rgb)
+{
+  Packet packet;
+  packet.type = PacketType::PadLEDFrame;
+  packet.payloadSize = maxPayloadSize;
+  std::copy (rgb, rgb + maxPayloadSize, packet.payload.begin ());
+  return packet;
+}
+
+std::uint16_t
+ControllerProtocol::readUint16 (std::uint8_t const *data)
+{
+  return static_cast<std::uint16_t> (data[0] | data[1] << 8);
+}
+
+std::uint64_t
+ControllerProtocol::readUint64 (std::uint8_t const *data)
+{
+  std::uint64_t value = 0;
+  for (auto index = 0u; index < 8; ++index)
+    value |= std::uint64_t (data[index]) << (8 * index);
+  return value;
+}
+
+std::size_t
+ControllerProtocol::encodeFrame (Packet const &packet, Frame &frame)
+{
+  std::array<std::uint8_t, maxPacketSize> raw;
+  raw[0] = version;
+  raw[1] = static_cast<std::uint8_t> (packet.type);
+  std::copy_n (packet.payload.begin (), packet.payloadSize, raw.begin () + 2);
+  auto const size = packet.payloadSize + 2;
+  writeUint16 (crc16 (raw.data (), size), raw.data () + size);
+
+  auto const encodedSize = cobsEncode (raw.data (), size + 2, frame.data ());
+  frame[encodedSize] = 0;
+  return encodedSize + 1;
+}
+
+std::optional<Packet>
+ControllerProtocol::decodePacket (std::uint8_t const *data, std::size_t size)
+{
+  if (size < 4 || size > maxPacketSize || data[0] != version)
+    return std::nullopt;
+
+  if (crc16 (data, size - 2) != readUint16 (data + size - 2))
+    return std::nullopt;
+
+  Packet packet;
+  packet.type = static_cast<PacketType> (data[1]);
+  packet.payloadSize = size - 4;
+  if (getPayloadSize (packet.type) != packet.payloadSize)
+    return std::nullopt;
+
+  std::copy_n (data + 2, packet.payloadSize, packet.payload.begin ());
+  if (!isValidPayload (packet))
+    return std::nullopt;
+
+  return packet;
+}
+
+std::uint16_t
+ControllerProtocol::crc16 (std::uint8_t const *data, std::size_t size)
+{
+  std::uint16_t crc = 0xffff;
+  for (auto index = 0u; index < size; ++index)
+    {
+      crc ^= static_cast<std::uint16_t> (data[index] << 8);
+      for (auto bit = 0; bit < 8; ++bit)
+        crc = static_cast<std::uint16_t> (crc & 0x8000 ? (crc << 1) ^ 0x1021
+                                                       : crc << 1);
+    }
+  return crc;
+}
+
+std::size_t
+ControllerProtocol::cobsEncode (std::uint8_t const *data, std::size_t size,
+                                std::uint8_t *output)
+{
+  std::size_t indexCode = 0;
+  std::size_t indexOutput = 1;
+  std::uint8_t code = 1;
+  for (auto index = 0u; index < size; ++index)
+    {
+      if (data[index] == 0)
+        {
+          output[indexCode] = code;
+          indexCode = indexOutput++;
+          code = 1;
+          continue;
+        }
+
+      output[indexOutput++] = data[index];
+      if (++code == 0xff)
+        {
+          output[indexCode] = code;
+          indexCode = indexOutput++;
+          code = 1;
+        }
+    }
+  output[indexCode] = code;
+  return indexOutput;
+}
+
+std::optional<std::size_t>
+ControllerProtocol::cobsDecode (std::uint8_t const *data, std::size_t size,
+                                std::uint8_t *output)
+{
+  std::size_t indexInput = 0;
+  std::size_t indexOutput = 0;
+  while (indexInput < size)
+    {
+      auto const code = data[indexInput++];
+      if (code == 0 || indexInput + code - 1u > size)
+        return std::nullopt;
+
+      for (auto count = 1; count < code; ++count)
+        {
+          if (data[indexInput] == 0)
+            return std::nullopt;
+          output[indexOutput++] = data[indexInput++];
+        }
+
+      // a full block is not followed by a zero
+      if (code != 0xff && indexInput < size)
+        output[indexOutput++] = 0;
+    }
+  return indexOutput;
+}
+
+int
+ControllerProtocol::getNumPacketsDropped () const
+{
+  return _numPacketsDropped;
+}
+
+std::optional<Packet>
+ControllerProtocol::decodeFrame ()
+{
+  auto const size = cobsDecode (_frame.data (), _frameLength, _packet.data ());
+  if (!size.has_value ())
+    return std::nullopt;
+
+  return decodePacket (_packet.data (), *size);
+}
+
+}
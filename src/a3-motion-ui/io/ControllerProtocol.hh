@@ -0,0 +1,185 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <unistd.h>
+
+namespace a3
+{
+
+/* Binary protocol of the V3 controller. A packet consists of
+ *
+ *   version (1) | type (1) | payload (0..48) | crc (2)
+ *
+ * where the CRC-16/CCITT-FALSE covers version, type and payload and
+ * multi-byte values are little endian. Packets are COBS encoded and
+ * terminated by a zero byte, so the receiver resynchronizes at the
+ * next zero after lost or corrupted bytes. Packets with a different
+ * version are dropped like corrupted ones.
+ *
+ * Instances split a byte stream into packets, without allocating.
+ */
+class ControllerProtocol
+{
+public:
+  static constexpr std::uint8_t version = 1;
+
+  enum class PacketType : std::uint8_t
+  {
+    // controller to host
+    Button = 0x01,           // index, pressed
+    EncoderPress = 0x02,     // index, pressed
+    EncoderIncrement = 0x03, // index, increment (int8)
+    Pot = 0x04,              // index, value (uint16, 0..potMaxValue)
+    Tap = 0x05,              // time in microseconds (uint64)
+
+    // host to controller
+    PadLEDFrame = 0x81, // red, green, blue for all pads
+    ButtonLEDs = 0x82,  // bits 0..2: record, tap, shift LED
+  };
+
+  // Button indices 0..15 are the pads, followed by the buttons in the
+  // same order as in the V2 protocol.
+  static constexpr int numPads = 16;
+  static constexpr int numButtons = numPads + 3;
+  static constexpr int numButtonLEDs = numButtons - numPads;
+  static constexpr int numEncoders = 4;
+  static constexpr int numPots = 8;
+  static constexpr int potMaxValue = 1023;
+
+  static constexpr std::size_t maxPayloadSize = 3 * numPads;
+  static constexpr std::size_t maxPacketSize = maxPayloadSize + 4;
+  // COBS adds one byte per 254 bytes plus the delimiter
+  static constexpr std::size_t maxFrameSize
+      = maxPacketSize + maxPacketSize / 254 + 2;
+  static constexpr std::size_t readBufferSize = 256;
+
+  struct Packet
+  {
+    PacketType type;
+    std::size_t payloadSize = 0;
+    std::array<std::uint8_t, maxPayloadSize> payload{};
+  };
+
+  using Frame = std::array<std::uint8_t, maxFrameSize>;
+
+  static Packet makeButton (int index, bool pressed);
+  static Packet makeEncoderPress (int index, bool pressed);
+  static Packet makeEncoderIncrement (int index, int increment);
+  static Packet makePot (int index, int value);
+  static Packet makeTap (std::uint64_t timeMicros);
+  static Packet makeButtonLEDs (std::uint8_t mask);
+  // 'rgb' holds numPads red, green, blue triplets
+  static Packet makePadLEDFrame (std::uint8_t const *rgb);
+
+  static std::uint16_t readUint16 (std::uint8_t const *data);
+  static std::uint64_t readUint64 (std::uint8_t const *data);
+
+  // Encodes the packet including the delimiter, returns the frame size.
+  static std::size_t encodeFrame (Packet const &packet, Frame &frame);
+
+  // Checks version, CRC, payload size and value ranges of a COBS
+  // decoded packet.
+  static std::optional<Packet> decodePacket (std::uint8_t const *data,
+                                             std::size_t size);
+
+  static std::uint16_t crc16 (std::uint8_t const *data, std::size_t size);
+  // 'output' needs room for size + size / 254 + 1 bytes.
+  static std::size_t cobsEncode (std::uint8_t const *data, std::size_t size,
+                                 std::uint8_t *output);
+  // 'output' needs room for size bytes, returns nothing for invalid
+  // input.
+  static std::optional<std::size_t> cobsDecode (std::uint8_t const *data,
+                                                std::size_t size,
+                                                std::uint8_t *output);
+
+  // Splits the bytes into frames and calls handler (Packet const &)
+  // for every valid packet. Incomplete frames are kept for the next
+  // call.
+  template <typename HandlerT>
+  void
+  feed (std::uint8_t const *bytes, std::size_t size, HandlerT &&handler)
+  {
+    for (auto index = 0u; index < size; ++index)
+      {
+        auto const byte = bytes[index];
+        if (byte == 0)
+          {
+            if (!_discarding && _frameLength > 0)
+              {
+                auto const packet = decodeFrame ();
+                if (packet.has_value ())
+                  handler (*packet);
+                else
+                  ++_numPacketsDropped;
+              }
+            _frameLength = 0;
+            _discarding = false;
+          }
+        else if (_discarding)
+          {
+            continue;
+          }
+        else if (_frameLength < _frame.size ())
+          {
+            _frame[_frameLength++] = byte;
+          }
+        else
+          {
+            _discarding = true;
+            ++_numPacketsDropped;
+          }
+      }
+  }
+
+  // Performs a single read () on the descriptor and feeds the bytes.
+  // Returns the result of read ().
+  template <typename HandlerT>
+  ssize_t
+  readFrom (int fd, HandlerT &&handler)
+  {
+    auto const result = ::read (fd, _readBuffer.data (), _readBuffer.size ());
+    if (result > 0)
+      feed (_readBuffer.data (), static_cast<std::size_t> (result), handler);
+    return result;
+  }
+
+  // number of corrupted, overlong or incompatible packets
+  int getNumPacketsDropped () const;
+
+private:
+  std::optional<Packet> decodeFrame ();
+
+  std::array<std::uint8_t, readBufferSize> _readBuffer;
+  // encoded frame without the delimiter
+  std::array<std::uint8_t, maxFrameSize> _frame;
+  std::array<std::uint8_t, maxFrameSize> _packet;
+  std::size_t _frameLength = 0;
+  bool _discarding = false;
+  int _numPacketsDropped = 0;
+};
+
+}
@@ -20,87 +20,136 @@
 
 #include "InputOutputAdapter.hh"
 
-#include <memory>
-
-#include <a3-motion-ui/Helpers.hh>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#if JUCE_LINUX
+#include <sys/eventfd.h>
+#endif
 
 namespace a3
 {
 
-InputOutputAdapter::InputOutputAdapter () : juce::Thread ("InputOutputAdapter")
+namespace
 {
-  for (auto &buttonLED : _valueButtonLEDs)
-    buttonLED.addListener (this);
-  for (auto &channelLEDs : _valuePadLEDs)
-    for (auto &padLED : channelLEDs)
-      padLED.addListener (this);
-
-  startTimer (1);
-}
 
-InputOutputAdapter::~InputOutputAdapter ()
+juce::Colour
+renderPadLED (InputOutputAdapter::PadLED const &led, float phase)
 {
-  for (auto &channelLEDs : _valuePadLEDs)
-    for (auto &padLED : channelLEDs)
-      padLED.removeListener (this);
-  for (auto &valueLED : _valueButtonLEDs)
-    valueLED.removeListener (this);
+  using Animation = InputOutputAdapter::PadLED::Animation;
+  auto const cycle = phase - std::floor (phase);
+  switch (led.animation)
+    {
+    case Animation::None:
+      break;
+    case Animation::Blink:
+      return cycle < .5f ? led.colour : led.colourAlternate;
+    case Animation::Pulse:
+      {
+        auto const amount
+            = .5f + .5f * std::cos (juce::MathConstants<float>::twoPi * cycle);
+        return led.colourAlternate.interpolatedWith (led.colour, amount);
+      }
+    }
+  return led.colour;
 }
 
-juce::Value &
-InputOutputAdapter::getButton (Button button)
-{
-  return _valueButtons[static_cast<size_t> (button)];
 }
 
-juce::Value &
-InputOutputAdapter::getButtonLED (Button button)
+InputOutputAdapter::InputOutputAdapter () : juce::Thread ("InputOutputAdapter")
 {
-  return _valueButtonLEDs[static_cast<size_t> (button)];
+#if JUCE_LINUX
+  _fdWakeUpRead = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  _fdWakeUpWrite = _fdWakeUpRead;
+#else
+  std::array<int, 2> fds;
+  if (pipe (fds.data ()) == 0)
+    {
+      for (auto fd : fds)
+        {
+          fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+          fcntl (fd, F_SETFD, FD_CLOEXEC);
+        }
+      _fdWakeUpRead = fds[0];
+      _fdWakeUpWrite = fds[1];
+    }
+#endif
+  jassert (_fdWakeUpRead >= 0);
+
+  addListener (this);
 }
 
-juce::Value &
-InputOutputAdapter::getPad (index_t channel, index_t pad)
+InputOutputAdapter::~InputOutputAdapter ()
 {
-  jassert (channel < numChannels);
-  jassert (pad < numPadsPerChannel);
-  return _valuePads[channel][pad];
+  // derived classes close the hardware, so the thread has to be
+  // stopped by then
+  jassert (!isThreadRunning ());
+  removeListener (this);
+  cancelPendingUpdate ();
+
+  if (_fdWakeUpWrite != _fdWakeUpRead)
+    close (_fdWakeUpWrite);
+  close (_fdWakeUpRead);
 }
 
-juce::Value &
-InputOutputAdapter::getPadLED (index_t channel, index_t pad)
+void
+InputOutputAdapter::setEventHandler (Event::Kind kind, Execution execution,
+                                     EventHandler handler)
 {
-  jassert (channel < numChannels);
-  jassert (pad < numPadsPerChannel);
-  return _valuePadLEDs[channel][pad];
+  jassert (!isThreadRunning ());
+  // button states are tracked in the order the message thread sees
+  // the events, see isButtonPressed
+  jassert (kind != Event::Kind::Button
+           || execution == Execution::MessageThread);
+
+  auto &route = _eventRoutes[static_cast<std::size_t> (kind)];
+  route.execution = execution;
+  route.handler = std::move (handler);
 }
 
-juce::Value &
-InputOutputAdapter::getEncoderPress (index_t channel)
+bool
+InputOutputAdapter::isButtonPressed (Button button) const
 {
-  jassert (channel < numChannels);
-  return _valueEncoderPresses[channel];
+  return _buttonsPressed[static_cast<std::size_t> (button)];
 }
 
-juce::Value &
-InputOutputAdapter::getEncoderIncrement (index_t channel)
+void
+InputOutputAdapter::setButtonLED (Button button, bool value)
 {
-  jassert (channel < numChannels);
-  return _valueEncoderIncrements[channel];
+  auto &buttonLED = _ledFrame.buttons[static_cast<std::size_t> (button)];
+  if (buttonLED == value)
+    return;
+
+  buttonLED = value;
+  _ledFrameChanged = true;
+  triggerAsyncUpdate ();
 }
 
-juce::Value &
-InputOutputAdapter::getPot (index_t channel, index_t pot)
+void
+InputOutputAdapter::setPadLED (index_t channel, index_t pad,
+                               PadLED const &led)
 {
   jassert (channel < numChannels);
-  jassert (pot < numPotsPerChannel);
-  return _valuePots[channel][pot];
+  jassert (pad < numPadsPerChannel);
+
+  auto &padLED = _ledFrame.pads[channel * numPadsPerChannel + pad];
+  if (padLED == led)
+    return;
+
+  padLED = led;
+  _ledFrameChanged = true;
+  triggerAsyncUpdate ();
 }
 
-juce::Value &
-InputOutputAdapter::getTapTimeMicros ()
+void
+InputOutputAdapter::setAnimationPhase (float phase)
 {
-  return _valueTapTimeMicros;
+  _animationPhase.store (phase, std::memory_order_relaxed);
 }
 
 index_t
@@ -130,19 +179,69 @@ InputOutputAdapter::getNumButtons ()
 void
 InputOutputAdapter::run ()
 {
-  while (true)
+  std::array<pollfd, 2> fds{};
+  auto &pollWakeUp = fds[0];
+  auto &pollInput = fds[1];
+  pollWakeUp.fd = _fdWakeUpRead;
+  pollWakeUp.events = POLLIN;
+  // poll ignores negative descriptors
+  pollInput.fd = getInputFileDescriptor ();
+  pollInput.events = POLLIN;
+
+  // LEDs set before the thread was started
+  auto timeoutMillis = compositeLEDs ();
+
+  while (!threadShouldExit ())
     {
-      if (threadShouldExit ())
-        break;
+      auto const result = poll (fds.data (), fds.size (), timeoutMillis);
+      if (result < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          juce::Logger::writeToLog (juce::String ("I/O thread poll failed: ")
+                                    + std::strerror (errno));
+          break;
+        }
+
+      if (pollInput.revents & (POLLERR | POLLHUP | POLLNVAL))
+        {
+          juce::Logger::writeToLog ("hardware input closed");
+          pollInput.fd = -1;
+        }
+      else if (pollInput.revents & POLLIN)
+        {
+          processInput ();
+        }
 
-      processInput ();
-      processOutput ();
+      if (pollWakeUp.revents & POLLIN)
+        {
+          // reset the eventfd counter or drain the pipe
+          std::array<std::uint64_t, 8> buffer;
+          while (read (_fdWakeUpRead, buffer.data (), sizeof (buffer)) > 0)
+            ;
+        }
 
-      auto constexpr sleepMs = 1;
-      juce::Thread::sleep (sleepMs);
+      submitValuesPending ();
+      timeoutMillis = compositeLEDs ();
     }
 }
 
+void
+InputOutputAdapter::exitSignalSent ()
+{
+  wakeUp ();
+}
+
+void
+InputOutputAdapter::wakeUp ()
+{
+  std::uint64_t const one = 1;
+  auto const written = write (_fdWakeUpWrite, &one, sizeof (one));
+  // a full pipe or eventfd counter is pending a wake-up anyways
+  juce::ignoreUnused (written);
+}
+
 void
 InputOutputAdapter::inputPadValue (PadIndex const &padIndex, bool value)
 {
@@ -151,11 +250,12 @@ InputOutputAdapter::inputPadValue (PadIndex const &padIndex, bool value)
 
   if (value != _lastPadValues[padIndex])
     {
-      auto message = std::make_unique<InputMessagePad> ();
-      message->event = value ? InputMessagePad::Event::Press
-                             : InputMessagePad::Event::Release;
-      message->padIndex = padIndex;
-      submitInputMessage (std::move (message));
+      Event event;
+      event.kind = Event::Kind::Pad;
+      event.channel = padIndex.channel;
+      event.index = padIndex.pad;
+      event.value = value ? 1.f : 0.f;
+      routeEvent (event);
 
       _lastPadValues[padIndex] = value;
     }
@@ -166,26 +266,39 @@ InputOutputAdapter::inputButtonValue (Button button, bool value)
 {
   if (value != _lastButtonValues[button])
     {
-      auto message = std::make_unique<InputMessageButton> ();
-      message->button = button;
-      message->event = value ? InputMessageButton::Event::Press
-                             : InputMessageButton::Event::Release;
-      submitInputMessage (std::move (message));
+      Event event;
+      event.kind = Event::Kind::Button;
+      event.index = static_cast<index_t> (button);
+      event.value = value ? 1.f : 0.f;
+      routeEvent (event);
 
       _lastButtonValues[button] = value;
     }
 }
 
 void
-InputOutputAdapter::inputEncoderEvent (index_t channel,
-                                       InputMessageEncoder::Event event)
+InputOutputAdapter::inputEncoderPress (index_t channel, bool value)
+{
+  jassert (channel < numChannels);
+
+  Event event;
+  event.kind = Event::Kind::EncoderPress;
+  event.channel = channel;
+  event.value = value ? 1.f : 0.f;
+  routeEvent (event);
+}
+
+void
+InputOutputAdapter::inputEncoderIncrement (index_t channel, int increment)
 {
   jassert (channel < numChannels);
+  jassert (increment == -1 || increment == 1);
 
-  auto message = std::make_unique<InputMessageEncoder> ();
-  message->event = event;
-  message->channel = channel;
-  submitInputMessage (std::move (message));
+  Event event;
+  event.kind = Event::Kind::EncoderIncrement;
+  event.channel = channel;
+  event.value = static_cast<float> (increment);
+  routeEvent (event);
 }
 
 void
@@ -195,238 +308,195 @@ InputOutputAdapter::inputPotValue (index_t channel, index_t pot, float value)
   jassert (pot < numPotsPerChannel);
   jassert (value >= 0 && value <= 1.f);
 
-  auto message = std::make_unique<InputMessagePot> ();
-  message->channel = channel;
-  message->pot = pot;
-  message->value = value;
-  submitInputMessage (std::move (message));
+  Event event;
+  event.kind = Event::Kind::Pot;
+  event.channel = channel;
+  event.index = pot;
+  event.value = value;
+  routeEvent (event);
 }
 
 void
 InputOutputAdapter::inputTapTime (juce::int64 timeMicros)
 {
-  auto message = std::make_unique<InputMessageTap> ();
-  message->timeMicros = timeMicros;
-  submitInputMessage (std::move (message));
+  Event event;
+  event.kind = Event::Kind::Tap;
+  event.timeMicros = timeMicros;
+  routeEvent (event);
 }
 
 void
-InputOutputAdapter::submitInputMessage (std::unique_ptr<InputMessage> message)
+InputOutputAdapter::routeEvent (Event const &event)
 {
-  jassert (_fifoAbstractInput.getFreeSpace () > 0);
-
-  const auto scope = _fifoAbstractInput.write (1);
-  jassert (scope.blockSize1 == 1);
-  jassert (scope.blockSize2 == 0);
-  jassert (scope.startIndex1 >= 0);
-
-  auto startIndex = static_cast<std::size_t> (scope.startIndex1);
-  _fifoInput[startIndex] = std::move (message);
+  auto const &route = _eventRoutes[static_cast<std::size_t> (event.kind)];
+  if (route.execution == Execution::IOThread)
+    {
+      if (route.handler)
+        route.handler (event);
+    }
+  else
+    {
+      submitEvent (event);
+      triggerAsyncUpdate ();
+    }
 }
 
 void
-InputOutputAdapter::timerCallback ()
+InputOutputAdapter::submitEvent (Event const &event)
 {
-  auto const ready = _fifoAbstractInput.getNumReady ();
-  const auto scope = _fifoAbstractInput.read (ready);
-
-  jassert (scope.blockSize1 + scope.blockSize2 == ready);
-
-  if (scope.blockSize1 > 0)
+  // a state behind a pending one of the same input has to wait as
+  // well, so the message thread sees them in order.
+  auto const slot = getSlotPending (event);
+  if (slot >= 0)
     {
-      for (int idx = scope.startIndex1;
-           idx < scope.startIndex1 + scope.blockSize1; ++idx)
+      auto &pending = _valuesPending[static_cast<std::size_t> (slot)];
+      auto const value = event.value > 0.f;
+      if (pending.numValues == 0)
         {
-          jassert (idx >= 0);
-          handleInputMessage (
-              std::move (_fifoInput[static_cast<std::size_t> (idx)]));
-        }
-    }
+          if (pushEvent (event))
+            return;
 
-  if (scope.blockSize2 > 0)
-    {
-      for (int idx = scope.startIndex2;
-           idx < scope.startIndex2 + scope.blockSize2; ++idx)
+          pending.valueNext = value;
+        }
+      // encoder presses are sent without checking for a change, a
+      // repeated state adds nothing to the pending ones
+      else if (value == pending.valueLast)
         {
-          jassert (idx >= 0);
-          handleInputMessage (
-              std::move (_fifoInput[static_cast<std::size_t> (idx)]));
+          return;
         }
-    }
-}
 
-void
-InputOutputAdapter::handleInputMessage (std::unique_ptr<InputMessage> message)
-{
-  switch (message->type)
-    {
-    case InputMessage::Type::Pad:
-      {
-        auto messagePad = dynamic_cast<InputMessagePad *> (message.get ());
-        jassert (messagePad != nullptr);
-        handlePad (*messagePad);
-        break;
-      }
-    case InputMessage::Type::Button:
-      {
-        auto messageButton
-            = dynamic_cast<InputMessageButton *> (message.get ());
-        jassert (messageButton != nullptr);
-        handleButton (*messageButton);
-        break;
-      }
-    case InputMessage::Type::Encoder:
-      {
-        auto messageEncoder
-            = dynamic_cast<InputMessageEncoder *> (message.get ());
-        jassert (messageEncoder != nullptr);
-        handleEncoder (*messageEncoder);
-        break;
-      }
-    case InputMessage::Type::Pot:
-      {
-        auto messagePot = dynamic_cast<InputMessagePot *> (message.get ());
-        jassert (messagePot != nullptr);
-        handlePot (*messagePot);
-        break;
-      }
-    case InputMessage::Type::Tap:
-      {
-        auto messageTap = dynamic_cast<InputMessageTap *> (message.get ());
-        jassert (messageTap != nullptr);
-        handleTap (*messageTap);
-        break;
-      }
+      pending.valueLast = value;
+      ++pending.numValues;
+      _hasValuesPending = true;
+      return;
     }
 
-  // freeing should happen automatically by leaving the scope
-  message = nullptr;
+  // pots send their position again with the next change, increments
+  // and taps are only meaningful when handled in time.
+  if (!pushEvent (event))
+    _numEventsDropped.fetch_add (1, std::memory_order_relaxed);
 }
 
-void
-InputOutputAdapter::handlePad (InputMessagePad const &message)
+bool
+InputOutputAdapter::pushEvent (Event const &event)
 {
-  _valuePads[message.padIndex.channel][message.padIndex.pad]
-      = message.event == InputMessagePad::Event::Press ? true : false;
-}
+  if (_fifoAbstractInput.getFreeSpace () == 0)
+    return false;
 
-void
-InputOutputAdapter::handleButton (InputMessageButton const &message)
-{
-  jassert (juce::MessageManager::getInstance ()->isThisTheMessageThread ());
+  const auto scope = _fifoAbstractInput.write (1);
+  jassert (scope.blockSize1 == 1);
+  jassert (scope.blockSize2 == 0);
+  jassert (scope.startIndex1 >= 0);
 
-  auto index = static_cast<size_t> (message.button);
-  _valueButtons[index]
-      = message.event == InputMessageButton::Event::Press ? true : false;
+  auto startIndex = static_cast<std::size_t> (scope.startIndex1);
+  _fifoInput[startIndex] = event;
+  return true;
 }
 
-void
-InputOutputAdapter::handleEncoder (InputMessageEncoder const &message)
+int
+InputOutputAdapter::getSlotPending (Event const &event)
 {
-  if (message.event == InputMessageEncoder::Event::Increment
-      || message.event == InputMessageEncoder::Event::Decrement)
+  switch (event.kind)
     {
-      auto offset
-          = message.event == InputMessageEncoder::Event::Increment ? 1 : -1;
-
-      auto value = _valueEncoderIncrements[message.channel];
-
-      // The following is required to send the same increment
-      // repeatedly. juce::Value notifies observers only when the
-      // actual value changes.
-      if (value.getValue ().isInt ()
-          && static_cast<int> (value.getValue ()) == offset)
-        {
-          // last value was 'offset' -> notify observers manually
-          value.getValueSource ().sendChangeMessage (true);
-        }
-      else
-        {
-          // if value was not 'offset' -> assignment triggers notification
-          value = offset;
-        }
-    }
-  else if (message.event == InputMessageEncoder::Event::Press
-           || message.event == InputMessageEncoder::Event::Release)
-    {
-      auto value = _valueEncoderPresses[message.channel];
-      value = message.event == InputMessageEncoder::Event::Press ? 1 : 0;
+    case Event::Kind::Button:
+      return int (event.index);
+    case Event::Kind::Pad:
+      return int (numButtons + event.channel * numPadsPerChannel
+                  + event.index);
+    case Event::Kind::EncoderPress:
+      return int (numButtons + numPads + event.channel);
+    case Event::Kind::EncoderIncrement:
+    case Event::Kind::Pot:
+    case Event::Kind::Tap:
+      break;
     }
+  return -1;
 }
 
-void
-InputOutputAdapter::handlePot (InputMessagePot const &message)
-{
-  _valuePots[message.channel][message.pot] = message.value;
-}
-
-void
-InputOutputAdapter::handleTap (InputMessageTap const &message)
+InputOutputAdapter::Event
+InputOutputAdapter::getEventPending (std::size_t slot)
 {
-  auto &value = _valueTapTimeMicros;
-  if (value.getValue ().isInt64 ()
-      && static_cast<juce::int64> (value.getValue ()) == message.timeMicros)
+  Event event;
+  if (slot < numButtons)
     {
-      value.getValueSource ().sendChangeMessage (true);
+      event.kind = Event::Kind::Button;
+      event.index = index_t (slot);
+    }
+  else if (slot < numButtons + numPads)
+    {
+      auto const pad = index_t (slot - numButtons);
+      event.kind = Event::Kind::Pad;
+      event.channel = pad / numPadsPerChannel;
+      event.index = pad % numPadsPerChannel;
     }
   else
     {
-      value = message.timeMicros;
+      event.kind = Event::Kind::EncoderPress;
+      event.channel = index_t (slot - numButtons - numPads);
     }
+  return event;
 }
 
 void
-InputOutputAdapter::valueChanged (juce::Value &value)
+InputOutputAdapter::submitValuesPending ()
 {
-  for (auto index = 0u; index < numButtons; ++index)
-    {
-      if (value.refersToSameSourceAs (_valueButtonLEDs[index]))
-        {
-          auto message = std::make_unique<OutputMessageButtonLED> ();
-          message->button = static_cast<Button> (index);
-          message->value = value.getValue ();
-          submitOutputMessage (std::move (message));
-          return;
-        }
-    }
-  for (auto channel = 0u; channel < numChannels; ++channel)
+  if (!_hasValuesPending)
+    return;
+
+  auto numSubmitted = 0;
+  auto hasValuesPending = false;
+  for (auto slot = 0u; slot < numSlotsPending; ++slot)
     {
-      for (auto pad = 0u; pad < numPadsPerChannel; ++pad)
+      auto &pending = _valuesPending[slot];
+      while (pending.numValues > 0)
         {
-          if (value.refersToSameSourceAs (_valuePadLEDs[channel][pad]))
+          auto event = getEventPending (slot);
+          event.value = pending.valueNext ? 1.f : 0.f;
+          if (!pushEvent (event))
             {
-              auto message = std::make_unique<OutputMessagePadLED> ();
-              message->padIndex.channel = channel;
-              message->padIndex.pad = pad;
-              message->colour = juce::VariantConverter<juce::Colour>::fromVar (
-                  value.getValue ());
-              submitOutputMessage (std::move (message));
-              return;
+              hasValuesPending = true;
+              break;
             }
+
+          pending.valueNext = !pending.valueNext;
+          --pending.numValues;
+          ++numSubmitted;
         }
     }
+  _hasValuesPending = hasValuesPending;
+
+  if (numSubmitted > 0)
+    triggerAsyncUpdate ();
 }
 
 void
-InputOutputAdapter::submitOutputMessage (
-    std::unique_ptr<OutputMessage> message)
+InputOutputAdapter::handleAsyncUpdate ()
 {
-  jassert (_fifoAbstractOutput.getFreeSpace () > 0);
+  publishLEDs ();
 
-  const auto scope = _fifoAbstractOutput.write (1);
-  jassert (scope.blockSize1 == 1);
-  jassert (scope.blockSize2 == 0);
-  jassert (scope.startIndex1 >= 0);
+  auto const numEventsDropped
+      = _numEventsDropped.load (std::memory_order_relaxed);
+  if (numEventsDropped != _numEventsDroppedLogged)
+    {
+      juce::Logger::writeToLog ("input FIFO full, dropped "
+                                + juce::String (numEventsDropped)
+                                + " events in total");
+      _numEventsDroppedLogged = numEventsDropped;
+    }
 
-  auto startIndex = static_cast<std::size_t> (scope.startIndex1);
-  _fifoOutput[startIndex] = std::move (message);
+  dispatchEvents ();
+
+  // the I/O thread submits pending button and pad states now that
+  // there is room in the FIFO
+  if (_hasValuesPending)
+    wakeUp ();
 }
 
 void
-InputOutputAdapter::processOutput ()
+InputOutputAdapter::dispatchEvents ()
 {
-  auto const ready = _fifoAbstractOutput.getNumReady ();
-  const auto scope = _fifoAbstractOutput.read (ready);
+  auto const ready = _fifoAbstractInput.getNumReady ();
+  const auto scope = _fifoAbstractInput.read (ready);
 
   jassert (scope.blockSize1 + scope.blockSize2 == ready);
 
@@ -436,8 +506,7 @@ InputOutputAdapter::processOutput ()
            idx < scope.startIndex1 + scope.blockSize1; ++idx)
         {
           jassert (idx >= 0);
-          handleOutputMessage (
-              std::move (_fifoOutput[static_cast<std::size_t> (idx)]));
+          dispatchEvent (_fifoInput[static_cast<std::size_t> (idx)]);
         }
     }
 
@@ -447,36 +516,92 @@ InputOutputAdapter::processOutput ()
            idx < scope.startIndex2 + scope.blockSize2; ++idx)
         {
           jassert (idx >= 0);
-          handleOutputMessage (
-              std::move (_fifoOutput[static_cast<std::size_t> (idx)]));
+          dispatchEvent (_fifoInput[static_cast<std::size_t> (idx)]);
         }
     }
 }
 
 void
-InputOutputAdapter::handleOutputMessage (
-    std::unique_ptr<OutputMessage> message)
+InputOutputAdapter::dispatchEvent (Event const &event)
 {
-  switch (message->type)
+  jassert (juce::MessageManager::getInstance ()->isThisTheMessageThread ());
+
+  if (event.kind == Event::Kind::Button)
     {
-    case OutputMessage::Type::ButtonLED:
-      {
-        auto messageButtonLED
-            = dynamic_cast<OutputMessageButtonLED *> (message.get ());
-        jassert (messageButtonLED != nullptr);
-        outputButtonLED (messageButtonLED->button, messageButtonLED->value);
-        break;
-      }
-    case OutputMessage::Type::PadLED:
-      {
-        auto messagePadLED
-            = dynamic_cast<OutputMessagePadLED *> (message.get ());
-        jassert (messagePadLED != nullptr);
-        outputPadLED (messagePadLED->padIndex, messagePadLED->colour);
-        break;
-      }
+      jassert (event.index < numButtons);
+      _buttonsPressed[event.index] = event.value > 0.f;
     }
 
-  message = nullptr;
+  auto const &route = _eventRoutes[static_cast<std::size_t> (event.kind)];
+  if (route.handler)
+    route.handler (event);
 }
+
+void
+InputOutputAdapter::publishLEDs ()
+{
+  if (!_ledFrameChanged)
+    return;
+
+  _ledFrames.getWriteBuffer () = _ledFrame;
+  _ledFrames.publish ();
+  _ledFrameChanged = false;
+  wakeUp ();
+}
+
+int
+InputOutputAdapter::compositeLEDs ()
+{
+  if (_ledFrames.update ())
+    _ledFramePending = true;
+
+  auto const &frame = _ledFrames.getReadBuffer ();
+  auto const animated
+      = std::any_of (frame.pads.begin (), frame.pads.end (), [] (auto &led) {
+          return led.animation != PadLED::Animation::None;
+        });
+  if (!_ledFramePending && !animated)
+    return -1;
+
+  // rate limit, changes within a frame period are sent together
+  auto constexpr framePeriodMillis = 1000.0 / ledFrameRate;
+  auto const now = juce::Time::getMillisecondCounterHiRes ();
+  auto const elapsedMillis = now - _timeCompositedMillis;
+  if (elapsedMillis < framePeriodMillis)
+    return static_cast<int> (std::ceil (framePeriodMillis - elapsedMillis));
+  _timeCompositedMillis = now;
+
+  auto const phase = _animationPhase.load (std::memory_order_relaxed);
+  auto changed = false;
+  for (auto index = 0u; index < numPads; ++index)
+    {
+      auto const colour = renderPadLED (frame.pads[index], phase);
+      if (_ledsSent && colour == _padColoursSent[index])
+        continue;
+
+      outputPadLED ({ index / numPadsPerChannel, index % numPadsPerChannel },
+                    colour);
+      _padColoursSent[index] = colour;
+      changed = true;
+    }
+
+  for (auto index = 0u; index < numButtons; ++index)
+    {
+      auto const value = frame.buttons[index];
+      if (_ledsSent && value == _buttonLEDsSent[index])
+        continue;
+
+      outputButtonLED (static_cast<Button> (index), value);
+      _buttonLEDsSent[index] = value;
+      changed = true;
+    }
+
+  if (changed)
+    flushOutput ();
+  _ledsSent = true;
+  _ledFramePending = false;
+
+  return animated ? static_cast<int> (std::ceil (framePeriodMillis)) : -1;
+}
+
 }
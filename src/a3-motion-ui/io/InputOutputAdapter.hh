@@ -20,16 +20,31 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <JuceHeader.h>
 
+#include <a3-motion-engine/util/TripleBuffer.hh>
 #include <a3-motion-engine/util/Types.hh>
 
 namespace a3
 {
 
+/* The I/O thread sleeps in poll () until the hardware has input, the
+ * LED framebuffer changed or the next frame of an LED animation is
+ * due. It is woken up for the framebuffer through an eventfd (a pipe
+ * on non-Linux systems). Events for the message thread are delivered
+ * via an AsyncUpdater. When its FIFO is full, the changes of button,
+ * pad and encoder press states are counted and submitted once the
+ * message thread made room, the other events are dropped.
+ *
+ * The message thread writes LEDs to the framebuffer freely. The I/O
+ * thread composites it at no more than ledFrameRate and only sends
+ * the LEDs that differ from the last frame sent.
+ */
 class InputOutputAdapter : public juce::Thread,
-                           public juce::Timer,
-                           public juce::Value::Listener
+                           public juce::Thread::Listener,
+                           public juce::AsyncUpdater
 {
 public:
   enum class Button
@@ -39,222 +54,225 @@ public:
     Shift,
   };
 
-  InputOutputAdapter ();
-  virtual ~InputOutputAdapter ();
-
-  juce::Value &getButton (Button button);
-  juce::Value &getButtonLED (Button button);
-  juce::Value &getPad (index_t channel, index_t pad);
-  juce::Value &getPadLED (index_t channel, index_t pad);
-  juce::Value &getEncoderPress (index_t channel);
-  juce::Value &getEncoderIncrement (index_t channel);
-  juce::Value &getPot (index_t channel, index_t pot);
-  juce::Value &getTapTimeMicros ();
-
-  void valueChanged (juce::Value &) override;
-  void run () override;
-  void timerCallback () override;
-
-  // these might become virtual and be implemented by the specific
-  // hardware interface later on.
-  index_t getNumChannels ();
-  index_t getNumPadsPerChannel ();
-  index_t getNumPotsPerChannel ();
-  index_t getNumButtons ();
-
-protected:
-  static auto constexpr numChannels = 4u;
-  static auto constexpr numPadsPerChannel = 4u;
-  static auto constexpr numPotsPerChannel = 2u;
-  static auto constexpr numButtons = 3u;
-
-  struct PadIndex
-  {
-    index_t channel;
-    index_t pad;
-
-    friend bool
-    operator< (const PadIndex &lhs, const PadIndex &rhs)
-    {
-      return std::tie (lhs.channel, lhs.pad) < std::tie (rhs.channel, rhs.pad);
-    }
-  };
-
-  struct InputMessage
+  /* Hardware input event. 'index' is the pad, pot or button index
+   * and 'value' holds the pressed state as 0 / 1, the encoder
+   * increment as -1 / 1 or the normalized pot position.
+   */
+  struct Event
   {
-    virtual ~InputMessage (){};
-
-    enum class Type
+    enum class Kind
     {
       Pad,
       Button,
-      Encoder,
+      EncoderPress,
+      EncoderIncrement,
       Pot,
       Tap,
     };
-
-    Type type;
+    static constexpr auto numKinds = 6u;
+
+    Kind kind;
+    index_t channel = 0;
+    index_t index = 0;
+    float value = 0.f;
+    // tap events only, in microseconds of the hardware clock
+    juce::int64 timeMicros = 0;
   };
+  using EventHandler = std::function<void (Event const &)>;
 
-  struct InputMessageButton : public InputMessage
+  /* Pad LED in the framebuffer. Blinking switches from colour to
+   * colourAlternate halfway through each animation cycle, pulsing
+   * fades between the two.
+   */
+  struct PadLED
   {
-    InputMessageButton ()
+    enum class Animation
     {
-      type = Type::Button;
-    }
-
-    enum class Event
-    {
-      Press,
-      Release,
-    } event;
+      None,
+      Blink,
+      Pulse,
+    };
 
-    Button button;
-  };
+    juce::Colour colour;
+    juce::Colour colourAlternate;
+    Animation animation = Animation::None;
 
-  struct InputMessagePad : public InputMessage
-  {
-    InputMessagePad ()
+    friend bool
+    operator== (PadLED const &lhs, PadLED const &rhs)
     {
-      type = Type::Pad;
+      return lhs.colour == rhs.colour
+             && lhs.colourAlternate == rhs.colourAlternate
+             && lhs.animation == rhs.animation;
     }
-
-    enum class Event
-    {
-      Press,
-      Release,
-    } event;
-
-    PadIndex padIndex;
   };
 
-  struct InputMessageEncoder : public InputMessage
-  {
-    InputMessageEncoder ()
-    {
-      type = Type::Encoder;
-    }
+  static constexpr auto ledFrameRate = 60;
 
-    enum class Event
-    {
-      Press,
-      Release,
-      Increment,
-      Decrement,
-    } event;
-
-    index_t channel;
-  };
-
-  struct InputMessagePot : public InputMessage
+  enum class Execution
   {
-    InputMessagePot ()
-    {
-      type = Type::Pot;
-    }
-
-    index_t channel;
-    index_t pot;
-    float value;
+    // called directly from the I/O thread, handlers must not block
+    IOThread,
+    MessageThread,
   };
 
-  struct InputMessageTap : public InputMessage
-  {
-    InputMessageTap ()
-    {
-      type = Type::Tap;
-    }
+  InputOutputAdapter ();
+  virtual ~InputOutputAdapter ();
 
-    juce::int64 timeMicros;
-  };
+  // Routes all events of one kind to the given handler, replacing a
+  // previously set one. Handlers have to be set before the thread is
+  // started.
+  void setEventHandler (Event::Kind kind, Execution execution,
+                        EventHandler handler);
 
-  struct OutputMessage
-  {
-    virtual ~OutputMessage (){};
+  // button state as of the last button event dispatched on the
+  // message thread.
+  bool isButtonPressed (Button button) const;
 
-    enum class Type
-    {
-      ButtonLED,
-      PadLED
-    };
+  // LED framebuffer, written by the message thread only
+  void setButtonLED (Button button, bool value);
+  void setPadLED (index_t channel, index_t pad, PadLED const &led);
 
-    Type type;
-  };
+  // Position in the LED animations as a count of cycles, e.g. in 8th
+  // notes to blink with the tempo. Can be called from any thread.
+  void setAnimationPhase (float phase);
 
-  struct OutputMessageButtonLED : public OutputMessage
-  {
-    OutputMessageButtonLED ()
-    {
-      type = Type::ButtonLED;
-    }
+  void run () override;
+  void exitSignalSent () override;
+  void handleAsyncUpdate () override;
 
-    Button button;
-    bool value;
-  };
+  // these might become virtual and be implemented by the specific
+  // hardware interface later on.
+  index_t getNumChannels ();
+  index_t getNumPadsPerChannel ();
+  index_t getNumPotsPerChannel ();
+  index_t getNumButtons ();
+
+protected:
+  static auto constexpr numChannels = 4u;
+  static auto constexpr numPadsPerChannel = 4u;
+  static auto constexpr numPotsPerChannel = 2u;
+  static auto constexpr numButtons = 3u;
 
-  struct OutputMessagePadLED : public OutputMessage
+  struct PadIndex
   {
-    OutputMessagePadLED ()
+    index_t channel;
+    index_t pad;
+
+    friend bool
+    operator< (const PadIndex &lhs, const PadIndex &rhs)
     {
-      type = Type::PadLED;
+      return std::tie (lhs.channel, lhs.pad) < std::tie (rhs.channel, rhs.pad);
     }
-
-    PadIndex padIndex;
-    juce::Colour colour;
   };
 
   // called by the derived classes to read the specific hardware
   // interface and call the input* methods accordingly.
   virtual void processInput () = 0;
 
+  // the I/O thread calls processInput when this descriptor becomes
+  // readable, a negative value disables input.
+  virtual int getInputFileDescriptor () = 0;
+
   // input functions are called by the derived classes in the
   // InputOutputAdapter thread (this).
   void inputPadValue (PadIndex const &padIndex, bool value);
   void inputButtonValue (Button button, bool value);
-  void inputEncoderEvent (index_t channel, InputMessageEncoder::Event event);
+  void inputEncoderPress (index_t channel, bool value);
+  void inputEncoderIncrement (index_t channel, int increment);
   void inputPotValue (index_t channel, index_t pot, float value);
   void inputTapTime (juce::int64 timeMicros);
 
   virtual void outputButtonLED (Button button, bool value) = 0;
   virtual void outputPadLED (PadIndex, juce::Colour colour) = 0;
+  // called after the output* calls of each composited frame, for
+  // interfaces that collect the LED state and send it in one go.
+  virtual void flushOutput () {}
 
 private:
-  void submitInputMessage (std::unique_ptr<InputMessage> message);
-  void handleInputMessage (std::unique_ptr<InputMessage> message);
-  void handlePad (InputMessagePad const &message);
-  void handleButton (InputMessageButton const &message);
-  void handleEncoder (InputMessageEncoder const &message);
-  void handlePot (InputMessagePot const &message);
-  void handleTap (InputMessageTap const &message);
-
-  void submitOutputMessage (std::unique_ptr<OutputMessage> message);
-  void processOutput ();
-  void handleOutputMessage (std::unique_ptr<OutputMessage> message);
+  void routeEvent (Event const &event);
+  void submitEvent (Event const &event);
+  // returns false if the FIFO is full
+  bool pushEvent (Event const &event);
+  // index into _valuesPending for events that carry a state, or -1
+  static int getSlotPending (Event const &event);
+  static Event getEventPending (std::size_t slot);
+  void submitValuesPending ();
+  // dispatches the events in the FIFO on the message thread
+  void dispatchEvents ();
+  void dispatchEvent (Event const &event);
+
+  struct EventRoute
+  {
+    Execution execution = Execution::MessageThread;
+    EventHandler handler;
+  };
+  std::array<EventRoute, Event::numKinds> _eventRoutes;
 
-  std::map<PadIndex, bool> _lastPadValues;
-  std::array<std::array<juce::Value, numPadsPerChannel>, numChannels>
-      _valuePads;
-  std::array<std::array<juce::Value, numPadsPerChannel>, numChannels>
-      _valuePadLEDs;
+  void wakeUp ();
+  void publishLEDs ();
+  // returns the poll timeout until the next frame is due
+  int compositeLEDs ();
 
+  // accessed by the I/O thread only
+  std::map<PadIndex, bool> _lastPadValues;
   std::map<Button, bool> _lastButtonValues;
-  std::array<juce::Value, numButtons> _valueButtons;
-  std::array<juce::Value, numButtons> _valueButtonLEDs;
-
-  std::map<int, bool> _lastEncoderPressValues;
-  std::array<juce::Value, numChannels> _valueEncoderPresses;
-  std::array<juce::Value, numChannels> _valueEncoderIncrements;
 
-  std::array<std::array<juce::Value, numPotsPerChannel>, numChannels>
-      _valuePots;
-
-  juce::Value _valueTapTimeMicros;
+  // accessed by the message thread only
+  std::array<bool, numButtons> _buttonsPressed{};
 
   static constexpr int fifoSize = 32;
   juce::AbstractFifo _fifoAbstractInput{ fifoSize };
-  std::array<std::unique_ptr<InputMessage>, fifoSize> _fifoInput;
-  juce::AbstractFifo _fifoAbstractOutput{ fifoSize };
-  std::array<std::unique_ptr<OutputMessage>, fifoSize> _fifoOutput;
+  std::array<Event, fifoSize> _fifoInput;
+
+  // Input events are dropped when the message thread falls behind,
+  // the count is logged from handleAsyncUpdate.
+  std::atomic<int> _numEventsDropped{ 0 };
+  int _numEventsDroppedLogged = 0;
+
+  static constexpr auto numPads = numChannels * numPadsPerChannel;
+
+  // Button, pad and encoder press states are never dropped. When
+  // they do not fit into the FIFO, the changes of the input are
+  // counted here, along with later ones to keep their order. As the
+  // states alternate, each press still reaches the message thread
+  // with its release. Accessed by the I/O thread only.
+  struct ValuesPending
+  {
+    // state of the next change to submit, the ones after it alternate
+    bool valueNext = false;
+    // state of the last change, i.e. the current one of the input
+    bool valueLast = false;
+    int numValues = 0;
+  };
+  static constexpr auto numSlotsPending = numButtons + numPads + numChannels;
+  std::array<ValuesPending, numSlotsPending> _valuesPending{};
+  // set by the I/O thread, the message thread wakes it up to submit
+  // the pending states after draining the FIFO
+  std::atomic<bool> _hasValuesPending{ false };
+  struct LEDFrame
+  {
+    std::array<PadLED, numPads> pads;
+    std::array<bool, numButtons> buttons{};
+  };
+
+  // framebuffer of the message thread, published from
+  // handleAsyncUpdate to coalesce changes
+  LEDFrame _ledFrame;
+  bool _ledFrameChanged = false;
+  TripleBuffer<LEDFrame> _ledFrames{ LEDFrame{} };
+  std::atomic<float> _animationPhase{ 0.f };
+
+  // accessed by the I/O thread only, the first frame is sent in full
+  bool _ledFramePending = true;
+  bool _ledsSent = false;
+  double _timeCompositedMillis = 0.0;
+  std::array<juce::Colour, numPads> _padColoursSent;
+  std::array<bool, numButtons> _buttonLEDsSent{};
+
+  // wakes the I/O thread for LED frames and on exit, both ends refer
+  // to the same eventfd on Linux
+  int _fdWakeUpRead = -1;
+  int _fdWakeUpWrite = -1;
 };
 
 }
@@ -20,6 +20,12 @@
 
 #include "InputOutputAdapterV2.hh"
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
 namespace a3
 {
 
@@ -52,47 +58,43 @@ InputOutputAdapterV2::serialInit ()
 void
 InputOutputAdapterV2::processInput ()
 {
-  char c;
-  auto const bytesReady = _serialPort.GetNumberOfBytesAvailable ();
-  for (auto readCount = 0; readCount < bytesReady; ++readCount)
-    {
-      _serialPort.ReadByte (c);
-      if (c == '\n')
-        {
-          auto line = juce::String (_serialBuffer.data (), _nextWriteOffset);
-          serialParseLine (line);
-          _nextWriteOffset = 0;
-          continue;
-        }
-      _serialBuffer[_nextWriteOffset++] = c;
-    }
+  auto const result = _serialParser.readFrom (
+      _serialPort.GetFileDescriptor (),
+      [this] (auto const &message) { handleSerialMessage (message); });
+
+  if (result < 0 && errno != EAGAIN && errno != EINTR)
+    juce::Logger::writeToLog ("serial read failed: "
+                              + juce::String (std::strerror (errno)));
 }
 
-void
-InputOutputAdapterV2::serialParseLine (juce::String line)
+int
+InputOutputAdapterV2::getInputFileDescriptor ()
 {
-  // juce::Logger::writeToLog (juce::String ("**** parsing line: ") + line);
-
-  auto const prefixButton = juce::String ("B");
-  auto const prefixEncoderPress = juce::String ("EB");
-  auto const prefixEncoderIncrement = juce::String ("Enc");
-  auto const prefixPot = juce::String ("P");
-  auto const delimiter = juce::String (":");
-
-  auto const value = line.fromFirstOccurrenceOf (delimiter, false, false)
-                         .upToFirstOccurrenceOf (delimiter, false, false)
-                         .getIntValue ();
+  return _serialPort.GetFileDescriptor ();
+}
 
-  if (line.startsWith (prefixButton))
+void
+InputOutputAdapterV2::handleSerialMessage (
+    SerialLineParser::Message const &message)
+{
+  static_assert (SerialLineParser::numPads
+                 == numChannels * numPadsPerChannel);
+  static_assert (SerialLineParser::numButtons
+                 == SerialLineParser::numPads + numButtons);
+  static_assert (SerialLineParser::numEncoders == numChannels);
+  static_assert (SerialLineParser::numPots
+                 == numChannels * numPotsPerChannel);
+
+  // the parser has checked the indices and values against the protocol
+  // limits, which match the adapter layout as asserted above.
+  auto const index = static_cast<index_t> (message.index);
+  auto const value = message.value;
+
+  using Type = SerialLineParser::Message::Type;
+  switch (message.type)
     {
-      auto const indexSigned
-          = line.substring (prefixButton.length ())
-                .upToFirstOccurrenceOf (delimiter, false, false)
-                .getIntValue ();
-      jassert (indexSigned >= 0);
-      auto const index = static_cast<index_t> (indexSigned);
-
-      if (index < 16)
+    case Type::Button:
+      if (index < SerialLineParser::numPads)
         {
           auto const channel = index % numChannels;
           auto const pad = index / numChannels;
@@ -108,92 +110,81 @@ InputOutputAdapterV2::serialParseLine (juce::String line)
             case 17:
               inputButtonValue (Button::Record, value);
               break;
-            case 18:
+            case SerialLineParser::indexButtonTap:
               inputButtonValue (Button::Tap, value);
-              if (value)
-                {
-                  auto const timeMicros
-                      = line.fromLastOccurrenceOf (delimiter, false, false)
-                            .getLargeIntValue ();
-                  inputTapTime (timeMicros);
-                }
+              if (value && message.timeMicros >= 0)
+                inputTapTime (message.timeMicros);
               break;
             }
         }
-    }
-  else if (line.startsWith (prefixEncoderPress))
-    {
-      auto const indexSigned
-          = line.substring (prefixEncoderPress.length ())
-                .upToFirstOccurrenceOf (delimiter, false, false)
-                .getIntValue ();
-      jassert (indexSigned >= 0);
-      auto const index = static_cast<index_t> (indexSigned);
-
-      if (value == 1)
-        inputEncoderEvent (index, InputMessageEncoder::Event::Press);
-      else if (value == 0)
-        inputEncoderEvent (index, InputMessageEncoder::Event::Release);
-    }
-  else if (line.startsWith (prefixEncoderIncrement))
-    {
-      auto const indexSigned
-          = line.substring (prefixEncoderIncrement.length ())
-                .upToFirstOccurrenceOf (delimiter, false, false)
-                .getIntValue ();
-      jassert (indexSigned >= 0);
-      auto const index = static_cast<index_t> (indexSigned);
-
-      if (value == 1)
-        inputEncoderEvent (index, InputMessageEncoder::Event::Increment);
-      else if (value == -1)
-        inputEncoderEvent (index, InputMessageEncoder::Event::Decrement);
-    }
-  else if (line.startsWith (prefixPot))
-    {
-      auto const indexSigned
-          = line.substring (prefixPot.length ())
-                .upToFirstOccurrenceOf (delimiter, false, false)
-                .getIntValue ();
-      jassert (indexSigned >= 0);
-      auto const index = static_cast<index_t> (indexSigned);
-
-      auto const channel = index % numChannels;
-      auto const pad = index / numChannels;
-      auto constexpr potMaxValue = 1023.f;
-      inputPotValue (channel, pad, value / potMaxValue);
+      break;
+    case Type::EncoderPress:
+      inputEncoderPress (index, value == 1);
+      break;
+    case Type::EncoderIncrement:
+      inputEncoderIncrement (index, value);
+      break;
+    case Type::Pot:
+      {
+        auto const channel = index % numChannels;
+        auto const pot = index / numChannels;
+        auto constexpr potMaxValue
+            = static_cast<float> (SerialLineParser::potMaxValue);
+        inputPotValue (channel, pot, value / potMaxValue);
+      }
+      break;
     }
 }
 
 void
 InputOutputAdapterV2::outputButtonLED (Button button, bool value)
 {
-  juce::String line = "BL,";
-  line += juce::String (static_cast<int> (button));
-  line += ",";
-  line += juce::String (static_cast<int> (value));
-  line += "\n";
-
-  // juce::Logger::writeToLog ("++++ sending: " + line);
-  _serialPort.Write (line.toStdString ());
+  appendOutputLine ("BL,%d,%d\n", static_cast<int> (button),
+                    static_cast<int> (value));
 }
 
 void
 InputOutputAdapterV2::outputPadLED (PadIndex padIndex, juce::Colour colour)
 {
-  juce::String line = "L,";
-  line += juce::String (
-      static_cast<int> (padIndex.channel + numChannels * padIndex.pad));
-  line += ",";
-  line += juce::String (colour.getRed ());
-  line += ",";
-  line += juce::String (colour.getGreen ());
-  line += ",";
-  line += juce::String (colour.getBlue ());
-  line += "\n";
-
-  // juce::Logger::writeToLog ("++++ sending: " + line);
-  _serialPort.Write (line.toStdString ());
+  appendOutputLine (
+      "L,%d,%d,%d,%d\n",
+      static_cast<int> (padIndex.channel + numChannels * padIndex.pad),
+      colour.getRed (), colour.getGreen (), colour.getBlue ());
+}
+
+template <typename... Args>
+void
+InputOutputAdapterV2::appendOutputLine (char const *format, Args... args)
+{
+  auto const available = _outputBuffer.size () - _outputLength;
+  auto const length = std::snprintf (_outputBuffer.data () + _outputLength,
+                                     available, format, args...);
+  // one frame of LED lines always fits
+  jassert (length > 0 && static_cast<std::size_t> (length) < available);
+  if (length > 0 && static_cast<std::size_t> (length) < available)
+    _outputLength += static_cast<std::size_t> (length);
+}
+
+void
+InputOutputAdapterV2::flushOutput ()
+{
+  auto const fd = _serialPort.GetFileDescriptor ();
+  auto offset = std::size_t (0);
+  while (offset < _outputLength)
+    {
+      auto const written
+          = write (fd, _outputBuffer.data () + offset, _outputLength - offset);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        {
+          juce::Logger::writeToLog ("serial write failed: "
+                                    + juce::String (std::strerror (errno)));
+          break;
+        }
+      offset += static_cast<std::size_t> (written);
+    }
+  _outputLength = 0;
 }
 
 }
@@ -23,6 +23,7 @@
 #include <libserial/SerialPort.h>
 
 #include <a3-motion-ui/io/InputOutputAdapter.hh>
+#include <a3-motion-ui/io/SerialLineParser.hh>
 
 namespace a3
 {
@@ -34,17 +35,23 @@ public:
   ~InputOutputAdapterV2 ();
 
   void processInput () override;
+  int getInputFileDescriptor () override;
   void outputButtonLED (Button button, bool value) override;
   void outputPadLED (PadIndex padIndex, juce::Colour colour) override;
+  void flushOutput () override;
 
 private:
   void serialInit ();
-  void serialParseLine (juce::String line);
+  void handleSerialMessage (SerialLineParser::Message const &message);
 
   LibSerial::SerialPort _serialPort;
-  static int constexpr serialBufferSize = 64;
-  std::array<char, serialBufferSize> _serialBuffer;
-  size_t _nextWriteOffset = 0;
+  SerialLineParser _serialParser;
+
+  // LED lines of one composited frame, written in one go
+  template <typename... Args>
+  void appendOutputLine (char const *format, Args... args);
+  std::array<char, 512> _outputBuffer;
+  std::size_t _outputLength = 0;
 };
 
 }
@@ -0,0 +1,222 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "InputOutputAdapterV3.hh"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace a3
+{
+
+InputOutputAdapterV3::InputOutputAdapterV3 () : InputOutputAdapter ()
+{
+  static_assert (ControllerProtocol::numPads
+                 == numChannels * numPadsPerChannel);
+  static_assert (ControllerProtocol::numButtonLEDs == numButtons);
+  static_assert (ControllerProtocol::numEncoders == numChannels);
+  static_assert (ControllerProtocol::numPots
+                 == numChannels * numPotsPerChannel);
+
+  serialInit ();
+}
+
+InputOutputAdapterV3::~InputOutputAdapterV3 ()
+{
+  _serialPort.Close ();
+}
+
+void
+InputOutputAdapterV3::serialInit ()
+{
+  using namespace LibSerial;
+
+  auto const serialDevice = juce::SystemStats::getEnvironmentVariable (
+      "A3_CONTROLLER_DEVICE", "/dev/ttyACM0");
+  _serialPort.Open (serialDevice.toStdString ());
+  _serialPort.SetBaudRate (BaudRate::BAUD_115200);
+  _serialPort.SetCharacterSize (CharacterSize::CHAR_SIZE_8);
+  _serialPort.SetFlowControl (FlowControl::FLOW_CONTROL_NONE);
+  _serialPort.SetParity (Parity::PARITY_NONE);
+  _serialPort.SetStopBits (StopBits::STOP_BITS_1);
+
+  juce::Logger::writeToLog ("initialized libserial on " + serialDevice
+                            + ", protocol version "
+                            + juce::String (ControllerProtocol::version));
+}
+
+void
+InputOutputAdapterV3::processInput ()
+{
+  auto const result = _protocol.readFrom (
+      _serialPort.GetFileDescriptor (),
+      [this] (auto const &packet) { handlePacket (packet); });
+
+  if (result < 0 && errno != EAGAIN && errno != EINTR)
+    juce::Logger::writeToLog ("serial read failed: "
+                              + juce::String (std::strerror (errno)));
+
+  auto const numPacketsDropped = _protocol.getNumPacketsDropped ();
+  if (numPacketsDropped != _numPacketsDroppedLogged)
+    {
+      juce::Logger::writeToLog (
+          "dropped " + juce::String (numPacketsDropped)
+          + " corrupted or incompatible controller packets");
+      _numPacketsDroppedLogged = numPacketsDropped;
+    }
+}
+
+int
+InputOutputAdapterV3::getInputFileDescriptor ()
+{
+  return _serialPort.GetFileDescriptor ();
+}
+
+void
+InputOutputAdapterV3::handlePacket (ControllerProtocol::Packet const &packet)
+{
+  // the protocol has checked the payload sizes and value ranges
+  auto const &payload = packet.payload;
+  auto const index = static_cast<index_t> (payload[0]);
+
+  using PacketType = ControllerProtocol::PacketType;
+  switch (packet.type)
+    {
+    case PacketType::Button:
+      if (index < ControllerProtocol::numPads)
+        {
+          auto const channel = index % numChannels;
+          auto const pad = index / numChannels;
+          inputPadValue ({ channel, pad }, payload[1] == 1);
+        }
+      else
+        {
+          switch (index)
+            {
+            case 16:
+              inputButtonValue (Button::Shift, payload[1] == 1);
+              break;
+            case 17:
+              inputButtonValue (Button::Record, payload[1] == 1);
+              break;
+            case 18:
+              inputButtonValue (Button::Tap, payload[1] == 1);
+              break;
+            }
+        }
+      break;
+    case PacketType::EncoderPress:
+      inputEncoderPress (index, payload[1] == 1);
+      break;
+    case PacketType::EncoderIncrement:
+      {
+        // the controller may accumulate several steps into one packet
+        auto const increment = static_cast<std::int8_t> (payload[1]);
+        auto const direction = increment > 0 ? 1 : -1;
+        for (auto step = 0; step < std::abs (increment); ++step)
+          inputEncoderIncrement (index, direction);
+      }
+      break;
+    case PacketType::Pot:
+      {
+        auto const channel = index % numChannels;
+        auto const pot = index / numChannels;
+        auto constexpr potMaxValue
+            = static_cast<float> (ControllerProtocol::potMaxValue);
+        auto const value = ControllerProtocol::readUint16 (&payload[1]);
+        inputPotValue (channel, pot, value / potMaxValue);
+      }
+      break;
+    case PacketType::Tap:
+      inputTapTime (static_cast<juce::int64> (
+          ControllerProtocol::readUint64 (payload.data ())));
+      break;
+    case PacketType::PadLEDFrame:
+    case PacketType::ButtonLEDs:
+      break;
+    }
+}
+
+void
+InputOutputAdapterV3::outputButtonLED (Button button, bool value)
+{
+  auto const bit = static_cast<std::uint8_t> (1
+                                              << static_cast<int> (button));
+  auto const buttonLEDs = static_cast<std::uint8_t> (
+      value ? _buttonLEDs | bit : _buttonLEDs & ~bit);
+
+  _buttonLEDsChanged |= buttonLEDs != _buttonLEDs;
+  _buttonLEDs = buttonLEDs;
+}
+
+void
+InputOutputAdapterV3::outputPadLED (PadIndex padIndex, juce::Colour colour)
+{
+  auto const offset = 3 * (padIndex.channel + numChannels * padIndex.pad);
+  std::array<std::uint8_t, 3> const rgb{ colour.getRed (),
+                                         colour.getGreen (),
+                                         colour.getBlue () };
+
+  for (auto component = 0u; component < rgb.size (); ++component)
+    {
+      _padLEDsChanged |= _padLEDs[offset + component] != rgb[component];
+      _padLEDs[offset + component] = rgb[component];
+    }
+}
+
+void
+InputOutputAdapterV3::flushOutput ()
+{
+  if (_padLEDsChanged)
+    sendPacket (ControllerProtocol::makePadLEDFrame (_padLEDs.data ()));
+  if (_buttonLEDsChanged)
+    sendPacket (ControllerProtocol::makeButtonLEDs (_buttonLEDs));
+
+  _padLEDsChanged = false;
+  _buttonLEDsChanged = false;
+}
+
+void
+InputOutputAdapterV3::sendPacket (ControllerProtocol::Packet const &packet)
+{
+  ControllerProtocol::Frame frame;
+  auto const size = ControllerProtocol::encodeFrame (packet, frame);
+
+  auto const fd = _serialPort.GetFileDescriptor ();
+  auto offset = std::size_t (0);
+  while (offset < size)
+    {
+      auto const written = write (fd, frame.data () + offset, size - offset);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        {
+          juce::Logger::writeToLog ("serial write failed: "
+                                    + juce::String (std::strerror (errno)));
+          return;
+        }
+      offset += static_cast<std::size_t> (written);
+    }
+}
+
+}
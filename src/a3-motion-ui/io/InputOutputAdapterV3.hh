@@ -0,0 +1,66 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <libserial/SerialPort.h>
+
+#include <a3-motion-ui/io/ControllerProtocol.hh>
+#include <a3-motion-ui/io/InputOutputAdapter.hh>
+
+namespace a3
+{
+
+/* Talks to the controller through the binary ControllerProtocol. LED
+ * changes are collected and sent once per composited LED frame, with
+ * all pad colours in a single packet.
+ *
+ * The device defaults to /dev/ttyACM0 and can be overridden through
+ * the A3_CONTROLLER_DEVICE environment variable, e.g. to connect to a
+ * simulated controller.
+ */
+class InputOutputAdapterV3 : public InputOutputAdapter
+{
+public:
+  InputOutputAdapterV3 ();
+  ~InputOutputAdapterV3 ();
+
+  void processInput () override;
+  int getInputFileDescriptor () override;
+  void outputButtonLED (Button button, bool value) override;
+  void outputPadLED (PadIndex padIndex, juce::Colour colour) override;
+  void flushOutput () override;
+
+private:
+  void serialInit ();
+  void handlePacket (ControllerProtocol::Packet const &packet);
+  void sendPacket (ControllerProtocol::Packet const &packet);
+
+  LibSerial::SerialPort _serialPort;
+  ControllerProtocol _protocol;
+  int _numPacketsDroppedLogged = 0;
+
+  std::array<std::uint8_t, ControllerProtocol::maxPayloadSize> _padLEDs{};
+  std::uint8_t _buttonLEDs = 0;
+  bool _padLEDsChanged = false;
+  bool _buttonLEDsChanged = false;
+};
+
+}
@@ -0,0 +1,123 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SerialLineParser.hh"
+
+#include <charconv>
+
+namespace a3
+{
+
+namespace
+{
+
+bool
+consumePrefix (std::string_view &text, std::string_view prefix)
+{
+  if (text.substr (0, prefix.size ()) != prefix)
+    return false;
+
+  text.remove_prefix (prefix.size ());
+  return true;
+}
+
+template <typename T>
+bool
+consumeNumber (std::string_view &text, T &number)
+{
+  auto const end = text.data () + text.size ();
+  auto const [next, error] = std::from_chars (text.data (), end, number);
+  if (error != std::errc ())
+    return false;
+
+  text.remove_prefix (static_cast<std::size_t> (next - text.data ()));
+  return true;
+}
+
+}
+
+std::optional<SerialLineParser::Message>
+SerialLineParser::parseLine (std::string_view line)
+{
+  if (!line.empty () && line.back () == '\r')
+    line.remove_suffix (1);
+
+  using Type = Message::Type;
+  Message message;
+  // "EB" has to be tested before "Enc", both before "B"
+  if (consumePrefix (line, "EB"))
+    message.type = Type::EncoderPress;
+  else if (consumePrefix (line, "Enc"))
+    message.type = Type::EncoderIncrement;
+  else if (consumePrefix (line, "B"))
+    message.type = Type::Button;
+  else if (consumePrefix (line, "P"))
+    message.type = Type::Pot;
+  else
+    return std::nullopt;
+
+  if (!consumeNumber (line, message.index) || !consumePrefix (line, ":")
+      || !consumeNumber (line, message.value))
+    return std::nullopt;
+
+  if (message.type == Type::Button && message.index == indexButtonTap
+      && consumePrefix (line, ":"))
+    {
+      if (!consumeNumber (line, message.timeMicros)
+          || message.timeMicros < 0)
+        return std::nullopt;
+    }
+
+  if (!line.empty ())
+    return std::nullopt;
+
+  auto const isPressValue = message.value == 0 || message.value == 1;
+  switch (message.type)
+    {
+    case Type::Button:
+      if (message.index < 0 || message.index >= numButtons || !isPressValue)
+        return std::nullopt;
+      break;
+    case Type::EncoderPress:
+      if (message.index < 0 || message.index >= numEncoders || !isPressValue)
+        return std::nullopt;
+      break;
+    case Type::EncoderIncrement:
+      if (message.index < 0 || message.index >= numEncoders
+          || (message.value != 1 && message.value != -1))
+        return std::nullopt;
+      break;
+    case Type::Pot:
+      if (message.index < 0 || message.index >= numPots || message.value < 0
+          || message.value > potMaxValue)
+        return std::nullopt;
+      break;
+    }
+
+  return message;
+}
+
+int
+SerialLineParser::getNumLinesDropped () const
+{
+  return _numLinesDropped;
+}
+
+}
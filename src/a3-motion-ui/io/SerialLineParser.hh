@@ -0,0 +1,141 @@
+/*
+
+  A3 Motion UI
+  Copyright (C) 2023 Patric Schmitz
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <unistd.h>
+
+namespace a3
+{
+
+/* Parser for the line based ASCII protocol of the V2 controller, e.g.
+ * "B12:1" (button / pad 12 pressed), "B18:1:<micros>" (tap with
+ * timestamp), "EB2:0" (encoder 2 released), "Enc2:-1" (encoder 2
+ * decremented) or "P3:812" (pot 3 at 812 of 1023).
+ *
+ * Bytes are read in bulk into a fixed buffer and split into lines of
+ * bounded length, longer lines are dropped as a whole. Lines are
+ * parsed in place, so the parser never allocates.
+ */
+class SerialLineParser
+{
+public:
+  struct Message
+  {
+    enum class Type
+    {
+      Button,
+      EncoderPress,
+      EncoderIncrement,
+      Pot,
+    } type;
+
+    int index = 0;
+    int value = 0;
+    // only sent with tap button presses, negative otherwise
+    std::int64_t timeMicros = -1;
+  };
+
+  // protocol limits of the V2 controller
+  static constexpr int numPads = 16;
+  static constexpr int numButtons = numPads + 3;
+  static constexpr int indexButtonTap = numPads + 2;
+  static constexpr int numEncoders = 4;
+  static constexpr int numPots = 8;
+  static constexpr int potMaxValue = 1023;
+
+  static constexpr std::size_t maxLineLength = 64;
+  static constexpr std::size_t readBufferSize = 256;
+
+  // Parses a single line without the terminating newline, a trailing
+  // carriage return is ignored.
+  static std::optional<Message> parseLine (std::string_view line);
+
+  // Splits the bytes into lines and calls handler (Message const &)
+  // for every valid one. Incomplete lines are kept for the next call.
+  template <typename HandlerT>
+  void
+  feed (std::string_view bytes, HandlerT &&handler)
+  {
+    for (auto const c : bytes)
+      {
+        if (c == '\n')
+          {
+            if (!_discarding && _lineLength > 0)
+              {
+                auto const message
+                    = parseLine ({ _line.data (), _lineLength });
+                if (message.has_value ())
+                  handler (*message);
+                else
+                  ++_numLinesDropped;
+              }
+            _lineLength = 0;
+            _discarding = false;
+          }
+        else if (_discarding)
+          {
+            continue;
+          }
+        else if (_lineLength < _line.size ())
+          {
+            _line[_lineLength++] = c;
+          }
+        else
+          {
+            _discarding = true;
+            ++_numLinesDropped;
+          }
+      }
+  }
+
+  // Performs a single read () on the descriptor and feeds the bytes.
+  // Returns the result of read (), i.e. 0 on end of file and -1 on
+  // errors with errno set.
+  template <typename HandlerT>
+  ssize_t
+  readFrom (int fd, HandlerT &&handler)
+  {
+    auto const result = ::read (fd, _readBuffer.data (), _readBuffer.size ());
+    if (result > 0)
+      feed ({ _readBuffer.data (), static_cast<std::size_t> (result) },
+            handler);
+    return result;
+  }
+
+  // number of malformed or overlong lines
+  int getNumLinesDropped () const;
+
+private:
+  std::array<char, readBufferSize> _readBuffer;
+  std::array<char, maxLineLength> _line;
+  std::size_t _lineLength = 0;
+  // set while skipping the rest of an overlong line
+  bool _discarding = false;
+  int _numLinesDropped = 0;
+};
+
+}
@@ -59,21 +59,27 @@ TempoEstimatorTest::TempoEstimatorTest ()
         _outTimings << ",";
     }
   _outTimings << std::endl;
+
+  // raw tap times can be replayed by a3-motion-benchmarks
+  _outTaps.open ("taps.csv");
 }
 
 TempoEstimatorTest::~TempoEstimatorTest ()
 {
   _outTimings.close ();
+  _outTaps.close ();
 }
 
 void
-TempoEstimatorTest::valueChanged (juce::Value &value)
+TempoEstimatorTest::tap (juce::int64 timeMicros)
 {
+  _outTaps << timeMicros << std::endl;
+
   bool writeNewLine = false;
   for (auto index = 0u; index < _vectorEstimatorTests.size (); ++index)
     {
       auto &estimatorTest = _vectorEstimatorTests[index];
-      if (estimatorTest.estimator->tap (value.getValue ())
+      if (estimatorTest.estimator->tap (timeMicros)
           == TempoEstimator::TapResult::TempoAvailable)
         {
           writeNewLine = true;
@@ -29,13 +29,13 @@ namespace a3
 
 class TempoEstimator;
 
-class TempoEstimatorTest : public juce::Value::Listener
+class TempoEstimatorTest
 {
 public:
   TempoEstimatorTest ();
   ~TempoEstimatorTest ();
 
-  void valueChanged (juce::Value &value) override;
+  void tap (juce::int64 timeMicros);
 
 private:
   struct EstimatorTest
@@ -46,6 +46,7 @@ private:
 
   std::vector<EstimatorTest> _vectorEstimatorTests;
   std::ofstream _outTimings;
+  std::ofstream _outTaps;
 };
 
 }